@@ -0,0 +1,111 @@
+#include <Bench.hpp>
+
+#include <depend/Base64.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using macaron::Base64;
+
+namespace {
+
+// The decoder as it was before the SIMD rewrite, including the substr() copy
+// loadBuffers used to make of the data: URI payload
+std::vector<uint8_t> legacyDecode(const std::string& uri, size_t pivot)
+{
+    static constexpr unsigned char kDecodingTable[] = {
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 62, 64, 64, 64, 63,
+        52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 64, 64, 64, 64, 64, 64,
+        64,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+        15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 64, 64, 64, 64, 64,
+        64, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+        41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 64, 64, 64, 64, 64,
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64
+    };
+
+    const std::string input = uri.substr(pivot + 1);
+
+    std::vector<uint8_t> out;
+
+    size_t in_len = input.size();
+    if (in_len % 4 != 0) return out;
+
+    size_t out_len = in_len / 4 * 3;
+    if (input[in_len - 1] == '=') out_len--;
+    if (input[in_len - 2] == '=') out_len--;
+
+    out.resize(out_len);
+
+    for (size_t i = 0, j = 0; i < in_len;) {
+        uint32_t a = input[i] == '=' ? 0 & i++ : kDecodingTable[static_cast<int>(input[i++])];
+        uint32_t b = input[i] == '=' ? 0 & i++ : kDecodingTable[static_cast<int>(input[i++])];
+        uint32_t c = input[i] == '=' ? 0 & i++ : kDecodingTable[static_cast<int>(input[i++])];
+        uint32_t d = input[i] == '=' ? 0 & i++ : kDecodingTable[static_cast<int>(input[i++])];
+
+        uint32_t triple = (a << 3 * 6) + (b << 2 * 6) + (c << 1 * 6) + (d << 0 * 6);
+
+        if (j < out_len) out[j++] = (triple >> 2 * 8) & 0xFF;
+        if (j < out_len) out[j++] = (triple >> 1 * 8) & 0xFF;
+        if (j < out_len) out[j++] = (triple >> 0 * 8) & 0xFF;
+    }
+
+    return out;
+}
+
+} // namespace
+
+void RunBase64Benchmarks(Bench& bench)
+{
+    const std::vector<std::pair<std::string, size_t>> sizes = {
+        { "1MB", 1024 * 1024 },
+        { "64MB", 64 * 1024 * 1024 },
+    };
+
+    for (const auto& [sizeName, size] : sizes) {
+        std::string data(size, '\0');
+        uint32_t state = 0x9E3779B9;
+        for (auto& c : data) {
+            state = state * 1664525u + 1013904223u;
+            c = (char)(state >> 24);
+        }
+
+        const std::string prefix = "data:application/octet-stream;base64,";
+        const std::string uri = prefix + Base64::Encode(data);
+        const size_t pivot = prefix.size() - 1;
+        const std::string_view payload = std::string_view(uri).substr(pivot + 1);
+
+        double bytes = (double)(uri.size() - prefix.size());
+
+        bench.Run("base64_decode/legacy/" + sizeName, [&]() {
+            auto out = legacyDecode(uri, pivot);
+        }, bytes);
+
+        std::vector<uint8_t> out(Base64::DecodedLength(payload));
+
+        const std::vector<std::pair<std::string, Base64::SIMD>> levels = {
+            { "scalar", Base64::SIMD::None },
+            { "ssse3", Base64::SIMD::SSSE3 },
+            { "avx2", Base64::SIMD::AVX2 },
+        };
+
+        for (const auto& [levelName, level] : levels) {
+            if (level > Base64::DetectSIMD()) {
+                continue;
+            }
+
+            bench.Run("base64_decode/" + levelName + "/" + sizeName, [&]() {
+                Base64::Decode(payload, out.data(), out.size(), level);
+            }, bytes);
+        }
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+struct BenchResult
+{
+    std::string Name;
+
+    // Milliseconds per iteration
+    std::vector<double> Samples;
+
+    // Bytes processed per iteration, used for throughput
+    double Bytes = 0.0;
+
+    // Extra values reported by the benchmark, e.g. peak memory
+    std::map<std::string, double> Counters;
+};
+
+class Bench
+{
+public:
+
+    inline Bench(int iterations, const std::string& filter)
+        : iterations_(iterations)
+        , filter_(filter)
+    { }
+
+    inline bool Enabled(const std::string& name) const {
+        return filter_.empty() || name.find(filter_) != std::string::npos;
+    }
+
+    // Runs fn once to warm up, then times it for every iteration
+    template <class Fn>
+    BenchResult * Run(const std::string& name, Fn&& fn, double bytes = 0.0)
+    {
+        using namespace std::chrono;
+
+        if (!Enabled(name)) {
+            return nullptr;
+        }
+
+        fn();
+
+        results_.push_back(BenchResult{ name, {}, bytes, {} });
+        auto& result = results_.back();
+
+        for (int i = 0; i < iterations_; ++i) {
+            auto start = high_resolution_clock::now();
+            fn();
+            auto end = high_resolution_clock::now();
+
+            result.Samples.push_back(duration<double, std::milli>(end - start).count());
+        }
+
+        printf("%-48s p50 %10.3f ms  p90 %10.3f ms  p99 %10.3f ms\n", name.c_str(),
+            Percentile(result.Samples, 50.0),
+            Percentile(result.Samples, 90.0),
+            Percentile(result.Samples, 99.0));
+        fflush(stdout);
+
+        return &result;
+    }
+
+    static inline double Percentile(std::vector<double> samples, double p)
+    {
+        if (samples.empty()) {
+            return 0.0;
+        }
+
+        std::sort(samples.begin(), samples.end());
+
+        size_t index = (size_t)((p / 100.0) * (samples.size() - 1) + 0.5);
+        return samples[std::min(index, samples.size() - 1)];
+    }
+
+    inline const std::vector<BenchResult>& GetResults() const {
+        return results_;
+    }
+
+    // One object per result with its percentiles in milliseconds, throughput
+    // when bytes are known and every counter, for tracking across releases
+    inline bool WriteJSON(const std::string& filename) const
+    {
+        FILE * file = fopen(filename.c_str(), "w");
+        if (!file) {
+            return false;
+        }
+
+        fprintf(file, "{\n  \"iterations\": %d,\n  \"results\": [", iterations_);
+
+        for (size_t i = 0; i < results_.size(); ++i) {
+            const auto& result = results_[i];
+            const auto& samples = result.Samples;
+
+            double mean = 0.0;
+            for (double sample : samples) {
+                mean += sample;
+            }
+            mean /= std::max<size_t>(samples.size(), 1);
+
+            double p50 = Percentile(samples, 50.0);
+
+            fprintf(file, "%s\n    {\n", (i > 0 ? "," : ""));
+            fprintf(file, "      \"name\": \"%s\",\n", result.Name.c_str());
+            fprintf(file, "      \"samples\": %zu,\n", samples.size());
+            fprintf(file, "      \"min_ms\": %.6f,\n", Percentile(samples, 0.0));
+            fprintf(file, "      \"mean_ms\": %.6f,\n", mean);
+            fprintf(file, "      \"p50_ms\": %.6f,\n", p50);
+            fprintf(file, "      \"p90_ms\": %.6f,\n", Percentile(samples, 90.0));
+            fprintf(file, "      \"p99_ms\": %.6f,\n", Percentile(samples, 99.0));
+            fprintf(file, "      \"max_ms\": %.6f,\n", Percentile(samples, 100.0));
+            fprintf(file, "      \"bytes\": %.0f,\n", result.Bytes);
+            fprintf(file, "      \"mb_per_s_p50\": %.3f,\n",
+                (result.Bytes > 0.0 && p50 > 0.0 ? result.Bytes / (1024.0 * 1024.0) / (p50 / 1000.0) : 0.0));
+
+            fprintf(file, "      \"counters\": {");
+            bool first = true;
+            for (const auto& [key, value] : result.Counters) {
+                fprintf(file, "%s\n        \"%s\": %.6f", (first ? "" : ","), key.c_str(), value);
+                first = false;
+            }
+            fprintf(file, "%s}\n    }", (first ? "" : "\n      "));
+        }
+
+        fprintf(file, "\n  ]\n}\n");
+
+        return (fclose(file) == 0);
+    }
+
+private:
+
+    int iterations_;
+
+    std::string filter_;
+
+    std::vector<BenchResult> results_;
+
+};
+
+void RunImageBenchmarks(Bench& bench);
+void RunBase64Benchmarks(Bench& bench);
+void RunParseBenchmarks(Bench& bench);
+void RunLoadBenchmarks(Bench& bench);
+void RunLogBenchmarks(Bench& bench);
+void RunCacheBenchmarks(Bench& bench);
+void RunTextureBenchmarks(Bench& bench);
+void RunJobBenchmarks(Bench& bench);
@@ -0,0 +1,88 @@
+#include <Bench.hpp>
+#include <Synthetic.hpp>
+
+#include <Hash.hpp>
+#include <glTF2Cache.hpp>
+#include <glTF2Document.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Bakes the document as the loader would, with verticesPerMesh generated
+// vertices standing in for the converted accessor data
+void bakeSynthetic(const glTF2::document_t& doc, size_t verticesPerMesh, glTF2::bakedAsset_t& baked)
+{
+    glTF2::bakeDocument(doc, ".", baked);
+
+    std::vector<GeometryArena::Vertex> vertices(verticesPerMesh);
+    std::vector<uint32_t> indices(verticesPerMesh);
+    for (size_t i = 0; i < verticesPerMesh; ++i) {
+        vertices[i].Position = glm::vec3((float)i, 0.f, 0.f);
+        indices[i] = (uint32_t)i;
+    }
+
+    for (size_t i = 0; i < doc.meshes.size(); ++i) {
+        for (const auto& primitive : doc.meshes[i].primitives) {
+            glTF2::bakePrimitive(i, primitive, vertices, indices, baked);
+        }
+    }
+}
+
+} // namespace
+
+void RunCacheBenchmarks(Bench& bench)
+{
+    const size_t HashBytes = 64 * 1024 * 1024;
+
+    std::vector<uint8_t> hashData(HashBytes);
+    for (size_t i = 0; i < hashData.size(); ++i) {
+        hashData[i] = (uint8_t)(i * 2654435761u >> 24);
+    }
+
+    volatile uint64_t sink = 0;
+    bench.Run("hash/xxh64/64MB", [&]() {
+        sink = Hash64(hashData.data(), hashData.size());
+    }, (double)hashData.size());
+
+    const std::string cacheDir = (std::filesystem::temp_directory_path() / "glbp_bench_cache").string();
+
+    const std::vector<std::pair<std::string, std::string>> documents = {
+        { "meshes:1000", GenerateGLTFJSON(1000, 0, 1) },
+        { "embedded:16MB", GenerateGLTFJSON(100, 16 * 1024 * 1024, 3) },
+    };
+
+    for (const auto& [docName, text] : documents) {
+        uint64_t sourceHash = Hash64(text.data(), text.size());
+        const std::string cachePath = glTF2::getCachePath(cacheDir, sourceHash);
+
+        // What a cold start pays without a cache, minus image decoding and
+        // the GL upload both paths share
+        bench.Run("gltf_cache/source/" + docName, [&]() {
+            glTF2::document_t doc;
+            glTF2::parseDocumentSAX(text.data(), text.data() + text.size(), doc);
+        }, (double)text.size());
+
+        glTF2::document_t doc;
+        glTF2::parseDocumentSAX(text.data(), text.data() + text.size(), doc);
+
+        glTF2::bakedAsset_t baked;
+        bakeSynthetic(doc, 256, baked);
+
+        bench.Run("gltf_cache/write/" + docName, [&]() {
+            glTF2::writeCache(cachePath, sourceHash, baked);
+        });
+
+        // Includes hashing the source, as LoadPrimitivesFromFile does
+        bench.Run("gltf_cache/open/" + docName, [&]() {
+            glTF2::cacheView_t view;
+            glTF2::openCache(cachePath, Hash64(text.data(), text.size()), ".", view);
+        }, (double)text.size());
+
+        remove(cachePath.c_str());
+    }
+}
@@ -0,0 +1,73 @@
+#include <Bench.hpp>
+#include <Synthetic.hpp>
+
+#include <ImageDecoder.hpp>
+#include <JobSystem.hpp>
+#include <Program.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+
+void RunImageBenchmarks(Bench& bench)
+{
+    const int ImageCount = 32;
+    const int ImageSize = 1024;
+
+    std::vector<std::vector<uint8_t>> files;
+    double bytes = 0.0;
+    for (int i = 0; i < ImageCount; ++i) {
+        files.push_back(GeneratePNG(ImageSize, ImageSize, (uint32_t)i));
+        bytes += (double)files.back().size();
+    }
+
+    std::vector<ImageDecoder::Source> sources;
+    for (const auto& file : files) {
+        sources.push_back(ImageDecoder::Source{ "", file.data(), file.size() });
+    }
+
+    auto decodeAll = [&sources](JobSystem * jobs, size_t budget, size_t * peakBytes) {
+        ImageDecoder decoder(sources, budget, jobs);
+        for (size_t i = 0; i < decoder.GetCount(); ++i) {
+            decoder.Wait(i);
+            decoder.Release(i);
+        }
+        *peakBytes = decoder.GetPeakBytes();
+    };
+
+    // Scaling from one worker up to one per hardware thread besides the
+    // calling one, which decodes next to them while it waits
+    unsigned maxWorkers = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    for (unsigned workers = 1; ; workers = std::min(workers * 2, maxWorkers)) {
+        JobSystem jobs(workers);
+        size_t peakBytes = 0;
+
+        auto result = bench.Run("image_decode/workers:" + std::to_string(workers), [&]() {
+            decodeAll(&jobs, ImageDecoder::DefaultMemoryBudget, &peakBytes);
+        }, bytes);
+
+        if (result) {
+            result->Counters["peak_decoded_bytes"] = (double)peakBytes;
+        }
+
+        if (workers == maxWorkers) {
+            break;
+        }
+    }
+
+    // A budget of four images bounds memory no matter how many workers run
+    {
+        size_t budget = (size_t)ImageSize * ImageSize * 4 * 4;
+        size_t peakBytes = 0;
+
+        auto result = bench.Run("image_decode/budget:4_images", [&]() {
+            decodeAll(Program::GetJobSystem(), budget, &peakBytes);
+        }, bytes);
+
+        if (result) {
+            result->Counters["peak_decoded_bytes"] = (double)peakBytes;
+            result->Counters["budget_bytes"] = (double)budget;
+        }
+    }
+}
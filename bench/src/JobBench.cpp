@@ -0,0 +1,103 @@
+#include <Bench.hpp>
+
+#include <JobSystem.hpp>
+
+#include <depend/Math.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+
+void RunJobBenchmarks(Bench& bench)
+{
+    // Bounding spheres transformed and tested against a frustum, the kind
+    // of per object work culling and animation spread over the cores
+    const size_t ObjectCount = 1 << 18;
+
+    std::vector<glm::mat4> transforms(ObjectCount);
+    std::vector<glm::vec4> spheres(ObjectCount);
+    std::vector<uint8_t> visible(ObjectCount);
+
+    for (size_t i = 0; i < ObjectCount; ++i) {
+        glm::vec3 position((float)(i % 64), (float)((i / 64) % 64), (float)(i / 4096));
+        transforms[i] = glm::rotate(glm::translate(glm::mat4(1.f), position), (float)i * 0.01f, glm::vec3(0.f, 1.f, 0.f));
+        spheres[i] = glm::vec4(0.5f, 0.25f, -0.5f, 1.f + (float)(i % 7) * 0.1f);
+    }
+
+    glm::mat4 viewProj = glm::perspective(glm::radians(60.f), 4.f / 3.f, 0.1f, 100.f)
+        * glm::lookAt(glm::vec3(32.f, 32.f, -16.f), glm::vec3(32.f, 32.f, 32.f), glm::vec3(0.f, 1.f, 0.f));
+
+    // Gribb-Hartmann planes
+    glm::mat4 m = glm::transpose(viewProj);
+    const glm::vec4 planes[] = { m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[3] + m[2], m[3] - m[2] };
+
+    auto cull = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            glm::vec4 center = transforms[i] * glm::vec4(glm::vec3(spheres[i]), 1.f);
+            center.w = 1.f;
+
+            bool inside = true;
+            for (const auto& plane : planes) {
+                inside &= (glm::dot(plane, center) > -spheres[i].w * glm::length(glm::vec3(plane)));
+            }
+            visible[i] = inside;
+        }
+    };
+
+    const double cullBytes = (double)ObjectCount * (sizeof(glm::mat4) + sizeof(glm::vec4));
+
+    // Jobs this small are mostly overhead, what submitting and stealing cost
+    const size_t ChainCount = 64;
+    const size_t ChainLength = 64;
+
+    // Labelled by worker count, the calling thread runs jobs next to them
+    // while it waits
+    for (unsigned workers : { 1u, 2u, 4u, 8u, 16u, 32u, 64u }) {
+        const std::string suffix = "/workers:" + std::to_string(workers);
+
+        JobSystem jobs(workers);
+
+        jobs.ResetStats();
+        auto result = bench.Run("job_parallel_for/cull" + suffix, [&]() {
+            jobs.ParallelFor(ObjectCount, 0, cull);
+        }, cullBytes);
+
+        if (result) {
+            auto stats = jobs.GetStats();
+            result->Counters["stolen_ratio"] = (double)stats.Stolen / std::max<size_t>(1, stats.Executed);
+        }
+
+        // Chains where every job depends on the previous one's counter
+        std::vector<std::atomic<size_t>> links(ChainCount);
+
+        jobs.ResetStats();
+        result = bench.Run("job_graph/chains:" + std::to_string(ChainCount) + suffix, [&]() {
+            std::vector<JobCounter> counters(ChainCount * ChainLength);
+            JobCounter done;
+
+            for (size_t chain = 0; chain < ChainCount; ++chain) {
+                links[chain] = 0;
+
+                for (size_t link = 0; link < ChainLength; ++link) {
+                    auto * counter = &counters[chain * ChainLength + link];
+                    auto * last = (link + 1 == ChainLength ? &done : counter);
+                    auto job = [&links, chain]() { links[chain].fetch_add(1, std::memory_order_relaxed); };
+
+                    if (link == 0) {
+                        jobs.Submit(job, last);
+                    } else {
+                        jobs.Submit(job, last, counters[chain * ChainLength + link - 1]);
+                    }
+                }
+            }
+
+            jobs.Wait(done);
+        });
+
+        if (result) {
+            auto stats = jobs.GetStats();
+            result->Counters["stolen_ratio"] = (double)stats.Stolen / std::max<size_t>(1, stats.Executed);
+        }
+    }
+}
@@ -0,0 +1,197 @@
+#include <Bench.hpp>
+#include <Offscreen.hpp>
+#include <Synthetic.hpp>
+
+#include <Material.hpp>
+#include <Mesh.hpp>
+#include <Texture.hpp>
+#include <glTF2.hpp>
+#include <glTF2Loader.hpp>
+
+#include <filesystem>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct asset_t {
+    std::string name;
+    int meshCount;
+    size_t binBytes;
+};
+
+// Everything LoadPrimitivesFromFile does before it needs a GL context
+struct cpuLoad_t {
+    glTF2::storage_t storage;
+    glTF2::buffer_t file = { nullptr, 0 };
+    glTF2::document_t doc;
+    std::vector<glTF2::buffer_t> binChunks;
+    std::vector<glTF2::buffer_t> buffers;
+    std::unique_ptr<ImageDecoder> images;
+};
+
+bool readPhase(const std::string& filename, const glTF2::Options& opts, cpuLoad_t& load)
+{
+    return glTF2::readFile(filename, load.storage, opts, load.file);
+}
+
+bool parsePhase(const std::string& filename, const glTF2::Options& opts, cpuLoad_t& load)
+{
+    return glTF2::parseFile(filename, load.file, opts, load.doc, load.binChunks);
+}
+
+void buffersPhase(const std::string& dir, const glTF2::Options& opts, cpuLoad_t& load)
+{
+    load.buffers = glTF2::loadBuffers(load.doc, dir, load.binChunks, load.storage, opts);
+}
+
+void imagesPhase(const std::string& dir, const glTF2::Options& opts, cpuLoad_t& load)
+{
+    load.images = glTF2::loadImages(load.doc, dir, load.buffers, opts);
+    for (size_t i = 0; i < load.images->GetCount(); ++i) {
+        load.images->Wait(i);
+        load.images->Release(i);
+    }
+}
+
+void geometryPhase(cpuLoad_t& load)
+{
+    std::vector<GeometryArena::Vertex> vertices;
+    std::vector<uint32_t> indices;
+
+    const auto& doc = load.doc;
+    for (const auto& mesh : doc.meshes) {
+        for (const auto& primitive : mesh.primitives) {
+            if (primitive.indices < 0 || primitive.indices >= (int)doc.accessors.size()) {
+                continue;
+            }
+
+            glTF2::buildArenaPrimitive(primitive, doc.accessors[primitive.indices],
+                doc.bufferViews, load.buffers, doc.accessors, vertices, indices);
+        }
+    }
+}
+
+// Deletes what a load created, materials are left to the caller
+void releasePrimitives(std::vector<Mesh::Primitive> primitives)
+{
+    std::set<Material *> materials;
+    for (const auto& primitive : primitives) {
+        materials.insert(primitive.Mat);
+    }
+
+    {
+        Mesh mesh(std::move(primitives));
+    }
+
+    for (auto * material : materials) {
+        delete material;
+    }
+}
+
+} // namespace
+
+void RunLoadBenchmarks(Bench& bench)
+{
+    const std::vector<asset_t> assets = {
+        { "small", 100, 1024 * 1024 },
+        { "medium", 1000, 16 * 1024 * 1024 },
+        { "large", 5000, 64 * 1024 * 1024 },
+    };
+
+    const auto dir = (std::filesystem::temp_directory_path() / "glbp_bench_assets").string();
+    std::filesystem::create_directories(dir);
+
+    // The phases run without a context, the end to end loads need one
+    OffscreenContext context;
+    if (!context.Create()) {
+        printf("Skipping gltf_load/*/total and texture_load_file, no OpenGL context\n");
+    }
+
+    // Every load starts cold, the textures of the previous iteration aren't
+    // reused
+    glTF2::Options opts;
+    opts.ShareTextures = false;
+
+    for (const auto& asset : assets) {
+        for (bool binary : { true, false }) {
+            const std::string format = (binary ? "glb" : "gltf");
+            const std::string prefix = "gltf_load/" + format + "/" + asset.name;
+            const std::string filename = dir + "/" + asset.name + "." + format;
+
+            if (!WriteGLTFAsset(dir, asset.name, asset.meshCount, asset.binBytes, (uint32_t)asset.meshCount, binary)) {
+                printf("Failed to write %s\n", filename.c_str());
+                continue;
+            }
+
+            double bytes = (double)std::filesystem::file_size(filename);
+
+            // Each phase starts from the finished state of the ones before it
+            cpuLoad_t load;
+            readPhase(filename, opts, load);
+            parsePhase(filename, opts, load);
+            buffersPhase(dir, opts, load);
+
+            bench.Run(prefix + "/read", [&]() {
+                cpuLoad_t tmp;
+                readPhase(filename, opts, tmp);
+            }, bytes);
+
+            bench.Run(prefix + "/parse", [&]() {
+                cpuLoad_t tmp;
+                tmp.file = load.file;
+                parsePhase(filename, opts, tmp);
+            }, bytes);
+
+            bench.Run(prefix + "/buffers", [&]() {
+                cpuLoad_t tmp;
+                tmp.doc = load.doc;
+                tmp.binChunks = load.binChunks;
+                buffersPhase(dir, opts, tmp);
+            });
+
+            bench.Run(prefix + "/images", [&]() {
+                imagesPhase(dir, opts, load);
+            });
+
+            bench.Run(prefix + "/geometry", [&]() {
+                geometryPhase(load);
+            });
+
+            // Timed until the GPU has every upload. Freeing what was loaded
+            // is included too, it's small next to the load.
+            if (context.IsCreated()) {
+                bench.Run(prefix + "/total", [&]() {
+                    releasePrimitives(glTF2::LoadPrimitivesFromFile(filename, opts));
+                    context.Finish();
+                }, bytes);
+            }
+        }
+    }
+
+    // Decode and upload, until the GPU has the texture
+    for (int size : { 256, 1024, 4096 }) {
+        if (!context.IsCreated()) {
+            break;
+        }
+
+        const std::string filename = dir + "/texture_" + std::to_string(size) + ".png";
+
+        const auto& png = GeneratePNG(size, size, (uint32_t)size);
+        FILE * file = fopen(filename.c_str(), "wb");
+        if (!file) {
+            continue;
+        }
+        fwrite(png.data(), 1, png.size(), file);
+        fclose(file);
+
+        bench.Run("texture_load_file/" + std::to_string(size), [&]() {
+            Texture texture;
+            texture.LoadFromFile(filename);
+            context.Finish();
+        }, (double)png.size());
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,89 @@
+#include <Bench.hpp>
+
+#include <Log.hpp>
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if defined(WIN32)
+    #include <fcntl.h>
+    #include <io.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+// Points stdout at the null device while alive, so the benchmark measures
+// formatting and the stdio path rather than the terminal. Swapping the
+// descriptor costs a few microseconds, small next to the calls timed.
+class StdoutSilencer
+{
+public:
+
+    inline StdoutSilencer()
+    {
+        fflush(stdout);
+
+#if defined(WIN32)
+        saved_ = _dup(_fileno(stdout));
+        int null = _open("NUL", _O_WRONLY);
+        _dup2(null, _fileno(stdout));
+        _close(null);
+#else
+        saved_ = dup(fileno(stdout));
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, fileno(stdout));
+        close(null);
+#endif
+    }
+
+    inline ~StdoutSilencer()
+    {
+        fflush(stdout);
+
+#if defined(WIN32)
+        _dup2(saved_, _fileno(stdout));
+        _close(saved_);
+#else
+        dup2(saved_, fileno(stdout));
+        close(saved_);
+#endif
+    }
+
+private:
+
+    int saved_;
+
+};
+
+} // namespace
+
+void RunLogBenchmarks(Bench& bench)
+{
+    const int Calls = 10000;
+
+    const std::string name = "mesh_with_a_reasonably_long_name";
+
+    std::vector<std::pair<std::string, std::function<void(int)>>> cases = {
+        { "log/info/int", [](int i) { LogInfo("Frame %d", i); } },
+        { "log/load/string", [&name](int i) { LogLoad("glTF mesh %s %d", name, i); } },
+        { "log/verbose/mixed", [&name](int i) { LogVerbose("Texture %d, %s, %zu", i, name, name.size()); } },
+    };
+
+    for (const auto& [caseName, fn] : cases) {
+        auto result = bench.Run(caseName, [&]() {
+            StdoutSilencer silence;
+            for (int i = 0; i < Calls; ++i) {
+                fn(i);
+            }
+        });
+
+        if (result) {
+            result->Counters["calls"] = (double)Calls;
+        }
+    }
+}
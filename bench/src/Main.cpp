@@ -0,0 +1,41 @@
+#include <Bench.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv) {
+    int iterations = 10;
+    std::string filter;
+    std::string jsonFilename;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonFilename = argv[++i];
+        } else {
+            printf("Usage: %s [--iterations N] [--filter NAME] [--json FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Bench bench(iterations, filter);
+
+    RunImageBenchmarks(bench);
+    RunBase64Benchmarks(bench);
+    RunParseBenchmarks(bench);
+    RunCacheBenchmarks(bench);
+    RunLoadBenchmarks(bench);
+    RunTextureBenchmarks(bench);
+    RunJobBenchmarks(bench);
+    RunLogBenchmarks(bench);
+
+    if (!jsonFilename.empty() && !bench.WriteJSON(jsonFilename)) {
+        printf("Failed to write %s\n", jsonFilename.c_str());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <Offscreen.hpp>
+
+#include <Program.hpp>
+#include <StagingBuffer.hpp>
+
+#include <cstdio>
+
+OffscreenContext::~OffscreenContext()
+{
+    if (context_) {
+        Program::ShutdownSingletons();
+        SDL_GL_DeleteContext(context_);
+    }
+
+    if (window_) {
+        SDL_DestroyWindow(window_);
+    }
+
+    if (offscreenDriver_) {
+        SDL_VideoQuit();
+    }
+
+    if (initialized_) {
+        SDL_Quit();
+    }
+}
+
+bool OffscreenContext::Create()
+{
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("Failed to initialize SDL, %s, trying the offscreen driver\n", SDL_GetError());
+        if (SDL_VideoInit("offscreen") < 0) {
+            printf("Failed to initialize SDL offscreen driver, %s\n", SDL_GetError());
+            return false;
+        }
+        offscreenDriver_ = true;
+    } else {
+        initialized_ = true;
+    }
+
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 0);
+
+    window_ = SDL_CreateWindow("GLBP Bench", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+        64, 64, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (!window_) {
+        printf("Failed to create SDL window, %s\n", SDL_GetError());
+        return false;
+    }
+
+    context_ = SDL_GL_CreateContext(window_);
+    if (!context_) {
+        printf("Failed to create OpenGL context, %s\n", SDL_GetError());
+        return false;
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc) SDL_GL_GetProcAddress)) {
+        printf("Failed to initialize OpenGL context\n");
+        return false;
+    }
+
+    printf("OpenGL Renderer %s\n", glGetString(GL_RENDERER));
+
+    return true;
+}
+
+void OffscreenContext::Finish()
+{
+    StagingBuffer::Inst()->EndFrame();
+    glFinish();
+}
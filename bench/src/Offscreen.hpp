@@ -0,0 +1,39 @@
+#pragma once
+
+#include <depend/OpenGL.hpp>
+
+// A hidden window with a current GL context, for benchmarks timing entry
+// points that upload. Created like Program's headless mode, falling back to
+// SDL's offscreen driver when there is no display.
+class OffscreenContext
+{
+public:
+
+    OffscreenContext() = default;
+
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    // Shuts the engine's singletons down before deleting the context
+    virtual ~OffscreenContext();
+
+    // False, after printing why, when no context can be created
+    bool Create();
+
+    inline bool IsCreated() const {
+        return context_ != nullptr;
+    }
+
+    // What the end of a frame does for uploads, and waits for the GPU so
+    // they count towards the time of whatever queued them
+    void Finish();
+
+private:
+
+    SDL_Window * window_ = nullptr;
+    SDL_GLContext context_ = nullptr;
+
+    bool initialized_ = false;
+    bool offscreenDriver_ = false;
+
+};
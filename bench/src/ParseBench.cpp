@@ -0,0 +1,129 @@
+#include <Bench.hpp>
+#include <Synthetic.hpp>
+
+#include <glTF2Document.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// Every allocation in the benchmark goes through these so the live and peak
+// heap bytes of a parse can be measured. The size is stored in front of each
+// block, padded to keep the returned pointer suitably aligned.
+namespace {
+
+const size_t AllocHeader = alignof(std::max_align_t);
+
+std::atomic<size_t> liveBytes(0);
+std::atomic<size_t> peakBytes(0);
+
+void * trackedAlloc(size_t size)
+{
+    uint8_t * block = static_cast<uint8_t *>(malloc(size + AllocHeader));
+    if (!block) {
+        return nullptr;
+    }
+
+    *reinterpret_cast<size_t *>(block) = size;
+
+    size_t live = liveBytes.fetch_add(size) + size;
+    size_t peak = peakBytes.load();
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live)) { }
+
+    return block + AllocHeader;
+}
+
+void trackedFree(void * ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    uint8_t * block = static_cast<uint8_t *>(ptr) - AllocHeader;
+    liveBytes.fetch_sub(*reinterpret_cast<size_t *>(block));
+    free(block);
+}
+
+} // namespace
+
+void * operator new(size_t size)
+{
+    void * ptr = trackedAlloc(size);
+    if (!ptr) {
+        abort();
+    }
+    return ptr;
+}
+
+void * operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void * operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return trackedAlloc(size);
+}
+
+void * operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return trackedAlloc(size);
+}
+
+void operator delete(void * ptr) noexcept
+{
+    trackedFree(ptr);
+}
+
+void operator delete[](void * ptr) noexcept
+{
+    trackedFree(ptr);
+}
+
+void operator delete(void * ptr, size_t) noexcept
+{
+    trackedFree(ptr);
+}
+
+void operator delete[](void * ptr, size_t) noexcept
+{
+    trackedFree(ptr);
+}
+
+void RunParseBenchmarks(Bench& bench)
+{
+    const std::vector<std::pair<std::string, std::string>> documents = {
+        { "meshes:1000", GenerateGLTFJSON(1000, 0, 1) },
+        { "meshes:10000", GenerateGLTFJSON(10000, 0, 2) },
+        { "embedded:16MB", GenerateGLTFJSON(100, 16 * 1024 * 1024, 3) },
+    };
+
+    const std::vector<std::pair<std::string, bool (*)(const char *, const char *, glTF2::document_t&)>> parsers = {
+        { "dom", glTF2::parseDocumentDOM },
+        { "sax", glTF2::parseDocumentSAX },
+    };
+
+    for (const auto& [docName, text] : documents) {
+        for (const auto& [parserName, parse] : parsers) {
+            size_t peak = 0;
+
+            auto result = bench.Run("gltf_parse/" + parserName + "/" + docName, [&]() {
+                // Peak is measured above whatever was live before the parse
+                size_t base = liveBytes.load();
+                peakBytes.store(base);
+
+                glTF2::document_t doc;
+                parse(text.data(), text.data() + text.size(), doc);
+
+                peak = peakBytes.load() - base;
+            }, (double)text.size());
+
+            if (result) {
+                result->Counters["peak_heap_bytes"] = (double)peak;
+            }
+        }
+    }
+}
@@ -0,0 +1,349 @@
+#include <Synthetic.hpp>
+
+#include <depend/Base64.hpp>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+uint32_t crc32(const uint8_t * data, size_t size, uint32_t crc = 0)
+{
+    static uint32_t table[256] = { 0 };
+    if (table[1] == 0) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1);
+            }
+            table[i] = c;
+        }
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t adler32(const uint8_t * data, size_t size)
+{
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < size; ++i) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+void writeUint32BE(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back((value >> 24) & 0xFF);
+    out.push_back((value >> 16) & 0xFF);
+    out.push_back((value >> 8) & 0xFF);
+    out.push_back(value & 0xFF);
+}
+
+void writeChunk(std::vector<uint8_t>& out, const char * type, const std::vector<uint8_t>& data)
+{
+    writeUint32BE(out, (uint32_t)data.size());
+
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+
+    writeUint32BE(out, crc32(out.data() + start, out.size() - start));
+}
+
+// Deflate with a single fixed-Huffman block of literals, small enough to
+// write by hand but still exercises the Huffman path of the decoder
+std::vector<uint8_t> deflateLiterals(const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> out = { 0x78, 0x01 };
+
+    uint32_t bits = 0;
+    int bitCount = 0;
+
+    auto writeBits = [&](uint32_t value, int count) {
+        bits |= value << bitCount;
+        bitCount += count;
+        while (bitCount >= 8) {
+            out.push_back(bits & 0xFF);
+            bits >>= 8;
+            bitCount -= 8;
+        }
+    };
+
+    // Huffman codes are stored most significant bit first
+    auto writeCode = [&](uint32_t code, int length) {
+        uint32_t reversed = 0;
+        for (int i = 0; i < length; ++i) {
+            reversed = (reversed << 1) | ((code >> i) & 1);
+        }
+        writeBits(reversed, length);
+    };
+
+    // BFINAL, BTYPE = fixed Huffman
+    writeBits(1, 1);
+    writeBits(1, 2);
+
+    for (uint8_t byte : data) {
+        if (byte < 144) {
+            writeCode(0x30 + byte, 8);
+        } else {
+            writeCode(0x190 + (byte - 144), 9);
+        }
+    }
+
+    // End of block
+    writeCode(0, 7);
+
+    if (bitCount > 0) {
+        out.push_back(bits & 0xFF);
+    }
+
+    writeUint32BE(out, adler32(data.data(), data.size()));
+    return out;
+}
+
+} // namespace
+
+std::vector<uint8_t> GeneratePNG(int width, int height, uint32_t seed)
+{
+    const int Comp = 4;
+
+    uint32_t state = seed * 2654435761u + 1;
+    auto random = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    };
+
+    // Smooth gradients with a little noise, stored with the Sub filter
+    std::vector<uint8_t> raw;
+    raw.reserve((size_t)(width * Comp + 1) * height);
+
+    std::vector<uint8_t> row(width * Comp);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t * px = &row[x * Comp];
+            px[0] = (uint8_t)((x * 255) / width + (random() & 7));
+            px[1] = (uint8_t)((y * 255) / height + (random() & 7));
+            px[2] = (uint8_t)((x + y + seed) & 0xFF);
+            px[3] = 255;
+        }
+
+        raw.push_back(1);
+        for (int i = 0; i < width * Comp; ++i) {
+            uint8_t left = (i >= Comp ? row[i - Comp] : 0);
+            raw.push_back((uint8_t)(row[i] - left));
+        }
+    }
+
+    std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    std::vector<uint8_t> header;
+    writeUint32BE(header, (uint32_t)width);
+    writeUint32BE(header, (uint32_t)height);
+    header.push_back(8); // Bit depth
+    header.push_back(6); // RGBA
+    header.push_back(0); // Deflate
+    header.push_back(0); // Adaptive filtering
+    header.push_back(0); // No interlace
+
+    writeChunk(png, "IHDR", header);
+    writeChunk(png, "IDAT", deflateLiterals(raw));
+    writeChunk(png, "IEND", {});
+
+    return png;
+}
+
+namespace {
+
+// The buffer is embedded as a data: URI when bufferURI is null, otherwise
+// it is returned in bin and referenced by bufferURI, or by nothing for the
+// BIN chunk of a GLB when bufferURI is empty
+std::string generateGLTF(int meshCount, size_t bufferBytes, uint32_t seed, const char * bufferURI, std::string& bin)
+{
+    uint32_t state = seed * 2654435761u + 1;
+    auto random = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    };
+
+    auto randomFloat = [&random]() {
+        return (float)(random() % 10000) / 10000.f;
+    };
+
+    const size_t VertexCount = 24;
+    const size_t IndexCount = 36;
+    const size_t PositionBytes = VertexCount * 12;
+    const size_t UVBytes = VertexCount * 8;
+    const size_t IndexBytes = IndexCount * 2;
+
+    // Every accessor points into the same cube, the buffer has to hold it
+    std::string embedded(std::max(bufferBytes, PositionBytes + UVBytes + IndexBytes), '\0');
+    for (auto& c : embedded) {
+        c = (char)random();
+    }
+
+    std::string out;
+    char tmp[512];
+
+    auto append = [&](const char * format, auto... args) {
+        snprintf(tmp, sizeof(tmp), format, args...);
+        out += tmp;
+    };
+
+    out += "{\"asset\":{\"version\":\"2.0\",\"generator\":\"glbp_bench\"},";
+    out += "\"extensionsUsed\":[\"KHR_materials_emissive_strength\"],";
+    out += "\"scene\":0,\"scenes\":[{\"nodes\":[";
+    for (int i = 0; i < meshCount; ++i) {
+        append("%s%d", (i > 0 ? "," : ""), i);
+    }
+    out += "]}],";
+
+    out += "\"nodes\":[";
+    for (int i = 0; i < meshCount; ++i) {
+        append("%s{\"name\":\"node_%d\",\"mesh\":%d,"
+            "\"translation\":[%f,%f,%f],\"rotation\":[0,%f,0,%f],\"scale\":[1,1,1]}",
+            (i > 0 ? "," : ""), i, i,
+            randomFloat() * 100.f, randomFloat() * 100.f, randomFloat() * 100.f,
+            randomFloat(), randomFloat());
+    }
+    out += "],";
+
+    out += "\"meshes\":[";
+    for (int i = 0; i < meshCount; ++i) {
+        append("%s{\"name\":\"mesh_%d\",\"primitives\":[{\"attributes\":"
+            "{\"POSITION\":%d,\"NORMAL\":%d,\"TEXCOORD_0\":%d},"
+            "\"indices\":%d,\"material\":%d,\"mode\":4}]}",
+            (i > 0 ? "," : ""), i, i * 4, i * 4 + 1, i * 4 + 2, i * 4 + 3, i);
+    }
+    out += "],";
+
+    out += "\"materials\":[";
+    for (int i = 0; i < meshCount; ++i) {
+        append("%s{\"name\":\"material_%d\",\"pbrMetallicRoughness\":{"
+            "\"baseColorFactor\":[%f,%f,%f,1],\"baseColorTexture\":{\"index\":0},"
+            "\"metallicFactor\":%f,\"roughnessFactor\":%f},"
+            "\"normalTexture\":{\"index\":0,\"scale\":1},"
+            "\"emissiveFactor\":[0,0,0],\"extras\":{\"id\":%u,\"tags\":[\"a\",\"b\"]}}",
+            (i > 0 ? "," : ""), i,
+            randomFloat(), randomFloat(), randomFloat(),
+            randomFloat(), randomFloat(), random());
+    }
+    out += "],";
+
+    out += "\"accessors\":[";
+    for (int i = 0; i < meshCount; ++i) {
+        append("%s{\"bufferView\":0,\"byteOffset\":0,\"componentType\":5126,\"count\":%zu,"
+            "\"type\":\"VEC3\",\"min\":[-1,-1,-1],\"max\":[1,1,1]},",
+            (i > 0 ? "," : ""), VertexCount);
+        append("{\"bufferView\":0,\"byteOffset\":0,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"},",
+            VertexCount);
+        append("{\"bufferView\":1,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC2\"},",
+            VertexCount);
+        append("{\"bufferView\":2,\"componentType\":5123,\"count\":%zu,\"type\":\"SCALAR\"}",
+            IndexCount);
+    }
+    out += "],";
+
+    append("\"bufferViews\":["
+        "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%zu,\"target\":34962},"
+        "{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu,\"target\":34962},"
+        "{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu,\"target\":34963}],",
+        PositionBytes, PositionBytes, UVBytes, PositionBytes + UVBytes, IndexBytes);
+
+    out += "\"samplers\":[{\"magFilter\":9729,\"minFilter\":9987,\"wrapS\":10497,\"wrapT\":10497}],";
+    out += "\"images\":[{\"uri\":\"texture.png\"}],";
+    out += "\"textures\":[{\"sampler\":0,\"source\":0}],";
+
+    if (!bufferURI) {
+        append("\"buffers\":[{\"byteLength\":%zu,\"uri\":\"data:application/octet-stream;base64,",
+            embedded.size());
+        out += macaron::Base64::Encode(embedded);
+        out += "\"}]}";
+    } else if (!*bufferURI) {
+        append("\"buffers\":[{\"byteLength\":%zu}]}", embedded.size());
+        bin = std::move(embedded);
+    } else {
+        append("\"buffers\":[{\"byteLength\":%zu,\"uri\":\"%s\"}]}", embedded.size(), bufferURI);
+        bin = std::move(embedded);
+    }
+
+    return out;
+}
+
+void writeUint32LE(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back((uint8_t)value);
+    out.push_back((uint8_t)(value >> 8));
+    out.push_back((uint8_t)(value >> 16));
+    out.push_back((uint8_t)(value >> 24));
+}
+
+bool writeFile(const std::string& filename, const void * data, size_t size)
+{
+    FILE * file = fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    bool ok = (fwrite(data, 1, size, file) == size);
+    return (fclose(file) == 0 && ok);
+}
+
+} // namespace
+
+std::string GenerateGLTFJSON(int meshCount, size_t embeddedBytes, uint32_t seed)
+{
+    std::string bin;
+    return generateGLTF(meshCount, embeddedBytes, seed, nullptr, bin);
+}
+
+std::vector<uint8_t> GenerateGLB(int meshCount, size_t binBytes, uint32_t seed)
+{
+    std::string bin;
+    std::string json = generateGLTF(meshCount, binBytes, seed, "", bin);
+
+    // Chunks are padded to 4 bytes, JSON with spaces and BIN with zeros
+    json.resize((json.size() + 3) & ~(size_t)3, ' ');
+    bin.resize((bin.size() + 3) & ~(size_t)3, '\0');
+
+    std::vector<uint8_t> glb;
+    writeUint32LE(glb, 0x46546C67); // glTF
+    writeUint32LE(glb, 2);
+    writeUint32LE(glb, (uint32_t)(12 + 8 + json.size() + 8 + bin.size()));
+
+    writeUint32LE(glb, (uint32_t)json.size());
+    writeUint32LE(glb, 0x4E4F534A); // JSON
+    glb.insert(glb.end(), json.begin(), json.end());
+
+    writeUint32LE(glb, (uint32_t)bin.size());
+    writeUint32LE(glb, 0x004E4942); // BIN
+    glb.insert(glb.end(), bin.begin(), bin.end());
+
+    return glb;
+}
+
+bool WriteGLTFAsset(const std::string& dir, const std::string& name, int meshCount, size_t binBytes, uint32_t seed, bool binary)
+{
+    const auto& png = GeneratePNG(256, 256, seed);
+    if (!writeFile(dir + "/texture.png", png.data(), png.size())) {
+        return false;
+    }
+
+    if (binary) {
+        const auto& glb = GenerateGLB(meshCount, binBytes, seed);
+        return writeFile(dir + "/" + name + ".glb", glb.data(), glb.size());
+    }
+
+    std::string bin;
+    const auto& json = generateGLTF(meshCount, binBytes, seed, (name + ".bin").c_str(), bin);
+
+    return writeFile(dir + "/" + name + ".gltf", json.data(), json.size()) &&
+        writeFile(dir + "/" + name + ".bin", bin.data(), bin.size());
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Deterministic RGBA8 PNG, the same seed always produces the same bytes
+std::vector<uint8_t> GeneratePNG(int width, int height, uint32_t seed);
+
+// Deterministic glTF JSON with meshCount meshes, each with its own node,
+// material and accessors, plus a data: URI buffer of embeddedBytes
+std::string GenerateGLTFJSON(int meshCount, size_t embeddedBytes, uint32_t seed);
+
+// The same document as a GLB with the buffer in its BIN chunk
+std::vector<uint8_t> GenerateGLB(int meshCount, size_t binBytes, uint32_t seed);
+
+// Writes dir/name.glb, or dir/name.gltf with an external dir/name.bin, plus
+// the dir/texture.png every material refers to
+bool WriteGLTFAsset(const std::string& dir, const std::string& name, int meshCount, size_t binBytes, uint32_t seed, bool binary);
@@ -0,0 +1,118 @@
+#include <Bench.hpp>
+#include <Synthetic.hpp>
+
+#include <JobSystem.hpp>
+#include <MipmapGenerator.hpp>
+#include <Program.hpp>
+#include <TextureEncoder.hpp>
+#include <TexturePacker.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stb/stb_image.h>
+
+void RunTextureBenchmarks(Bench& bench)
+{
+    const int ImageSize = 1024;
+
+    const auto& png = GeneratePNG(ImageSize, ImageSize, 1);
+
+    int comp;
+    glm::ivec2 size;
+    uint8_t * pixels = stbi_load_from_memory(png.data(), (int)png.size(), &size.x, &size.y, &comp, STBI_rgb_alpha);
+    if (!pixels) {
+        printf("Failed to decode texture_encode source\n");
+        return;
+    }
+
+    double bytes = (double)size.x * size.y * 4;
+
+    const std::vector<std::pair<std::string, BlockFormat>> formats = {
+        { "bc1", BlockFormat::BC1 },
+        { "bc3", BlockFormat::BC3 },
+        { "bc4", BlockFormat::BC4 },
+        { "bc5", BlockFormat::BC5 },
+        { "bc7", BlockFormat::BC7 },
+    };
+
+    // One worker next to the calling thread, then the engine's job system
+    JobSystem small(1);
+
+    for (const auto& [name, format] : formats) {
+        for (JobSystem * jobs : { &small, Program::GetJobSystem() }) {
+            const std::string workers = std::to_string(jobs->GetWorkerCount());
+
+            size_t encodedBytes = 0;
+            auto result = bench.Run("texture_encode/" + name + "/workers:" + workers, [&]() {
+                EncodedTexture encoded;
+                EncodeTexture(pixels, size, format, true, encoded, jobs);
+                encodedBytes = encoded.Data.size();
+            }, bytes);
+
+            if (result) {
+                result->Counters["encoded_bytes"] = (double)encodedBytes;
+            }
+        }
+    }
+
+    const std::vector<std::pair<std::string, MipmapOptions>> mipmaps = {
+        { "box", MipmapOptions{ MipFilter::Box, false, 0.f } },
+        { "box_srgb", MipmapOptions{ MipFilter::Box, true, 0.f } },
+        { "kaiser_srgb", MipmapOptions{ MipFilter::Kaiser, true, 0.f } },
+        { "kaiser_srgb_coverage", MipmapOptions{ MipFilter::Kaiser, true, 0.5f } },
+    };
+
+    for (const auto& [name, mipOpts] : mipmaps) {
+        for (JobSystem * jobs : { &small, Program::GetJobSystem() }) {
+            const std::string workers = std::to_string(jobs->GetWorkerCount());
+
+            size_t levels = 0;
+            auto result = bench.Run("texture_mipmap/" + name + "/workers:" + workers, [&]() {
+                MipChain chain;
+                GenerateMipChain(pixels, size, mipOpts, chain, jobs);
+                levels = chain.Levels;
+            }, bytes);
+
+            if (result) {
+                result->Counters["levels"] = (double)levels;
+            }
+        }
+    }
+
+    // Many small material textures and a few large ones of two sizes, as in
+    // a typical scene. Only the CPU side of packing is timed, Upload needs a
+    // context.
+    std::vector<glm::ivec2> packSizes;
+    for (int i = 0; i < 256; ++i) {
+        packSizes.push_back(glm::ivec2(32 + (i % 8) * 28, 32 + (i % 5) * 40));
+    }
+    for (int i = 0; i < 8; ++i) {
+        int side = (i % 2 ? ImageSize / 2 : ImageSize / 4);
+        packSizes.push_back(glm::ivec2(side, side));
+    }
+
+    double packBytes = 0;
+    for (const auto& packSize : packSizes) {
+        packBytes += (double)packSize.x * packSize.y * 4;
+    }
+
+    TexturePacker::Stats packStats;
+    auto result = bench.Run("texture_pack/images:" + std::to_string(packSizes.size()), [&]() {
+        TexturePacker packer;
+        for (const auto& packSize : packSizes) {
+            packer.Add(pixels, packSize, Texture::Options());
+        }
+        packer.Pack();
+        packStats = packer.GetStats();
+    }, packBytes);
+
+    if (result) {
+        result->Counters["arrays"] = (double)packStats.Arrays;
+        result->Counters["layers"] = (double)packStats.Layers;
+        result->Counters["atlas_images"] = (double)packStats.AtlasImages;
+    }
+
+    stbi_image_free(pixels);
+}
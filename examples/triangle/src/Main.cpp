@@ -1,7 +1,29 @@
 #include <Program.hpp>
 
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
 int main(int argc, char** argv) {
-    Program program;
+    Program::Options opts;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            opts.Headless = true;
+        } else if (strcmp(argv[i], "--threaded") == 0) {
+            opts.ThreadedRender = true;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            opts.FrameCount = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc
+            && sscanf(argv[++i], "%dx%d", &opts.Resolution.x, &opts.Resolution.y) == 2) {
+            continue;
+        } else {
+            printf("Usage: %s [--headless] [--threaded] [--frames N] [--size WxH]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Program program(opts);
     program.Run();
     return 0;
-}
\ No newline at end of file
+}
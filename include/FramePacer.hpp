@@ -0,0 +1,114 @@
+#pragma once
+
+#include <depend/OpenGL.hpp>
+
+#include <chrono>
+#include <cstddef>
+
+enum class PacingMode
+{
+    Unlimited,      // No waiting and no vsync
+    Fixed,          // TargetRate without vsync
+    VSync,          // The swap waits for the display
+    AdaptiveVSync,  // Late frames swap immediately instead of waiting a whole
+                    // refresh, VSync when unsupported
+};
+
+// Paces the main loop to a target frame rate without burning a core. Each
+// frame sleeps until shortly before its deadline and spins only for the
+// last SpinMargin, which is what sleeping can't be trusted with. Deadlines
+// follow each other by exactly one period, so rounding never drifts the
+// rate, and are only resynced after falling behind by a whole frame.
+class FramePacer
+{
+public:
+
+    typedef std::chrono::duration<double, std::milli> double_ms;
+
+    struct Options
+    {
+        PacingMode Mode = PacingMode::VSync;
+
+        // Frames per second, 0 runs at the display rate in the vsync modes.
+        // Below the display rate the vsync modes are paced to it as well.
+        double TargetRate = 60.0;
+
+        // The end of each wait that is spun instead of slept
+        double_ms SpinMargin = double_ms(2.0);
+
+        // While idle Wait blocks on SDL_WaitEventTimeout instead, for at
+        // most IdleTimeout, so a hidden window costs nothing until input
+        // or the timeout wakes it
+        double_ms IdleTimeout = double_ms(100.0);
+    };
+
+    // Since the last ResetStats
+    struct Stats
+    {
+        size_t Frames = 0;
+
+        // Time between the starts of consecutive frames
+        double AverageMs = 0.0;
+
+        // Standard deviation of the frame time, and the largest distance of
+        // any one from the target period
+        double JitterMs = 0.0;
+        double MaxErrorMs = 0.0;
+
+        // Spent waiting, asleep and spinning
+        double SleepMs = 0.0;
+        double SpinMs = 0.0;
+    };
+
+    FramePacer() = default;
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    // Takes effect from the next Wait, and sets the swap interval on the
+    // current context
+    void SetOptions(const Options& opts);
+
+    inline const Options& GetOptions() const {
+        return opts_;
+    }
+
+    // Asks SDL for the refresh rate of the window's display, used by the
+    // vsync modes when TargetRate is 0
+    void SetWindow(SDL_Window * window);
+
+    // Waits until the next frame is due and starts it. When idle, returns
+    // once an event is pending or IdleTimeout passes instead.
+    void Wait(bool idle = false);
+
+    // 0 for Unlimited
+    double_ms GetPeriod() const;
+
+    Stats GetStats() const;
+
+    void ResetStats();
+
+private:
+
+    typedef std::chrono::high_resolution_clock clock;
+
+    // Marks the start of a frame and records its interval
+    void startFrame(clock::time_point now);
+
+    Options opts_;
+
+    double displayRate_ = 0.0;
+
+    clock::time_point deadline_;
+    clock::time_point lastFrame_;
+    bool started_ = false;
+
+    // Intervals since ResetStats
+    size_t frames_ = 0;
+    double sum_ = 0.0;
+    double sumSquares_ = 0.0;
+    double maxError_ = 0.0;
+    double sleepMs_ = 0.0;
+    double spinMs_ = 0.0;
+
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <depend/Math.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class Mesh;
+
+// Everything Render needs to draw one frame, built by Program::BuildFrame.
+// Once handed to Render it is never modified, so rendering can run on its
+// own thread while the next packet is built. Meshes and their materials
+// have to outlive the frame after the one they were drawn in.
+struct FramePacket
+{
+    struct Camera
+    {
+        glm::mat4 View = glm::mat4(1.f);
+        glm::mat4 Projection = glm::mat4(1.f);
+        glm::vec3 Position = glm::vec3(0.f);
+    };
+
+    struct Draw
+    {
+        Mesh * Source = nullptr;
+        glm::mat4 Transform = glm::mat4(1.f);
+    };
+
+    uint64_t Frame = 0;
+
+    // How far the SimulationClock is between the last Update and the next
+    float Alpha = 0.f;
+
+    // Size of the drawable in pixels
+    glm::ivec2 Viewport = glm::ivec2(0);
+
+    Camera View;
+
+    std::vector<Draw> Draws;
+
+    // Keeps the memory of Draws for the next frame
+    inline void Clear() {
+        Draws.clear();
+    }
+};
+
+// Hands frame packets from the update thread to the render thread. Of its
+// three packets one is being built, one rendered, and the latest finished
+// one waits between them. Either side trades its packet for that one with a
+// single atomic exchange, neither ever waits on the other to swap. Waiting
+// for a packet, or for the last one to be taken, sleeps on a condition
+// variable instead of spinning.
+class FramePacketExchange
+{
+public:
+
+    typedef std::chrono::duration<double, std::milli> double_ms;
+
+    FramePacketExchange() = default;
+
+    FramePacketExchange(const FramePacketExchange&) = delete;
+    FramePacketExchange& operator=(const FramePacketExchange&) = delete;
+
+    // Update thread, the packet to build next
+    inline FramePacket& GetBack() {
+        return packets_[back_];
+    }
+
+    // Update thread, makes the back packet the latest. Returns false when
+    // the previous one was never taken and is replaced.
+    bool Publish();
+
+    // Update thread, waits until the render thread took the latest packet,
+    // so building stays at most one frame ahead. False once closed.
+    bool WaitTaken();
+
+    // Render thread, the latest packet if one was published since the last
+    // call or within timeout, nullptr otherwise or once closed
+    const FramePacket * Take(double_ms timeout);
+
+    // Wakes both sides for good
+    void Close();
+
+    inline bool IsClosed() const {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+private:
+
+    // The latest packet's index, and whether it was published since the
+    // render thread last took one
+    static const uint8_t IndexMask = 0x3;
+    static const uint8_t Fresh = 0x4;
+
+    // Wakes the other side after an exchange
+    void notify();
+
+    FramePacket packets_[3];
+
+    // Owned by the update and render thread respectively
+    uint8_t back_ = 0;
+    uint8_t front_ = 1;
+
+    std::atomic<uint8_t> latest_{ 2 };
+
+    std::atomic<bool> closed_{ false };
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+
+};
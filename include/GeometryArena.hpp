@@ -0,0 +1,153 @@
+#pragma once
+
+#include <depend/OpenGL.hpp>
+#include <depend/Math.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+// A handful of large vertex and index buffers shared by every mesh. Vertices
+// use one interleaved layout so each page needs a single VAO, and primitives
+// are drawn with a base vertex and first index into their page.
+class GeometryArena
+{
+public:
+
+    struct Vertex
+    {
+        glm::vec3 Position;
+        glm::vec3 Normal;
+        glm::vec2 UV;
+        glm::vec4 Tangent;
+    };
+
+    struct Allocation
+    {
+        // Page index, or -1 for an empty allocation
+        int Page = -1;
+
+        uint32_t VertexOffset = 0;
+        uint32_t VertexCount = 0;
+
+        uint32_t IndexOffset = 0;
+        uint32_t IndexCount = 0;
+    };
+
+    struct Stats
+    {
+        size_t Pages = 0;
+
+        size_t ReservedBytes = 0;
+        size_t UsedBytes = 0;
+
+        size_t FreeBlocks = 0;
+        size_t LargestFreeBytes = 0;
+
+        // 1 - largest free block of each pool / total free space, 0 means
+        // every pool is one contiguous free block
+        float Fragmentation = 0.f;
+    };
+
+    // Pages start at the first request or these, whichever is larger, and
+    // every new one doubles up to the maximum, so a small scene doesn't
+    // reserve 64MB up front
+    static const uint32_t MinPageVertices = 64 * 1024;
+    static const uint32_t MinPageIndices = 256 * 1024;
+
+    static const uint32_t DefaultPageVertices = 1024 * 1024;
+    static const uint32_t DefaultPageIndices = 4 * 1024 * 1024;
+
+    static GeometryArena * Inst();
+
+    // The largest page sizes, meshes exceeding them get a page of their own
+    inline GeometryArena(uint32_t pageVertices = DefaultPageVertices, uint32_t pageIndices = DefaultPageIndices)
+        : pageVertices_(pageVertices)
+        , pageIndices_(pageIndices)
+        , nextPageVertices_(std::min(MinPageVertices, pageVertices))
+        , nextPageIndices_(std::min(MinPageIndices, pageIndices))
+    { }
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    virtual ~GeometryArena();
+
+    // Deletes every page while the context is still current, allocations
+    // left are ignored by Free afterwards
+    void Shutdown();
+
+    // Reserves space in the first page that fits both ranges, a new page is
+    // created when none does
+    Allocation Allocate(uint32_t vertexCount, uint32_t indexCount);
+
+    void Free(const Allocation& alloc);
+
+    void Upload(const Allocation& alloc, const Vertex * vertices, const uint32_t * indices);
+
+    // VAO with the vertex and index buffers of a page bound
+    GLuint GetVAO(int page) const;
+
+    GLuint GetVertexBuffer(int page) const;
+
+    GLuint GetIndexBuffer(int page) const;
+
+    Stats GetStats() const;
+
+private:
+
+    // First-fit free list over element ranges, neighbours merge on free
+    class FreeList
+    {
+    public:
+
+        inline FreeList(uint32_t size) {
+            blocks_[0] = size;
+        }
+
+        bool Allocate(uint32_t size, uint32_t& offset);
+
+        void Free(uint32_t offset, uint32_t size);
+
+        uint32_t GetFree() const;
+
+        uint32_t GetLargest() const;
+
+        inline size_t GetBlockCount() const {
+            return blocks_.size();
+        }
+
+    private:
+
+        // offset -> size
+        std::map<uint32_t, uint32_t> blocks_;
+
+    };
+
+    struct Page
+    {
+        GLuint VAO = 0;
+        GLuint VBO = 0;
+        GLuint IBO = 0;
+
+        uint32_t VertexCapacity;
+        uint32_t IndexCapacity;
+
+        FreeList Vertices;
+        FreeList Indices;
+    };
+
+    int createPage(uint32_t vertexCapacity, uint32_t indexCapacity);
+
+    uint32_t pageVertices_;
+    uint32_t pageIndices_;
+
+    // Capacity of the next regular page
+    uint32_t nextPageVertices_;
+    uint32_t nextPageIndices_;
+
+    std::vector<std::unique_ptr<Page>> pages_;
+
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit XXH64 content hash, fast enough to run over whole asset files on
+// every load. Not suitable for anything security related.
+uint64_t Hash64(const void * data, size_t size, uint64_t seed = 0);
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <JobSystem.hpp>
+#include <TextureContainer.hpp>
+
+#include <depend/Math.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Decodes a list of images in parallel while keeping at most MemoryBudget
+// bytes of decoded pixels alive. Images are handed out in index order with
+// Wait() and must be given back with Release() to let decoding continue.
+// A decode is only queued once its memory is there, so no job ever blocks
+// on the budget.
+class ImageDecoder
+{
+public:
+
+    struct Source
+    {
+        // Decoded with stbi_load when set, otherwise from Data/Size. With
+        // neither the image is left empty.
+        std::string Filename;
+
+        const uint8_t * Data = nullptr;
+        size_t Size = 0;
+
+        // A KTX2 or DDS file, read into Image::Container instead of decoded
+        bool Container = false;
+    };
+
+    struct Image
+    {
+        glm::ivec2 Size;
+        int Components = 0;
+        uint8_t * Data = nullptr;
+
+        // Set instead of Data for container sources
+        TextureContainer * Container = nullptr;
+    };
+
+    static const size_t DefaultMemoryBudget = 256 * 1024 * 1024;
+
+    // Reads every header up front to know the cost of each decode. A null
+    // jobs uses Program::GetJobSystem().
+    ImageDecoder(std::vector<Source> sources,
+        size_t memoryBudget = DefaultMemoryBudget,
+        JobSystem * jobs = nullptr);
+
+    ImageDecoder(const ImageDecoder&) = delete;
+    ImageDecoder& operator=(const ImageDecoder&) = delete;
+
+    // Cancels anything not yet decoded and waits for running jobs
+    virtual ~ImageDecoder();
+
+    inline size_t GetCount() const {
+        return sources_.size();
+    }
+
+    // Runs jobs until image index has been decoded, Data and Container are
+    // null on failure
+    const Image& Wait(size_t index);
+
+    // Frees the pixels of image index and returns its memory to the budget
+    void Release(size_t index);
+
+    // Highest number of decoded bytes alive at once
+    inline size_t GetPeakBytes() const {
+        return peakBytes_;
+    }
+
+private:
+
+    // Queues decodes in index order for as long as the budget allows, with
+    // mutex_ held
+    void schedule();
+
+    void decode(size_t index);
+
+    void freeImage(Image& image);
+
+    JobSystem * jobs_;
+
+    std::vector<Source> sources_;
+    std::vector<Image> images_;
+    std::vector<size_t> imageBytes_;
+
+    // Held from construction until the decode is queued, then counts it
+    std::unique_ptr<JobCounter[]> decoded_;
+
+    size_t memoryBudget_;
+
+    std::mutex mutex_;
+
+    // Budget is handed out strictly in index order so the image the consumer
+    // waits for can always make progress
+    size_t nextTicket_ = 0;
+    size_t bytesInFlight_ = 0;
+    size_t peakBytes_ = 0;
+    bool cancelled_ = false;
+
+};
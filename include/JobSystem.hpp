@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Counts the jobs submitted with it that haven't finished. Jobs can depend
+// on a counter, they are only queued once it reaches zero. Must outlive the
+// jobs counted by it, JobSystem::Wait makes sure of that.
+class JobCounter
+{
+public:
+
+    JobCounter() = default;
+
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    inline bool IsDone() const {
+        return pending_.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+
+    friend class JobSystem;
+
+    std::atomic<size_t> pending_{ 0 };
+
+    // Guards the last decrement and waiting_
+    std::mutex mutex_;
+
+    // Jobs and their counters, queued when pending_ reaches zero
+    std::vector<std::pair<std::function<void()>, JobCounter *>> waiting_;
+
+};
+
+// Work-stealing job system. Every worker has its own deque, pushing and
+// popping the newest job at the back while idle workers steal the oldest,
+// usually largest, from the front of the others. Threads that aren't
+// workers submit to a shared deque, and when they Wait run jobs as well
+// instead of blocking. Jobs for the main thread, i.e. anything calling GL,
+// have their own queue drained by Program between frames.
+class JobSystem
+{
+public:
+
+    struct Stats
+    {
+        size_t Executed = 0;
+
+        // Of Executed, taken from another thread's deque
+        size_t Stolen = 0;
+    };
+
+    // A worker count of 0 uses one less than std::thread::hardware_concurrency(),
+    // and at least one. The constructing thread is the main thread.
+    JobSystem(unsigned workerCount = 0);
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Runs every queued job before the workers stop, jobs still waiting on
+    // a counter are dropped
+    virtual ~JobSystem();
+
+    // counter, if any, counts the job until it finished
+    void Submit(std::function<void()> job, JobCounter * counter = nullptr);
+
+    // Queues the job once after reaches zero
+    void Submit(std::function<void()> job, JobCounter * counter, JobCounter& after);
+
+    // Counts something other than a job against counter until Release, e.g.
+    // work that can't be queued yet. Waiting on it keeps running jobs.
+    void Hold(JobCounter& counter);
+
+    void Release(JobCounter& counter);
+
+    // Queues the job to run on the main thread
+    void SubmitMain(std::function<void()> job, JobCounter * counter = nullptr);
+
+    // Runs jobs until counter reaches zero, main thread jobs as well when
+    // called from the main thread
+    void Wait(JobCounter& counter);
+
+    // Calls fn for ranges covering [0, count) of at most grain items and
+    // returns once all are done. A grain of 0 splits the work in a few
+    // ranges per thread.
+    void ParallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& fn);
+
+    // Main thread only, runs the oldest main thread job and returns false
+    // when there was none
+    bool RunMainJob();
+
+    inline bool HasMainJobs() const {
+        return mainQueued_.load(std::memory_order_acquire) > 0;
+    }
+
+    inline unsigned GetWorkerCount() const {
+        return (unsigned)threads_.size();
+    }
+
+    // The thread with the GL context, which runs the main thread jobs
+    inline bool IsMainThread() const {
+        return std::this_thread::get_id() == mainThread_.load(std::memory_order_relaxed);
+    }
+
+    // Makes the calling thread the main thread, when the GL context moves
+    inline void SetMainThread() {
+        mainThread_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    }
+
+    // Since construction or ResetStats
+    Stats GetStats() const;
+
+    void ResetStats();
+
+private:
+
+    struct Job
+    {
+        std::function<void()> Func;
+        JobCounter * Counter = nullptr;
+    };
+
+    // Own cache line, workers mostly only touch theirs
+    struct alignas(64) Queue
+    {
+        std::mutex Mutex;
+        std::deque<Job> Jobs;
+
+        std::atomic<size_t> Executed{ 0 };
+        std::atomic<size_t> Stolen{ 0 };
+    };
+
+    void workerLoop(size_t index);
+
+    // Onto the calling thread's deque, the shared one for non workers
+    void push(Job job);
+
+    // Takes a job from the deque of the calling thread, then the shared
+    // one, then the other workers', and runs it
+    bool tryRun(size_t index);
+
+    void run(Job& job, Queue& queue, bool stolen);
+
+    // A job counted by counter finished
+    void finish(JobCounter * counter);
+
+    void notify(bool all);
+
+    // Index of the calling thread's deque
+    size_t getQueueIndex() const;
+
+    std::atomic<std::thread::id> mainThread_;
+
+    std::vector<std::thread> threads_;
+
+    // One per worker and the shared one last
+    std::vector<std::unique_ptr<Queue>> queues_;
+
+    // Jobs in queues_, changed under the lock of the deque holding them.
+    // Any thread can take any of them, so sleepers wake only when there
+    // is something to run.
+    std::atomic<size_t> queued_{ 0 };
+
+    std::mutex sleepMutex_;
+    std::condition_variable cond_;
+    bool stopping_ = false;
+
+    std::mutex mainMutex_;
+    std::deque<Job> mainJobs_;
+    std::atomic<size_t> mainQueued_{ 0 };
+
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+class MappedFile
+{
+public:
+
+    inline MappedFile() = default;
+
+    inline MappedFile(const std::string& filename) {
+        Open(filename);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    inline virtual ~MappedFile() {
+        Close();
+    }
+
+    // Maps the whole file read-only, returns false without logging so callers
+    // can probe several paths
+    bool Open(const std::string& filename);
+
+    void Close();
+
+    inline bool IsOpen() const {
+        return data_ != nullptr;
+    }
+
+    inline const uint8_t * GetData() const {
+        return data_;
+    }
+
+    inline size_t GetSize() const {
+        return size_;
+    }
+
+private:
+
+    const uint8_t * data_ = nullptr;
+    size_t size_ = 0;
+
+#if defined(WIN32)
+    void * file_ = nullptr;
+    void * mapping_ = nullptr;
+#endif
+
+};
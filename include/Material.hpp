@@ -1,9 +1,65 @@
 #pragma once
 
+#include <depend/OpenGL.hpp>
+#include <depend/Math.hpp>
+
+#include <memory>
+#include <utility>
+
+class Texture;
+
+// Where a material samples one of its maps. Packed maps are a layer of a
+// GL_TEXTURE_2D_ARRAY, and maps packed into an atlas page only cover the
+// rectangle Transform maps their UVs to. The page is clamped, so shaders
+// wrap UVs with fract() before applying Transform to repeat them.
+struct TextureMap
+{
+    std::shared_ptr<Texture> Source;
+
+    int Layer = 0;
+
+    // uv * xy + zw
+    glm::vec4 Transform = glm::vec4(1.f, 1.f, 0.f, 0.f);
+
+    TextureMap() = default;
+
+    inline TextureMap(std::shared_ptr<Texture> source)
+        : Source(std::move(source))
+    { }
+
+    inline explicit operator bool() const {
+        return (bool)Source;
+    }
+};
+
+// Textures are shared with the TextureCache and any other material using them
 class Material 
 {
 public:
 
+    glm::vec4 BaseColorFactor = glm::vec4(1.f);
+    TextureMap BaseColorMap;
+
+    float MetallicFactor = 1.f;
+    float RoughnessFactor = 1.f;
+    TextureMap MetallicRoughnessMap;
+
+    TextureMap NormalMap;
+    float NormalScale = 1.f;
+
+    TextureMap OcclusionMap;
+    float OcclusionStrength = 1.f;
+
+    TextureMap EmissiveMap;
+    glm::vec3 EmissiveFactor = glm::vec3(0.f);
+
+    // Units from firstUnit the maps are bound to, in the order above
+    static const GLsizei MapCount = 5;
+
+    // Binds every map with its sampler in one batch through the
+    // TextureBinder, missing maps leave their unit empty
+    void Bind(GLuint firstUnit = 0) const;
+
 private:
 
-};
\ No newline at end of file
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <GeometryArena.hpp>
+
+#include <depend/OpenGL.hpp>
+
+#include <memory>
+#include <vector>
+
+class Material;
+
+class Mesh
+{
+public:
+
+    enum AttributeID : GLuint
+    {
+        POSITION = 0,
+        NORMAL   = 1,
+        UV       = 2,
+        TANGENT  = 3,
+    };
+
+    // GL buffers of primitives outside the GeometryArena, one per glTF
+    // bufferView, shared by every primitive drawing from them. Deleted with
+    // the last of those, on the main thread.
+    struct BufferSet
+    {
+        std::vector<GLuint> Names;
+
+        BufferSet() = default;
+
+        BufferSet(const BufferSet&) = delete;
+        BufferSet& operator=(const BufferSet&) = delete;
+
+        ~BufferSet();
+    };
+
+    struct Primitive
+    {
+        GLuint VAO;
+        GLenum Mode;
+        GLsizei Count;
+        GLenum Type;
+
+        // Byte offset of the first index in the index buffer
+        GLsizei Offset;
+
+        // Added to every index, non-zero for primitives in the GeometryArena
+        GLint BaseVertex;
+
+        Material * Mat;
+
+        // Space in the GeometryArena, Page is -1 for primitives with own buffers
+        GeometryArena::Allocation Allocation;
+
+        // Set for primitives with own buffers, whose VAO the Mesh deletes
+        std::shared_ptr<BufferSet> Buffers;
+    };
+
+    inline Mesh(std::vector<Primitive> primitives)
+        : primitives_(std::move(primitives))
+    { }
+
+    virtual ~Mesh();
+
+    inline const std::vector<Primitive>& GetPrimitives() const {
+        return primitives_;
+    }
+
+    void Render();
+
+private:
+
+    std::vector<Primitive> primitives_;
+
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <JobSystem.hpp>
+
+#include <depend/Math.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class MipFilter : uint32_t
+{
+    Box,    // 2x2 average
+    Kaiser, // 8 tap windowed sinc, sharper at the cost of slight ringing
+};
+
+struct MipmapOptions
+{
+    MipFilter Filter = MipFilter::Box;
+
+    // RGB is sRGB encoded, so it's decoded before filtering and encoded
+    // again after. Alpha is always linear.
+    bool SRGB = false;
+
+    // Alpha test threshold whose coverage each level keeps by scaling its
+    // alpha, so cutout foliage doesn't thin out with distance. 0 disables.
+    float AlphaCutoff = 0.f;
+};
+
+// Every level of an RGBA8 image down to 1x1, each level's pixels following
+// the previous
+struct MipChain
+{
+    glm::ivec2 Size = glm::ivec2(0);
+    int Levels = 0;
+    std::vector<uint8_t> Data;
+};
+
+// Bytes of levels RGBA8 levels, starting at size
+size_t GetMipChainSize(glm::ivec2 size, int levels);
+
+// Copies the pixels into the first level and filters every other level from
+// the one before it, in linear floating point throughout. Rows are spread
+// over the job system with the calling thread working through them too,
+// like EncodeTexture. A null jobs uses Program::GetJobSystem().
+bool GenerateMipChain(
+    const uint8_t * pixels,
+    glm::ivec2 size,
+    const MipmapOptions& opts,
+    MipChain& out,
+    JobSystem * jobs = nullptr);
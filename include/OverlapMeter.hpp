@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+
+// Measures how long two threads were busy at the same time, which is what
+// running their work side by side saved over running it one after the
+// other. Each thread brackets its work with Begin and End.
+class OverlapMeter
+{
+public:
+
+    typedef std::chrono::duration<double, std::milli> double_ms;
+
+    // Since the last Reset
+    struct Stats
+    {
+        double BusyMs[2] = { 0.0, 0.0 };
+        double OverlapMs = 0.0;
+    };
+
+    OverlapMeter() = default;
+
+    OverlapMeter(const OverlapMeter&) = delete;
+    OverlapMeter& operator=(const OverlapMeter&) = delete;
+
+    // thread is 0 or 1
+    void Begin(size_t thread);
+
+    void End(size_t thread);
+
+    Stats GetStats() const;
+
+    // Work still running counts from now on
+    void Reset();
+
+private:
+
+    typedef std::chrono::high_resolution_clock clock;
+
+    mutable std::mutex mutex_;
+
+    clock::time_point start_[2];
+    bool busy_[2] = { false, false };
+
+    Stats stats_;
+
+};
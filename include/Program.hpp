@@ -1,11 +1,44 @@
 #pragma once
 
+#include <FramePacer.hpp>
+#include <FramePacket.hpp>
+#include <JobSystem.hpp>
+#include <OverlapMeter.hpp>
+#include <SimulationClock.hpp>
+
 #include <depend/OpenGL.hpp>
+#include <depend/Math.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
 
 class Program
 {
 public:
 
+    struct Options
+    {
+        // Render and swap on a thread of their own, which takes over the GL
+        // context and runs the main thread tasks. Events, Update and
+        // BuildFrame stay on the thread calling Run, one frame ahead. Swap
+        // interval changes after Run has started don't apply in this mode.
+        bool ThreadedRender = false;
+
+        // Renders into a framebuffer behind a hidden window, or with no
+        // window at all through SDL's offscreen driver when there is no
+        // display, e.g. with Mesa llvmpipe on a build machine. Frames run
+        // unpaced with no swap interval and advance the simulation by
+        // exactly one step each, so runs are reproducible.
+        bool Headless = false;
+
+        // Of the window, or of the framebuffer when headless
+        glm::ivec2 Resolution = glm::ivec2(1024, 768);
+
+        // Frames after which Run returns, 0 runs until quit
+        uint64_t FrameCount = 0;
+    };
+
     static inline Program * Inst() {
         return inst_;
     };
@@ -14,22 +47,96 @@ public:
         inst_ = this;
     }
 
+    inline Program(const Options& opts)
+        : Program()
+    {
+        options_ = opts;
+    }
+
     inline virtual ~Program() {
         inst_ = nullptr;
     }
 
     void Run();
 
-    void Update();
-    void Render();
+    // Called at the SimulationClock rate with its step in seconds, however
+    // often frames are rendered
+    void Update(double dt);
+
+    // Fills a cleared packet with what to draw, packet.Alpha being how far
+    // the clock is between the last Update and the next, to interpolate
+    // between their states. Must not call GL.
+    void BuildFrame(FramePacket& packet);
+
+    // Draws a packet built by BuildFrame, on the render thread with
+    // ThreadedRender
+    void Render(const FramePacket& packet);
+
+    // Queue work that needs the GL context, tasks are drained between frames
+    static void RunOnMainThread(std::function<void()> task);
+
+    // Spreads loading, culling and animation over every core. Created by
+    // the first call, which makes its thread the main thread, so Run calls
+    // it before anything else can.
+    static JobSystem * GetJobSystem();
+
+    // Deletes the GL objects of the engine's singletons, which would only go
+    // in their static destructors after the context. Run calls it before
+    // deleting its context, anything else creating one has to as well.
+    static void ShutdownSingletons();
+
+    // Target rate and vsync mode of the main loop, see FramePacer
+    static inline FramePacer * GetFramePacer() {
+        return &frame_pacer_;
+    }
+
+    // Update rate and catch-up limit
+    static inline SimulationClock * GetSimulationClock() {
+        return &simulation_clock_;
+    }
+
+    static inline const Options& GetOptions() {
+        return options_;
+    }
 
 private:
 
+    // OverlapMeter threads
+    enum : size_t { UpdateThread, RenderThread };
+
+    static bool hasMainThreadTasks();
+
+    // The GL work of a frame besides drawing, streaming and main thread
+    // tasks
+    void runFrameTasks();
+
+    void renderFrame(const FramePacket& packet);
+
+    // Swaps, or only flushes when headless
+    void present();
+
+    // Body of the render thread with ThreadedRender
+    void renderLoop(FramePacketExchange * exchange);
+
+    // Run queued main thread tasks until the queue is empty, budget is spent
+    // or the StagingBuffer frame budget is used up
+    void runMainThreadTasks(std::chrono::duration<double, std::milli> budget);
+
     inline static Program * inst_ = nullptr;
 
     inline static bool _running = false;
 
+    static Options options_;
+
     inline static SDL_Window * sdl_window_ = nullptr;
     inline static SDL_GLContext sdl_context_;
 
+    // Last set with glViewport
+    inline static glm::ivec2 viewport_ = glm::ivec2(0);
+
+    inline static OverlapMeter overlap_;
+
+    inline static FramePacer frame_pacer_;
+    inline static SimulationClock simulation_clock_;
+
 };
\ No newline at end of file
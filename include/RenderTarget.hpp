@@ -0,0 +1,42 @@
+#pragma once
+
+#include <depend/OpenGL.hpp>
+#include <depend/Math.hpp>
+
+// A framebuffer with an RGBA8 color and a 24 bit depth renderbuffer, for
+// drawing without a window to present to
+class RenderTarget
+{
+public:
+
+    RenderTarget() = default;
+
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    virtual ~RenderTarget();
+
+    bool Create(glm::ivec2 size);
+
+    void Delete();
+
+    // As GL_FRAMEBUFFER, 0 for the default framebuffer when not created
+    void Bind() const;
+
+    inline glm::ivec2 GetSize() const {
+        return size_;
+    }
+
+    inline GLuint GetID() const {
+        return framebuffer_;
+    }
+
+private:
+
+    GLuint framebuffer_ = 0;
+    GLuint color_ = 0;
+    GLuint depth_ = 0;
+
+    glm::ivec2 size_ = glm::ivec2(0);
+
+};
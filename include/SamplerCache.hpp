@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Texture.hpp>
+
+#include <depend/OpenGL.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// One GL sampler object per distinct wrap and filter state, shared by every
+// texture created with it. Textures keep no sampling state of their own, so
+// anisotropy and LOD bias apply to every sampler at once. Main thread only.
+class SamplerCache
+{
+public:
+
+    static SamplerCache * Inst();
+
+    SamplerCache() = default;
+
+    SamplerCache(const SamplerCache&) = delete;
+    SamplerCache& operator=(const SamplerCache&) = delete;
+
+    virtual ~SamplerCache();
+
+    // Deletes every sampler while the context is still current
+    void Shutdown();
+
+    // Creates the sampler for opts' wrap and filter modes on first use, 0 if
+    // it can't be created
+    GLuint Get(const Texture::Options& opts);
+
+    // Binds count samplers to consecutive units from first, in one call with
+    // GL 4.4 or ARB_multi_bind. A 0 sampler leaves the unit unsampled by any
+    // sampler object.
+    void Bind(GLuint first, GLsizei count, const GLuint * samplers);
+
+    // Clamped to what the context supports, 1 disables anisotropic filtering.
+    // Ignored without an anisotropic filtering extension.
+    void SetAnisotropy(float anisotropy);
+
+    inline float GetAnisotropy() const {
+        return anisotropy_;
+    }
+
+    // Added to the level of detail every sampler picks, negative values
+    // sharpen
+    void SetLODBias(float bias);
+
+    inline float GetLODBias() const {
+        return lodBias_;
+    }
+
+    inline size_t GetCount() const {
+        return samplers_.size();
+    }
+
+private:
+
+    // Every field is a GLenum below 0x10000, so the key is exact
+    static uint64_t getKey(const Texture::Options& opts);
+
+    static bool hasAnisotropy();
+
+    // Applies the global settings to one sampler
+    void apply(GLuint sampler);
+
+    std::unordered_map<uint64_t, GLuint> samplers_;
+
+    float anisotropy_ = 1.f;
+    float lodBias_ = 0.f;
+
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Turns real time into fixed simulation steps. Time carries over between
+// frames instead of being dropped, so the simulation keeps its rate whatever
+// the frame rate, and the leftover fraction of a step is what renderers
+// interpolate the last two states by.
+class SimulationClock
+{
+public:
+
+    typedef std::chrono::duration<double, std::milli> double_ms;
+
+    struct Options
+    {
+        // Steps per second
+        double Rate = 60.0;
+
+        // Most steps run for one frame. After a stall the rest of the time
+        // is dropped rather than caught up on, which would only make the
+        // next frame slower still.
+        int MaxSteps = 5;
+    };
+
+    SimulationClock() = default;
+
+    inline SimulationClock(const Options& opts) {
+        SetOptions(opts);
+    }
+
+    void SetOptions(const Options& opts);
+
+    inline const Options& GetOptions() const {
+        return opts_;
+    }
+
+    // Adds elapsed real time and returns the steps now due
+    int Advance(double_ms elapsed);
+
+    inline double_ms GetStep() const {
+        return step_;
+    }
+
+    // How far into the next step the accumulated time is, in [0, 1)
+    inline float GetAlpha() const {
+        return (float)(accumulator_ / step_);
+    }
+
+    inline uint64_t GetStepCount() const {
+        return steps_;
+    }
+
+    // Steps skipped because of MaxSteps
+    inline uint64_t GetDroppedSteps() const {
+        return dropped_;
+    }
+
+private:
+
+    Options opts_;
+
+    double_ms step_ = double_ms(1000.0 / 60.0);
+    double_ms accumulator_ = double_ms(0.0);
+
+    uint64_t steps_ = 0;
+    uint64_t dropped_ = 0;
+
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <depend/OpenGL.hpp>
+#include <depend/Math.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// A ring of persistently mapped, coherent staging memory. Loaders write into
+// an allocation and the GPU copies it to its destination asynchronously, each
+// frame's writes are guarded by a fence so the ring is only reused once the
+// copies out of it have finished. Needs GL 4.4 or ARB_buffer_storage, without
+// it every allocation is empty and callers upload directly. Main thread only.
+class StagingBuffer
+{
+public:
+
+    struct Allocation
+    {
+        // Write pointer into the mapping, nullptr for an empty allocation
+        uint8_t * Data = nullptr;
+
+        // Offset into the staging buffer
+        size_t Offset = 0;
+
+        size_t Size = 0;
+    };
+
+    struct Stats
+    {
+        size_t Capacity = 0;
+
+        // Written and not yet known to be consumed by the GPU
+        size_t BytesInFlight = 0;
+
+        size_t FrameBytes = 0;
+        size_t TotalBytes = 0;
+
+        // Times Allocate had to wait on a fence, and for how long in total
+        size_t Stalls = 0;
+        double StallMilliseconds = 0.0;
+
+        size_t Fences = 0;
+    };
+
+    static const size_t DefaultCapacity = 64 * 1024 * 1024;
+    static const size_t DefaultFrameBudget = 16 * 1024 * 1024;
+
+    static StagingBuffer * Inst();
+
+    inline StagingBuffer(size_t capacity = DefaultCapacity, size_t frameBudget = DefaultFrameBudget)
+        : capacity_(capacity)
+        , frameBudget_(frameBudget)
+    { }
+
+    StagingBuffer(const StagingBuffer&) = delete;
+    StagingBuffer& operator=(const StagingBuffer&) = delete;
+
+    virtual ~StagingBuffer();
+
+    // Unmaps and deletes the ring while the context is still current, later
+    // uploads go through glBufferSubData
+    void Shutdown();
+
+    // Creates and maps the ring on first use, false if it isn't available
+    bool IsSupported();
+
+    // Waits on the oldest fences when the ring is full. Empty when staging is
+    // unsupported or size exceeds the capacity.
+    Allocation Allocate(size_t size, size_t alignment = 16);
+
+    // Queues a copy of the whole allocation into buffer at offset
+    void CopyToBuffer(const Allocation& alloc, GLuint buffer, size_t offset);
+
+    // Copies data through the ring, or with glBufferSubData when it can't be
+    // staged
+    void Upload(GLuint buffer, size_t offset, const void * data, size_t size);
+
+    // glTexSubImage2D of a whole level of the texture bound to GL_TEXTURE_2D,
+    // sourced from alloc
+    void CopyToTexture(const Allocation& alloc, GLint level, glm::ivec2 size, GLenum format, GLenum type);
+
+    // The same with glCompressedTexSubImage2D, the whole allocation is the
+    // level's data
+    void CopyToCompressedTexture(const Allocation& alloc, GLint level, glm::ivec2 size, GLenum internalFormat);
+
+    // glTexSubImage3D of one whole layer of a level of the texture bound to
+    // GL_TEXTURE_2D_ARRAY
+    void CopyToTextureLayer(const Allocation& alloc, GLint level, GLint layer, glm::ivec2 size, GLenum format, GLenum type);
+
+    // Bytes that may be staged per frame, main thread tasks stop early once
+    // it is spent
+    inline void SetFrameBudget(size_t bytes) {
+        frameBudget_ = bytes;
+    }
+
+    inline size_t GetFrameBudget() const {
+        return frameBudget_;
+    }
+
+    inline bool IsOverBudget() const {
+        return frameBytes_ >= frameBudget_;
+    }
+
+    // Fences this frame's writes and releases the space of finished copies
+    void EndFrame();
+
+    Stats GetStats() const;
+
+private:
+
+    struct Segment
+    {
+        GLsync Fence;
+        size_t Bytes;
+    };
+
+    void fence();
+
+    // Releases finished segments, with wait the oldest one is waited on.
+    // False if waiting failed.
+    bool retire(bool wait);
+
+    size_t capacity_;
+    size_t frameBudget_;
+
+    bool initialized_ = false;
+
+    GLuint buffer_ = 0;
+    uint8_t * mapping_ = nullptr;
+
+    // Next write position, and bytes in use from the oldest segment up to it,
+    // including any tail skipped when wrapping
+    size_t head_ = 0;
+    size_t used_ = 0;
+
+    // Written since the last fence
+    size_t pending_ = 0;
+
+    std::deque<Segment> segments_;
+
+    size_t frameBytes_ = 0;
+    size_t totalBytes_ = 0;
+
+    size_t stalls_ = 0;
+    double stallMilliseconds_ = 0.0;
+
+};
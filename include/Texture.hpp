@@ -1,5 +1,10 @@
 #pragma once
 
+#include <MipmapGenerator.hpp>
+#include <TextureBinder.hpp>
+#include <TextureContainer.hpp>
+#include <TextureEncoder.hpp>
+
 #include <depend/OpenGL.hpp>
 #include <depend/Math.hpp>
 
@@ -17,6 +22,9 @@ public:
             , MagFilter(GL_NEAREST)
             , MinFilter(GL_NEAREST)
             , Mipmap(true)
+            , Compression(BlockFormat::None)
+            , CPUMipmaps(false)
+            , SRGB(false)
         { }
 
         GLenum WrapS;
@@ -26,8 +34,27 @@ public:
         GLenum MinFilter;
 
         bool Mipmap;
+
+        // Encode RGBA buffers to this block format before uploading, falls
+        // back to uncompressed when the context doesn't support it
+        BlockFormat Compression;
+
+        // Filter the levels with GenerateMipChain instead of glGenerateMipmap,
+        // so the driver never builds them. Compressed levels are always
+        // filtered on the CPU and use Mipmaps too.
+        bool CPUMipmaps;
+
+        MipmapOptions Mipmaps;
+
+        // Store 8 bit and block compressed color formats as their sRGB
+        // variants, so sampling decodes them to linear. Formats without one
+        // are stored as they are.
+        bool SRGB;
     };
 
+    // Empty until created or loaded
+    Texture() = default;
+
     inline Texture(const std::string& filename, Options opts = Options()) {
         LoadFromFile(filename, opts);
     }
@@ -36,26 +63,161 @@ public:
         LoadFromBuffer(buffer, size, comp, opts);
     }
 
+    inline Texture(BlockFormat format, glm::ivec2 size, int levels, const uint8_t * data, Options opts = Options()) {
+        LoadFromBlocks(format, size, levels, data, opts);
+    }
+
+    inline Texture(const MipChain& chain, Options opts = Options()) {
+        LoadFromMipChain(chain, opts);
+    }
+
+    inline Texture(const TextureContainer& container, Options opts = Options()) {
+        LoadFromContainer(container, opts);
+    }
+
+    inline Texture(glm::ivec2 size, GLenum internalFormat, int levels, Options opts = Options()) {
+        Create(size, internalFormat, levels, opts);
+    }
+
     inline virtual ~Texture() 
     {
+        if (fence_) {
+            glDeleteSync(fence_);
+        }
+
         if (id_ > 0) {
+            TextureBinder::Inst()->Forget(id_);
             glDeleteTextures(1, &id_);
         }
 
         id_ = 0;
     }
 
+    // KTX2 and DDS files are uploaded as stored, anything else goes through
+    // stb_image keeping its channels, with 16 bit PNGs kept at 16 bits and
+    // HDR images as half floats. Only images to compress or filter on the CPU
+    // are widened to RGBA8.
     bool LoadFromFile(const std::string& filename, Options opts = Options());
 
+    // Create and Upload with the full mip chain when opts.Mipmap is set, the
+    // levels are then generated on the GPU unless opts.CPUMipmaps is set
     bool LoadFromBuffer(const uint8_t * buffer, glm::ivec2 size, int comp = 4, Options opts = Options());
 
-    void Bind()
+    // Uploads comp channels of GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or
+    // GL_FLOAT pixels in the format GetPixelFormat picks, mipmaps are
+    // generated on the GPU. opts.Compression and opts.CPUMipmaps are ignored.
+    bool LoadFromPixels(const void * pixels, glm::ivec2 size, int comp, GLenum type, Options opts = Options());
+
+    // Uploads levels of pre-encoded blocks laid out as in EncodedTexture,
+    // opts.Mipmap and opts.Compression are ignored
+    bool LoadFromBlocks(BlockFormat format, glm::ivec2 size, int levels, const uint8_t * data, Options opts = Options());
+
+    // Uploads every level of the chain as RGBA8, opts.Mipmap and
+    // opts.Compression are ignored
+    bool LoadFromMipChain(const MipChain& chain, Options opts = Options());
+
+    // Uploads every level in the container's own format, into immutable
+    // storage when the context has it. Mipmaps are never generated, so
+    // opts.Mipmap and opts.Compression are ignored.
+    bool LoadFromContainer(const TextureContainer& container, Options opts = Options());
+
+    // Allocates levels of storage with no contents yet, immutable when the
+    // context has GL 4.2 or ARB_texture_storage. An existing texture of the
+    // same size, format and levels is kept instead of being recreated, so
+    // reloading it only needs new uploads. opts.SRGB swaps internalFormat for
+    // its sRGB variant when the context supports it.
+    bool Create(glm::ivec2 size, GLenum internalFormat, int levels, Options opts = Options());
+
+    // The same for a GL_TEXTURE_2D_ARRAY of layers images of one size, which
+    // shaders sample as a sampler2DArray
+    bool CreateArray(glm::ivec2 size, int layers, GLenum internalFormat, int levels, Options opts = Options());
+
+    // Writes a whole level through the StagingBuffer, which returns without
+    // waiting for the driver to copy the pixels. Falls back to a direct
+    // glTexSubImage2D when the ring is unavailable.
+    bool Upload(int level, const void * pixels, GLenum format, GLenum type);
+
+    // The same for textures created with a compressed internal format
+    bool UploadCompressed(int level, const void * data, size_t size);
+
+    // Writes a whole level of one layer of an array texture
+    bool UploadLayer(int layer, int level, const void * pixels, GLenum format, GLenum type);
+
+    // Fills every level past the first from it on the GPU
+    void GenerateMipmaps();
+
+    // False until the GPU has finished every upload made so far, renderers
+    // can skip or substitute the texture until then. Polls without waiting.
+    bool IsReady();
+
+    inline glm::ivec2 GetSize() const {
+        return size_;
+    }
+
+    inline int GetLevelCount() const {
+        return levels_;
+    }
+
+    // 0 unless created with CreateArray
+    inline int GetLayerCount() const {
+        return layers_;
+    }
+
+    // GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY
+    inline GLenum GetTarget() const {
+        return target_;
+    }
+
+    // After any sRGB substitution
+    inline GLenum GetInternalFormat() const {
+        return internalFormat_;
+    }
+
+    // GPU memory of every level, as far as the format tells
+    size_t GetByteSize() const;
+
+    inline GLuint GetID() const {
+        return id_;
+    }
+
+    // Shared with every texture of the same wrap and filter modes, see
+    // SamplerCache
+    inline GLuint GetSampler() const {
+        return sampler_;
+    }
+
+    // Exchanges the GL textures and their state, so a replacement can be
+    // filled in the background while handles keep drawing this one
+    void Swap(Texture& other);
+
+    // Binds the texture and its sampler to unit through the TextureBinder,
+    // nothing is called if they're already bound there
+    void Bind(GLuint unit = 0)
     {
-        glBindTexture(GL_TEXTURE_2D, id_);
+        TextureBinder::Inst()->Bind(unit, this);
     }
 
 private:
 
+    // Create and CreateArray, layers is 0 for GL_TEXTURE_2D
+    bool create(GLenum target, glm::ivec2 size, int layers, GLenum internalFormat, int levels, Options opts);
+
+    // Replaces the fence IsReady checks with one after the latest upload
+    void fenceUpload();
+
     GLuint id_ = 0;
 
+    GLenum target_ = GL_TEXTURE_2D;
+
+    GLuint sampler_ = 0;
+
+    glm::ivec2 size_ = glm::ivec2(0);
+    GLenum internalFormat_ = 0;
+    int levels_ = 0;
+    int layers_ = 0;
+    bool immutable_ = false;
+
+    GLsync fence_ = nullptr;
+    bool ready_ = false;
+
 };
\ No newline at end of file
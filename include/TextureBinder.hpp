@@ -0,0 +1,90 @@
+#pragma once
+
+#include <depend/OpenGL.hpp>
+
+#include <cstddef>
+#include <vector>
+
+class Texture;
+
+// Remembers the texture and sampler bound to every unit, so binding what is
+// already bound costs nothing. Materials bind all their maps at once with
+// GL 4.4 or ARB_multi_bind, single textures go to their unit directly with
+// GL 4.5 or ARB_direct_state_access. Main thread only, GL calls binding
+// textures elsewhere have to be reported with Invalidate.
+class TextureBinder
+{
+public:
+
+    struct Stats
+    {
+        // GL calls made, and binds skipped because nothing changed
+        size_t Binds = 0;
+        size_t Elided = 0;
+    };
+
+    static TextureBinder * Inst();
+
+    TextureBinder() = default;
+
+    TextureBinder(const TextureBinder&) = delete;
+    TextureBinder& operator=(const TextureBinder&) = delete;
+
+    // Binds the texture and its sampler to unit, nullptr unbinds both
+    void Bind(GLuint unit, const Texture * texture);
+
+    // Binds count textures to consecutive units from first, skipping the
+    // call entirely when every unit already has its texture
+    void Bind(GLuint first, GLsizei count, const Texture * const * textures);
+
+    // The binding of target on the active unit is no longer known, after
+    // something else bound a texture there
+    void Invalidate(GLenum target);
+
+    // A deleted texture is unbound from every unit by GL, its name may come
+    // back for another texture
+    void Forget(GLuint texture);
+
+    // Everything is unknown, after GL state changed outside the binder
+    void Reset();
+
+    // Moves this frame's counters to GetStats
+    void EndFrame();
+
+    // Of the last finished frame
+    inline Stats GetStats() const {
+        return lastFrame_;
+    }
+
+private:
+
+    // Targets a unit can hold at once
+    enum : size_t { Target2D, Target2DArray, TargetCount };
+
+    struct Unit
+    {
+        // ~0u when unknown
+        GLuint Textures[TargetCount] = { ~0u, ~0u };
+        GLuint Sampler = ~0u;
+    };
+
+    static size_t getTargetIndex(GLenum target);
+
+    Unit& getUnit(GLuint unit);
+
+    // Makes unit active for the glBindTexture fallback
+    void setActive(GLuint unit);
+
+    std::vector<Unit> units_;
+
+    // ~0u when unknown
+    GLuint active_ = ~0u;
+
+    // Names passed to the multi-bind calls, kept to reuse their memory
+    std::vector<GLuint> ids_;
+    std::vector<GLuint> samplers_;
+
+    Stats frame_;
+    Stats lastFrame_;
+
+};
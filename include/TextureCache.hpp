@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Texture.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// Process-wide set of live textures keyed by the hash of their source and how
+// they are sampled and stored, so identical images loaded by different
+// assets share one GPU texture. Only weak references are kept, a texture is
+// freed with its last handle and uploaded again by the next load that needs
+// it. Lookups are thread safe.
+class TextureCache
+{
+public:
+
+    struct Key
+    {
+        // Hash64 of the encoded source, e.g. the PNG or KTX2 file, 0 for
+        // textures that can't be shared
+        uint64_t Hash = 0;
+
+        Texture::Options Options;
+    };
+
+    struct Stats
+    {
+        size_t Hits = 0;
+        size_t Misses = 0;
+
+        // GPU memory the hits would have allocated again
+        size_t BytesSaved = 0;
+
+        // Live textures
+        size_t Entries = 0;
+    };
+
+    static TextureCache * Inst();
+
+    TextureCache() = default;
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // The live texture for key counting a hit, or nullptr counting a miss
+    std::shared_ptr<Texture> Find(const Key& key);
+
+    // Caches texture unless another load got there first, returns whichever
+    // one is cached for key now
+    std::shared_ptr<Texture> Insert(const Key& key, std::shared_ptr<Texture> texture);
+
+    Stats GetStats();
+
+private:
+
+    struct Entry
+    {
+        Key Id;
+        std::weak_ptr<Texture> Handle;
+    };
+
+    static uint64_t hash(const Key& key);
+
+    static bool equal(const Key& a, const Key& b);
+
+    std::mutex mutex_;
+
+    std::unordered_map<uint64_t, Entry> entries_;
+
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+    size_t bytesSaved_ = 0;
+
+};
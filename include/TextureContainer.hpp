@@ -0,0 +1,93 @@
+#pragma once
+
+#include <depend/OpenGL.hpp>
+#include <depend/Math.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A 2D texture read from a KTX2 or DDS file, with its mip chain and format
+// exactly as stored so it can be uploaded without decoding or generating
+// anything. Block compressed and plain 8 bit, 16 bit, half and float
+// formats are understood, supercompressed KTX2 (Basis Universal, Zstandard),
+// cube maps, arrays and volumes are not.
+struct TextureContainer
+{
+    struct Level
+    {
+        const uint8_t * Data = nullptr;
+        size_t Size = 0;
+    };
+
+    // Sized or compressed
+    GLenum InternalFormat = 0;
+
+    // Pixel transfer format and type, both 0 for compressed formats
+    GLenum Format = 0;
+    GLenum Type = 0;
+
+    glm::ivec2 Size = glm::ivec2(0);
+
+    // Level 0 first
+    std::vector<Level> Levels;
+
+    // Copy of the whole file the levels point into, empty when they point
+    // into memory owned by someone else
+    std::vector<uint8_t> File;
+
+    TextureContainer() = default;
+
+    TextureContainer(const TextureContainer&) = delete;
+    TextureContainer& operator=(const TextureContainer&) = delete;
+
+    TextureContainer(TextureContainer&&) = default;
+    TextureContainer& operator=(TextureContainer&&) = default;
+
+    inline bool IsCompressed() const {
+        return (Format == 0);
+    }
+};
+
+// Checks for the KTX2 or DDS magic
+bool IsTextureContainer(const uint8_t * data, size_t size);
+
+// Checks for a .ktx2 or .dds extension
+bool IsTextureContainerFile(const std::string& filename);
+
+// Checks for a glTF image mimeType naming a KTX2 or DDS file
+bool IsTextureContainerMimeType(const std::string& mimeType);
+
+// Copies data into out.File and validates every level against it
+bool ParseTextureContainer(const uint8_t * data, size_t size, TextureContainer& out);
+
+bool LoadTextureContainer(const std::string& filename, TextureContainer& out);
+
+// How pixels in memory are uploaded, and the sized format they're kept in
+struct PixelFormat
+{
+    GLenum InternalFormat = 0;
+    GLenum Format = 0;
+    GLenum Type = 0;
+};
+
+// Keeps the comp channels of pixels of type GL_UNSIGNED_BYTE,
+// GL_UNSIGNED_SHORT or GL_FLOAT, as 8 bit, 16 bit normalized and half float
+// formats. InternalFormat is 0 for anything else.
+PixelFormat GetPixelFormat(int comp, GLenum type);
+
+// The sRGB variant of an 8 bit or block compressed color format,
+// internalFormat itself when it has none
+GLenum GetSRGBTextureFormat(GLenum internalFormat);
+
+// Bytes of one level of size in internalFormat, 0 for formats a container
+// can't hold
+size_t GetTextureLevelSize(GLenum internalFormat, glm::ivec2 size);
+
+// True for the compressed formats a container can hold
+bool IsCompressedTextureFormat(GLenum internalFormat);
+
+// Checks the extensions loaded with the context, safe off the main thread
+// like IsBlockFormatSupported
+bool IsTextureFormatSupported(GLenum internalFormat);
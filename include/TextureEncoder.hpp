@@ -0,0 +1,69 @@
+#pragma once
+
+#include <JobSystem.hpp>
+#include <MipmapGenerator.hpp>
+
+#include <depend/OpenGL.hpp>
+#include <depend/Math.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Block compressed formats Texture can be created from. BC4 keeps only the
+// red channel and BC5 red and green, so normal maps stored as BC5 need their
+// Z reconstructed when sampled.
+enum class BlockFormat : uint32_t
+{
+    None,
+    BC1, // RGB, 8 bytes per block
+    BC3, // RGBA, 16 bytes per block
+    BC4, // R, 8 bytes per block
+    BC5, // RG, 16 bytes per block
+    BC7, // RGBA, 16 bytes per block, mode 6 only
+};
+
+// Every mip level of an image, each level's blocks following the previous
+struct EncodedTexture
+{
+    BlockFormat Format = BlockFormat::None;
+    glm::ivec2 Size = glm::ivec2(0);
+    int Levels = 0;
+    std::vector<uint8_t> Data;
+};
+
+GLenum GetBlockFormatGL(BlockFormat format);
+
+// None when internalFormat isn't one of ours
+BlockFormat GetBlockFormat(GLenum internalFormat);
+
+// Bytes for the given number of levels, starting at size
+size_t GetEncodedSize(BlockFormat format, glm::ivec2 size, int levels);
+
+// Number of levels in a full mip chain down to 1x1
+int GetMipLevelCount(glm::ivec2 size);
+
+// Checks the extensions loaded with the context for the S3TC, RGTC and BPTC
+// formats. Those are only written while the context is created, so this can
+// be asked from loader threads.
+bool IsBlockFormatSupported(BlockFormat format);
+
+// Encodes RGBA8 pixels, with a box filtered mip chain from GenerateMipChain
+// when mipmaps is set. Rows of blocks are spread over the job system and the
+// calling thread works through them too, so it finishes even if every worker
+// is busy. A null jobs uses Program::GetJobSystem().
+bool EncodeTexture(
+    const uint8_t * pixels,
+    glm::ivec2 size,
+    BlockFormat format,
+    bool mipmaps,
+    EncodedTexture& out,
+    JobSystem * jobs = nullptr);
+
+// Encodes every level of a chain made with GenerateMipChain, for levels
+// filtered with other options
+bool EncodeMipChain(
+    const MipChain& chain,
+    BlockFormat format,
+    EncodedTexture& out,
+    JobSystem * jobs = nullptr);
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <Material.hpp>
+#include <Texture.hpp>
+
+#include <depend/Math.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Packs RGBA8 images into a few GL_TEXTURE_2D_ARRAY textures so materials
+// can be drawn with a handful of binds. Images of one size and sampler share
+// an array as its layers, small images that clamp on both axes are shelf
+// packed into atlas pages that are layers of one array per filter. Pages
+// keep Padding texels of repeated edge around every image and only as many
+// mip levels as that padding keeps free of neighbours.
+class TexturePacker
+{
+public:
+
+    struct Options
+    {
+        Options()
+            : PageSize(2048)
+            , MaxAtlasSize(256)
+            , Padding(4)
+            , MaxLayers(256)
+        { }
+
+        // Width and height of atlas pages
+        int PageSize;
+
+        // Images at most this wide and tall go into atlas pages, if they
+        // clamp to edge on both axes
+        int MaxAtlasSize;
+
+        // Texels of gutter around each image in a page
+        int Padding;
+
+        // Arrays are split past this many layers, GL guarantees 256
+        int MaxLayers;
+    };
+
+    struct Stats
+    {
+        size_t Images = 0;
+
+        // Images that went into atlas pages
+        size_t AtlasImages = 0;
+
+        size_t Arrays = 0;
+        size_t Layers = 0;
+    };
+
+    explicit TexturePacker(Options opts = Options());
+
+    TexturePacker(const TexturePacker&) = delete;
+    TexturePacker& operator=(const TexturePacker&) = delete;
+
+    // Copies pixels, returns the index of the image's map in Upload's result.
+    // Images can only be added before Pack.
+    // Mipmap, the filters and the wrap modes of opts are kept, only images
+    // that clamp to edge are put in atlas pages.
+    size_t Add(const uint8_t * pixels, glm::ivec2 size, const Texture::Options& opts);
+
+    // Groups the images and composes the atlas pages, safe on any thread.
+    // The copies made by Add are freed.
+    void Pack();
+
+    // Creates and fills every array on the main thread, one map per image.
+    // Pack is called first if it hasn't been.
+    std::vector<TextureMap> Upload();
+
+    inline const Stats& GetStats() const {
+        return stats_;
+    }
+
+private:
+
+    struct Image
+    {
+        std::vector<uint8_t> Pixels;
+        glm::ivec2 Size;
+        Texture::Options Options;
+
+        // Set by Pack, SIZE_MAX for images that weren't packed
+        size_t ArrayIndex = SIZE_MAX;
+        int Layer = 0;
+        glm::vec4 Transform = glm::vec4(1.f, 1.f, 0.f, 0.f);
+    };
+
+    struct Array
+    {
+        glm::ivec2 Size;
+        int Levels = 1;
+        Texture::Options Options;
+
+        // One RGBA8 image per layer
+        std::vector<std::vector<uint8_t>> Layers;
+    };
+
+    void packLayers(const std::vector<size_t>& group);
+
+    void packAtlas(const std::vector<size_t>& group);
+
+    Options opts_;
+
+    std::vector<Image> images_;
+
+    std::vector<Array> arrays_;
+
+    bool packed_ = false;
+
+    Stats stats_;
+
+};
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <Texture.hpp>
+
+#include <depend/OpenGL.hpp>
+#include <depend/Math.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Keeps only the mip levels textures need on the GPU. Every texture starts
+// with just its smallest levels resident, renderers report how large it is
+// on screen with Request and Update reallocates it with the finer levels
+// that size needs, within a budget of GPU memory. Textures that haven't been
+// requested for longest lose their finer levels first when the budget is
+// short. Every level stays in system memory to be uploaded again. Main
+// thread only.
+class TextureStreamer
+{
+public:
+
+    // Every level of a texture, in one internal format
+    struct Source
+    {
+        GLenum InternalFormat = 0;
+
+        // Pixel transfer format and type, both 0 for compressed formats
+        GLenum Format = 0;
+        GLenum Type = 0;
+
+        glm::ivec2 Size = glm::ivec2(0);
+
+        // Level 0 first
+        std::vector<std::vector<uint8_t>> Levels;
+    };
+
+    struct Stats
+    {
+        size_t Textures = 0;
+
+        // GPU memory of every resident level, and the budget it is kept under
+        size_t ResidentBytes = 0;
+        size_t BudgetBytes = 0;
+
+        // Textures requested with finer levels than they have
+        size_t PendingRequests = 0;
+
+        // During the last Update
+        size_t Uploads = 0;
+        size_t UploadedBytes = 0;
+        size_t Evictions = 0;
+
+        size_t TotalEvictions = 0;
+    };
+
+    static const size_t DefaultBudget = 512 * 1024 * 1024;
+
+    // Levels at most this wide and tall are always resident
+    static const int DefaultMinResidentSize = 64;
+
+    static TextureStreamer * Inst();
+
+    inline TextureStreamer(size_t budget = DefaultBudget, int minResidentSize = DefaultMinResidentSize)
+        : budget_(budget)
+        , minResidentSize_(minResidentSize)
+    { }
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    virtual ~TextureStreamer();
+
+    // Deletes pending uploads and stops tracking every texture while the
+    // context is still current, the textures themselves stay with their
+    // handles
+    void Shutdown();
+
+    // Creates the texture with its smallest levels uploaded, the streamer
+    // only holds on to it until its last handle is released. opts.Mipmap and
+    // opts.Compression are ignored.
+    std::shared_ptr<Texture> Add(Source source, Texture::Options opts = Texture::Options());
+
+    // Fills source from the levels of a mip chain, encoded texture or
+    // container
+    static void MakeSource(const MipChain& chain, Source& out);
+
+    static void MakeSource(const EncodedTexture& encoded, Source& out);
+
+    static void MakeSource(const TextureContainer& container, Source& out);
+
+    // Marks the texture as used this frame, drawn screenSize pixels across
+    // along its wider side. Several requests in a frame keep the largest.
+    void Request(const Texture * texture, float screenSize);
+
+    // Starts uploading the levels requested this frame, largest on screen
+    // first, while the StagingBuffer frame budget lasts, and swaps in the
+    // uploads that have finished. Called once per frame.
+    void Update();
+
+    inline void SetBudget(size_t bytes) {
+        budget_ = bytes;
+    }
+
+    inline size_t GetBudget() const {
+        return budget_;
+    }
+
+    Stats GetStats() const;
+
+private:
+
+    struct Entry
+    {
+        std::weak_ptr<Texture> Handle;
+
+        // Handle's address, still known once it expires
+        const Texture * Key = nullptr;
+
+        Texture::Options Options;
+        Source Data;
+
+        // First level on the GPU, and the first one asked for
+        int Resident = 0;
+        int Wanted = 0;
+
+        // Largest size requested in LastFrame
+        float ScreenSize = 0.f;
+
+        // Finer levels being uploaded, swapped in once the GPU has them so
+        // the texture never shows up empty
+        std::unique_ptr<Texture> Pending;
+        int PendingFirst = 0;
+
+        // Each level's GPU size, to price a change without asking the driver
+        std::vector<size_t> LevelBytes;
+
+        uint64_t LastFrame = 0;
+    };
+
+    using entryList_t = std::list<Entry>;
+
+    // Bytes of the levels from first down to the smallest
+    static size_t getResidentBytes(const Entry& entry, int first);
+
+    // First level no larger than minResidentSize_
+    int getMinResident(const Entry& entry) const;
+
+    // Reallocates texture with the entry's levels from first down and
+    // uploads them
+    bool upload(Entry& entry, int first, Texture& texture);
+
+    // Drops the entry's pending upgrade
+    void cancelPending(Entry& entry);
+
+    // Drops the finer levels of the least recently requested textures until
+    // bytes more fit the budget, never touching keep. False if they can't.
+    bool evict(size_t bytes, const Entry * keep);
+
+    size_t budget_;
+    int minResidentSize_;
+
+    // Most recently requested first
+    entryList_t entries_;
+    std::unordered_map<const Texture *, entryList_t::iterator> lookup_;
+
+    uint64_t frame_ = 0;
+
+    size_t residentBytes_ = 0;
+
+    Stats frameStats_;
+    size_t totalEvictions_ = 0;
+
+};
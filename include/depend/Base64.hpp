@@ -26,9 +26,21 @@
 */
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
 
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define MACARON_BASE64_X86
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+		#define MACARON_BASE64_TARGET(x)
+	#else
+		#define MACARON_BASE64_TARGET(x) __attribute__((target(x)))
+	#endif
+	#include <immintrin.h>
+#endif
+
 namespace macaron {
 
 class Base64 {
@@ -74,7 +86,93 @@ public:
 		return ret;
 	}
 
+	// Number of bytes Decode() will write, or 0 if input is not valid base64
+	static size_t DecodedLength(std::string_view input) {
+		size_t in_len = input.size();
+		if (in_len == 0 || in_len % 4 != 0) return 0;
+
+		size_t out_len = in_len / 4 * 3;
+		if (input[in_len - 1] == '=') out_len--;
+		if (input[in_len - 2] == '=') out_len--;
+		return out_len;
+	}
+
+	enum class SIMD {
+		Auto,
+		None,
+		SSSE3,
+		AVX2,
+	};
+
+	// Decodes input into out, which must hold at least DecodedLength(input)
+	// bytes. out can be any writable memory, e.g. a mapped GL buffer.
+	static bool Decode(std::string_view input, uint8_t * out, size_t out_len, SIMD simd = SIMD::Auto) {
+		if (out_len < DecodedLength(input) || DecodedLength(input) == 0) return false;
+		out_len = DecodedLength(input);
+
+		if (simd == SIMD::Auto) {
+			simd = DetectSIMD();
+		}
+
+		size_t i = 0, j = 0;
+
+#if defined(MACARON_BASE64_X86)
+		if (simd == SIMD::AVX2) {
+			DecodeAVX2(input.data(), input.size(), out, out_len, i, j);
+		}
+		if (simd == SIMD::AVX2 || simd == SIMD::SSSE3) {
+			DecodeSSSE3(input.data(), input.size(), out, out_len, i, j);
+		}
+#endif
+
+		return DecodeScalar(input, out, out_len, i, j);
+	}
+
 	static std::vector<uint8_t> Decode(const std::string& input) {
+		std::vector<uint8_t> out(DecodedLength(input));
+		if (!Decode(input, out.data(), out.size())) out.clear();
+		return out;
+	}
+
+	static SIMD DetectSIMD() {
+#if defined(MACARON_BASE64_X86) && (defined(__GNUC__) || defined(__clang__))
+		static const SIMD detected = []() {
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2")) return SIMD::AVX2;
+			if (__builtin_cpu_supports("ssse3")) return SIMD::SSSE3;
+			return SIMD::None;
+		}();
+		return detected;
+#elif defined(MACARON_BASE64_X86) && defined(_MSC_VER)
+		static const SIMD detected = []() {
+			int info[4];
+			__cpuid(info, 0);
+			int maxLeaf = info[0];
+
+			__cpuid(info, 1);
+			bool ssse3 = (info[2] & (1 << 9)) != 0;
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+
+			bool avx2 = false;
+			if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 6) == 6) {
+				__cpuidex(info, 7, 0);
+				avx2 = (info[1] & (1 << 5)) != 0;
+			}
+
+			if (avx2) return SIMD::AVX2;
+			if (ssse3) return SIMD::SSSE3;
+			return SIMD::None;
+		}();
+		return detected;
+#else
+		return SIMD::None;
+#endif
+	}
+
+private:
+
+	// Decodes from input[i] / out[j] onwards, handles padding and validation
+	static bool DecodeScalar(std::string_view input, uint8_t * out, size_t out_len, size_t i, size_t j) {
 		static constexpr unsigned char kDecodingTable[] = {
 			64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
 			64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
@@ -94,33 +192,150 @@ public:
 			64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64
 		};
 
-		std::vector<uint8_t> out;
-
 		size_t in_len = input.size();
-		if (in_len % 4 != 0) return out;
+		const unsigned char * in = reinterpret_cast<const unsigned char *>(input.data());
 
-		size_t out_len = in_len / 4 * 3;
-		if (input[in_len - 1] == '=') out_len--;
-		if (input[in_len - 2] == '=') out_len--;
+		// Whole quads without padding, 3 bytes each
+		for (; i + 4 < in_len || (i + 4 == in_len && in[in_len - 1] != '='); i += 4) {
+			uint32_t a = kDecodingTable[in[i]];
+			uint32_t b = kDecodingTable[in[i + 1]];
+			uint32_t c = kDecodingTable[in[i + 2]];
+			uint32_t d = kDecodingTable[in[i + 3]];
+			if ((a | b | c | d) & 64) return false;
 
-		out.resize(out_len);
+			uint32_t triple = (a << 3 * 6) + (b << 2 * 6) + (c << 1 * 6) + (d << 0 * 6);
 
-		for (size_t i = 0, j = 0; i < in_len;) {
-			uint32_t a = input[i] == '=' ? 0 & i++ : kDecodingTable[static_cast<int>(input[i++])];
-			uint32_t b = input[i] == '=' ? 0 & i++ : kDecodingTable[static_cast<int>(input[i++])];
-			uint32_t c = input[i] == '=' ? 0 & i++ : kDecodingTable[static_cast<int>(input[i++])];
-			uint32_t d = input[i] == '=' ? 0 & i++ : kDecodingTable[static_cast<int>(input[i++])];
+			out[j++] = (triple >> 2 * 8) & 0xFF;
+			out[j++] = (triple >> 1 * 8) & 0xFF;
+			out[j++] = (triple >> 0 * 8) & 0xFF;
+		}
 
-			uint32_t triple = (a << 3 * 6) + (b << 2 * 6) + (c << 1 * 6) + (d << 0 * 6);
+		// Final quad with one or two '='
+		if (i < in_len) {
+			uint32_t a = kDecodingTable[in[i]];
+			uint32_t b = kDecodingTable[in[i + 1]];
+			uint32_t c = (in[i + 2] == '=' ? 0 : kDecodingTable[in[i + 2]]);
+			if ((a | b | c) & 64) return false;
+
+			uint32_t triple = (a << 3 * 6) + (b << 2 * 6) + (c << 1 * 6);
 
 			if (j < out_len) out[j++] = (triple >> 2 * 8) & 0xFF;
 			if (j < out_len) out[j++] = (triple >> 1 * 8) & 0xFF;
-			if (j < out_len) out[j++] = (triple >> 0 * 8) & 0xFF;
 		}
 
-		return out;
+		return j == out_len;
+	}
+
+#if defined(MACARON_BASE64_X86)
+
+	// SSSE3/AVX2 decoding after Wojciech Mula and Daniel Lemire, "Faster
+	// Base64 Encoding and Decoding Using AVX2 Instructions". Each loop stops
+	// at the first block containing padding or invalid characters and leaves
+	// it to the next, narrower, implementation.
+
+	MACARON_BASE64_TARGET("ssse3")
+	static __m128i ReshuffleSSSE3(__m128i in) {
+		// Merge 4x6 bits into 3 bytes per 32-bit lane, then pack the lanes
+		const __m128i merge_ab_and_bc = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+		const __m128i out = _mm_madd_epi16(merge_ab_and_bc, _mm_set1_epi32(0x00011000));
+		return _mm_shuffle_epi8(out, _mm_setr_epi8(
+			 2,  1,  0,
+			 6,  5,  4,
+			10,  9,  8,
+			14, 13, 12,
+			-1, -1, -1, -1));
+	}
+
+	MACARON_BASE64_TARGET("ssse3")
+	static void DecodeSSSE3(const char * in, size_t in_len, uint8_t * out, size_t out_len, size_t& i, size_t& j) {
+		const __m128i lut_lo = _mm_setr_epi8(
+			0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+			0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+		const __m128i lut_hi = _mm_setr_epi8(
+			0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+		const __m128i lut_roll = _mm_setr_epi8(
+			  0,  16,  19,   4, -65, -65, -71, -71,
+			  0,   0,   0,   0,   0,   0,   0,   0);
+		const __m128i mask_2F = _mm_set1_epi8(0x2F);
+
+		// Reads 16 characters and writes 16 bytes, of which 12 are kept
+		while (i + 16 <= in_len && j + 16 <= out_len) {
+			__m128i str = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+
+			const __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2F);
+			const __m128i lo_nibbles = _mm_and_si128(str, mask_2F);
+			const __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+			const __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+
+			if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0) {
+				break;
+			}
+
+			const __m128i eq_2F = _mm_cmpeq_epi8(str, mask_2F);
+			const __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2F, hi_nibbles));
+
+			str = ReshuffleSSSE3(_mm_add_epi8(str, roll));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + j), str);
+
+			i += 16;
+			j += 12;
+		}
+	}
+
+	MACARON_BASE64_TARGET("avx2")
+	static void DecodeAVX2(const char * in, size_t in_len, uint8_t * out, size_t out_len, size_t& i, size_t& j) {
+		const __m256i lut_lo = _mm256_setr_epi8(
+			0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+			0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+			0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+			0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+		const __m256i lut_hi = _mm256_setr_epi8(
+			0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+		const __m256i lut_roll = _mm256_setr_epi8(
+			  0,  16,  19,   4, -65, -65, -71, -71,
+			  0,   0,   0,   0,   0,   0,   0,   0,
+			  0,  16,  19,   4, -65, -65, -71, -71,
+			  0,   0,   0,   0,   0,   0,   0,   0);
+		const __m256i mask_2F = _mm256_set1_epi8(0x2F);
+
+		// Reads 32 characters and writes 32 bytes, of which 24 are kept
+		while (i + 32 <= in_len && j + 32 <= out_len) {
+			__m256i str = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+
+			const __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2F);
+			const __m256i lo_nibbles = _mm256_and_si256(str, mask_2F);
+			const __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+			const __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+
+			if (!_mm256_testz_si256(lo, hi)) {
+				break;
+			}
+
+			const __m256i eq_2F = _mm256_cmpeq_epi8(str, mask_2F);
+			const __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2F, hi_nibbles));
+
+			str = _mm256_add_epi8(str, roll);
+
+			const __m256i merge_ab_and_bc = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+			str = _mm256_madd_epi16(merge_ab_and_bc, _mm256_set1_epi32(0x00011000));
+			str = _mm256_shuffle_epi8(str, _mm256_setr_epi8(
+				 2,  1,  0,  6,  5,  4, 10,  9,  8, 14, 13, 12, -1, -1, -1, -1,
+				 2,  1,  0,  6,  5,  4, 10,  9,  8, 14, 13, 12, -1, -1, -1, -1));
+			str = _mm256_permutevar8x32_epi32(str, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1));
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + j), str);
+
+			i += 32;
+			j += 24;
+		}
 	}
 
+#endif
+
 };
 
 }
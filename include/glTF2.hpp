@@ -1,10 +1,88 @@
 #pragma once
 
+#include <ImageDecoder.hpp>
+#include <Mesh.hpp>
+#include <MipmapGenerator.hpp>
+
+#include <future>
 #include <string>
 #include <vector>
 
 namespace glTF2 {
 
-std::vector<Mesh::Primitive> LoadPrimitivesFromFile(const std::string& filename);
+struct Options
+{
+    Options()
+        : MapFiles(true)
+        , ImageMemoryBudget(ImageDecoder::DefaultMemoryBudget)
+        , UseGeometryArena(true)
+        , StreamingParse(true)
+        , CacheDir()
+        , CompressTextures(false)
+        , ShareTextures(true)
+        , PackTextures(false)
+        , StreamTextures(false)
+        , CPUMipmaps(true)
+        , MipmapFilter(MipFilter::Box)
+    { }
+
+    // Memory-map .glb/.bin files and read chunks in place instead of copying
+    bool MapFiles;
+
+    // Upper bound on decoded image bytes held at once while loading
+    size_t ImageMemoryBudget;
+
+    // Convert primitives to one vertex layout and pack them into the shared
+    // GeometryArena, otherwise each primitive gets a VAO over its bufferViews
+    bool UseGeometryArena;
+
+    // Fill the typed tables straight from SAX events instead of building a
+    // full JSON DOM first
+    bool StreamingParse;
+
+    // Directory for binary runtime caches, named after a hash of the source
+    // file. A valid cache is mapped and uploaded without any parsing or
+    // decoding, an empty string disables caching. Only used together with
+    // UseGeometryArena and without PackTextures or StreamTextures.
+    std::string CacheDir;
+
+    // Block compress textures while loading, picking the format from how
+    // materials use each one: BC5 for normal maps, BC4 for occlusion, BC1 for
+    // emissive and BC7 for everything else. Normal maps then only keep X and
+    // Y, so shaders have to reconstruct Z.
+    bool CompressTextures;
+
+    // Reuse textures already loaded from identical image bytes with the same
+    // sampler and compression through the TextureCache, their images aren't
+    // decoded again
+    bool ShareTextures;
+
+    // Put uncompressed textures into GL_TEXTURE_2D_ARRAY layers grouped by
+    // size and sampler, with the small ones packed into atlas pages, see
+    // TexturePacker. Materials then name a layer and UV transform in each
+    // TextureMap, so shaders sample them as sampler2DArray.
+    bool PackTextures;
+
+    // Hand textures with mip levels to the TextureStreamer, which keeps only
+    // their smallest levels on the GPU until the renderer calls Request with
+    // how large they're drawn. Packed textures aren't streamed.
+    bool StreamTextures;
+
+    // Filter mip levels on the loader threads, in linear space for sRGB maps
+    // and keeping the alpha test coverage of MASK materials, instead of with
+    // glGenerateMipmap on the main thread
+    bool CPUMipmaps;
+
+    // Filter used with CPUMipmaps, Kaiser is sharper but several times slower
+    // than Box
+    MipFilter MipmapFilter;
+};
+
+std::vector<Mesh::Primitive> LoadPrimitivesFromFile(const std::string& filename, Options opts = Options());
+
+// Parses and decodes as jobs on Program::GetJobSystem() and creates GL
+// objects through Program::RunOnMainThread, the future is ready once every
+// upload has run. GL objects are released on the main thread as well.
+std::future<std::vector<Mesh::Primitive>> LoadPrimitivesFromFileAsync(const std::string& filename, Options opts = Options());
 
 }
\ No newline at end of file
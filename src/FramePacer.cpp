@@ -0,0 +1,166 @@
+#include <FramePacer.hpp>
+
+#include <Log.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+void FramePacer::SetOptions(const Options& opts)
+{
+    opts_ = opts;
+    opts_.TargetRate = std::max(0.0, opts_.TargetRate);
+    opts_.SpinMargin = std::max(double_ms(0.0), opts_.SpinMargin);
+
+    if (!SDL_GL_GetCurrentContext()) {
+        return;
+    }
+
+    int interval = 0;
+    switch (opts_.Mode)
+    {
+    case PacingMode::VSync:
+        interval = 1;
+        break;
+    case PacingMode::AdaptiveVSync:
+        interval = -1;
+        break;
+    default:
+        break;
+    }
+
+    if (SDL_GL_SetSwapInterval(interval) < 0 && interval < 0) {
+        LogWarn("Adaptive vsync unavailable, %s", SDL_GetError());
+        SDL_GL_SetSwapInterval(1);
+    }
+
+    // The period may have changed
+    started_ = false;
+}
+
+void FramePacer::SetWindow(SDL_Window * window)
+{
+    displayRate_ = 0.0;
+
+    SDL_DisplayMode mode;
+    if (window && SDL_GetWindowDisplayMode(window, &mode) == 0 && mode.refresh_rate > 0) {
+        displayRate_ = mode.refresh_rate;
+    }
+}
+
+void FramePacer::Wait(bool idle /*= false*/)
+{
+    using namespace std::chrono;
+
+    if (idle) {
+        auto start = clock::now();
+        SDL_WaitEventTimeout(nullptr, (int)opts_.IdleTimeout.count());
+        sleepMs_ += duration_cast<double_ms>(clock::now() - start).count();
+
+        // Whenever it wakes up is not a paced frame
+        started_ = false;
+        return;
+    }
+
+    auto period = GetPeriod();
+    auto now = clock::now();
+
+    if (!started_ || period.count() <= 0.0) {
+        deadline_ = now;
+    } else if (now > deadline_ + period) {
+        // A whole frame late, catching up would only render a burst
+        deadline_ = now;
+    }
+
+    // Sleep can overshoot by about a scheduler tick, the rest is spun
+    auto wake = deadline_ - duration_cast<clock::duration>(opts_.SpinMargin);
+    if (now < wake) {
+        std::this_thread::sleep_until(wake);
+
+        auto slept = clock::now();
+        sleepMs_ += duration_cast<double_ms>(slept - now).count();
+        now = slept;
+    }
+
+    if (now < deadline_) {
+        auto spun = now;
+        while ((now = clock::now()) < deadline_) {
+            std::this_thread::yield();
+        }
+        spinMs_ += duration_cast<double_ms>(now - spun).count();
+    }
+
+    startFrame(now);
+
+    deadline_ += duration_cast<clock::duration>(period);
+}
+
+FramePacer::double_ms FramePacer::GetPeriod() const
+{
+    double rate = 0.0;
+
+    switch (opts_.Mode)
+    {
+    case PacingMode::Fixed:
+        rate = opts_.TargetRate;
+        break;
+    case PacingMode::VSync:
+    case PacingMode::AdaptiveVSync:
+        // Only a rate the swap won't already hold to needs pacing
+        if (opts_.TargetRate > 0.0 && (displayRate_ <= 0.0 || opts_.TargetRate < displayRate_ - 1.0)) {
+            rate = opts_.TargetRate;
+        }
+        break;
+    default:
+        break;
+    }
+
+    return (rate > 0.0 ? double_ms(1000.0 / rate) : double_ms(0.0));
+}
+
+FramePacer::Stats FramePacer::GetStats() const
+{
+    Stats stats;
+    stats.Frames = frames_;
+    stats.SleepMs = sleepMs_;
+    stats.SpinMs = spinMs_;
+    stats.MaxErrorMs = maxError_;
+
+    if (frames_ > 0) {
+        stats.AverageMs = sum_ / frames_;
+        stats.JitterMs = std::sqrt(std::max(0.0, sumSquares_ / frames_ - stats.AverageMs * stats.AverageMs));
+    }
+
+    return stats;
+}
+
+void FramePacer::ResetStats()
+{
+    frames_ = 0;
+    sum_ = 0.0;
+    sumSquares_ = 0.0;
+    maxError_ = 0.0;
+    sleepMs_ = 0.0;
+    spinMs_ = 0.0;
+}
+
+void FramePacer::startFrame(clock::time_point now)
+{
+    using namespace std::chrono;
+
+    if (started_) {
+        double interval = duration_cast<double_ms>(now - lastFrame_).count();
+
+        ++frames_;
+        sum_ += interval;
+        sumSquares_ += interval * interval;
+
+        double period = GetPeriod().count();
+        if (period > 0.0) {
+            maxError_ = std::max(maxError_, std::abs(interval - period));
+        }
+    }
+
+    lastFrame_ = now;
+    started_ = true;
+}
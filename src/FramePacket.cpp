@@ -0,0 +1,66 @@
+#include <FramePacket.hpp>
+
+bool FramePacketExchange::Publish()
+{
+    uint8_t previous = latest_.exchange(back_ | Fresh, std::memory_order_acq_rel);
+    back_ = (previous & IndexMask);
+
+    notify();
+
+    return !(previous & Fresh);
+}
+
+bool FramePacketExchange::WaitTaken()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this]() {
+        return closed_.load(std::memory_order_acquire)
+            || !(latest_.load(std::memory_order_acquire) & Fresh);
+    });
+
+    return !closed_.load(std::memory_order_acquire);
+}
+
+const FramePacket * FramePacketExchange::Take(double_ms timeout)
+{
+    auto ready = [this]() {
+        return closed_.load(std::memory_order_acquire)
+            || (latest_.load(std::memory_order_acquire) & Fresh);
+    };
+
+    if (!ready()) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!cond_.wait_for(lock, timeout, ready)) {
+            return nullptr;
+        }
+    }
+
+    if (closed_.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    // Only this thread clears Fresh, so the latest packet is still new
+    uint8_t previous = latest_.exchange(front_, std::memory_order_acq_rel);
+    front_ = (previous & IndexMask);
+
+    notify();
+
+    return &packets_[front_];
+}
+
+void FramePacketExchange::Close()
+{
+    closed_.store(true, std::memory_order_release);
+
+    notify();
+}
+
+void FramePacketExchange::notify()
+{
+    // Taking the lock orders this after a sleeper's check of its predicate
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+
+    cond_.notify_all();
+}
@@ -0,0 +1,260 @@
+#include <GeometryArena.hpp>
+
+#include <Log.hpp>
+#include <Mesh.hpp>
+#include <StagingBuffer.hpp>
+
+#include <algorithm>
+#include <cstddef>
+
+GeometryArena * GeometryArena::Inst()
+{
+    static GeometryArena arena;
+    return &arena;
+}
+
+GeometryArena::~GeometryArena()
+{
+    Shutdown();
+}
+
+void GeometryArena::Shutdown()
+{
+    for (auto& page : pages_) {
+        glDeleteVertexArrays(1, &page->VAO);
+        glDeleteBuffers(1, &page->VBO);
+        glDeleteBuffers(1, &page->IBO);
+    }
+
+    pages_.clear();
+}
+
+bool GeometryArena::FreeList::Allocate(uint32_t size, uint32_t& offset)
+{
+    for (auto it = blocks_.begin(); it != blocks_.end(); ++it) {
+        if (it->second >= size) {
+            offset = it->first;
+
+            uint32_t remaining = it->second - size;
+            blocks_.erase(it);
+            if (remaining > 0) {
+                blocks_[offset + size] = remaining;
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void GeometryArena::FreeList::Free(uint32_t offset, uint32_t size)
+{
+    auto it = blocks_.emplace(offset, size).first;
+
+    auto next = std::next(it);
+    if (next != blocks_.end() && it->first + it->second == next->first) {
+        it->second += next->second;
+        blocks_.erase(next);
+    }
+
+    if (it != blocks_.begin()) {
+        auto prev = std::prev(it);
+        if (prev->first + prev->second == it->first) {
+            prev->second += it->second;
+            blocks_.erase(it);
+        }
+    }
+}
+
+uint32_t GeometryArena::FreeList::GetFree() const
+{
+    uint32_t total = 0;
+    for (const auto& block : blocks_) {
+        total += block.second;
+    }
+    return total;
+}
+
+uint32_t GeometryArena::FreeList::GetLargest() const
+{
+    uint32_t largest = 0;
+    for (const auto& block : blocks_) {
+        largest = std::max(largest, block.second);
+    }
+    return largest;
+}
+
+int GeometryArena::createPage(uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+    pages_.push_back(std::unique_ptr<Page>(new Page{
+        0, 0, 0,
+        vertexCapacity,
+        indexCapacity,
+        FreeList(vertexCapacity),
+        FreeList(indexCapacity),
+    }));
+    auto& page = pages_.back();
+
+    glGenVertexArrays(1, &page->VAO);
+    glBindVertexArray(page->VAO);
+
+    glGenBuffers(1, &page->VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, page->VBO);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertexCapacity * sizeof(Vertex), nullptr, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &page->IBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page->IBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)indexCapacity * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(Mesh::AttributeID::POSITION);
+    glVertexAttribPointer(Mesh::AttributeID::POSITION, 3, GL_FLOAT, GL_FALSE,
+        sizeof(Vertex), (void *)offsetof(Vertex, Position));
+
+    glEnableVertexAttribArray(Mesh::AttributeID::NORMAL);
+    glVertexAttribPointer(Mesh::AttributeID::NORMAL, 3, GL_FLOAT, GL_FALSE,
+        sizeof(Vertex), (void *)offsetof(Vertex, Normal));
+
+    glEnableVertexAttribArray(Mesh::AttributeID::UV);
+    glVertexAttribPointer(Mesh::AttributeID::UV, 2, GL_FLOAT, GL_FALSE,
+        sizeof(Vertex), (void *)offsetof(Vertex, UV));
+
+    glEnableVertexAttribArray(Mesh::AttributeID::TANGENT);
+    glVertexAttribPointer(Mesh::AttributeID::TANGENT, 4, GL_FLOAT, GL_FALSE,
+        sizeof(Vertex), (void *)offsetof(Vertex, Tangent));
+
+    glBindVertexArray(0);
+
+    LogVerbose("GeometryArena page %zu, %u vertices, %u indices",
+        pages_.size() - 1, vertexCapacity, indexCapacity);
+
+    return (int)pages_.size() - 1;
+}
+
+GeometryArena::Allocation GeometryArena::Allocate(uint32_t vertexCount, uint32_t indexCount)
+{
+    Allocation alloc;
+    alloc.VertexCount = vertexCount;
+    alloc.IndexCount = indexCount;
+
+    if (vertexCount == 0 || indexCount == 0) {
+        return alloc;
+    }
+
+    for (size_t i = 0; i < pages_.size(); ++i) {
+        auto& page = pages_[i];
+
+        uint32_t vertexOffset;
+        if (!page->Vertices.Allocate(vertexCount, vertexOffset)) {
+            continue;
+        }
+
+        uint32_t indexOffset;
+        if (!page->Indices.Allocate(indexCount, indexOffset)) {
+            page->Vertices.Free(vertexOffset, vertexCount);
+            continue;
+        }
+
+        alloc.Page = (int)i;
+        alloc.VertexOffset = vertexOffset;
+        alloc.IndexOffset = indexOffset;
+        return alloc;
+    }
+
+    // Oversized meshes get a page of their own, sized to fit
+    int index = createPage(
+        std::max(vertexCount, nextPageVertices_),
+        std::max(indexCount, nextPageIndices_));
+
+    nextPageVertices_ = (uint32_t)std::min<uint64_t>((uint64_t)nextPageVertices_ * 2, pageVertices_);
+    nextPageIndices_ = (uint32_t)std::min<uint64_t>((uint64_t)nextPageIndices_ * 2, pageIndices_);
+
+    auto& page = pages_[index];
+    page->Vertices.Allocate(vertexCount, alloc.VertexOffset);
+    page->Indices.Allocate(indexCount, alloc.IndexOffset);
+    alloc.Page = index;
+
+    return alloc;
+}
+
+void GeometryArena::Free(const Allocation& alloc)
+{
+    if (alloc.Page < 0 || alloc.Page >= (int)pages_.size()) {
+        return;
+    }
+
+    auto& page = pages_[alloc.Page];
+    page->Vertices.Free(alloc.VertexOffset, alloc.VertexCount);
+    page->Indices.Free(alloc.IndexOffset, alloc.IndexCount);
+}
+
+void GeometryArena::Upload(const Allocation& alloc, const Vertex * vertices, const uint32_t * indices)
+{
+    if (alloc.Page < 0) {
+        return;
+    }
+
+    auto& page = pages_[alloc.Page];
+
+    // Staged copies use neutral targets and keep whatever VAO is bound intact
+    auto staging = StagingBuffer::Inst();
+
+    staging->Upload(page->VBO,
+        (size_t)alloc.VertexOffset * sizeof(Vertex),
+        vertices,
+        (size_t)alloc.VertexCount * sizeof(Vertex));
+
+    staging->Upload(page->IBO,
+        (size_t)alloc.IndexOffset * sizeof(uint32_t),
+        indices,
+        (size_t)alloc.IndexCount * sizeof(uint32_t));
+}
+
+GLuint GeometryArena::GetVAO(int page) const
+{
+    return pages_[page]->VAO;
+}
+
+GLuint GeometryArena::GetVertexBuffer(int page) const
+{
+    return pages_[page]->VBO;
+}
+
+GLuint GeometryArena::GetIndexBuffer(int page) const
+{
+    return pages_[page]->IBO;
+}
+
+GeometryArena::Stats GeometryArena::GetStats() const
+{
+    Stats stats;
+    stats.Pages = pages_.size();
+
+    size_t freeBytes = 0;
+    size_t largestSum = 0;
+    for (const auto& page : pages_) {
+        size_t vertexFree = (size_t)page->Vertices.GetFree() * sizeof(Vertex);
+        size_t indexFree = (size_t)page->Indices.GetFree() * sizeof(uint32_t);
+
+        stats.ReservedBytes += (size_t)page->VertexCapacity * sizeof(Vertex);
+        stats.ReservedBytes += (size_t)page->IndexCapacity * sizeof(uint32_t);
+
+        freeBytes += vertexFree + indexFree;
+
+        stats.FreeBlocks += page->Vertices.GetBlockCount() + page->Indices.GetBlockCount();
+
+        size_t vertexLargest = (size_t)page->Vertices.GetLargest() * sizeof(Vertex);
+        size_t indexLargest = (size_t)page->Indices.GetLargest() * sizeof(uint32_t);
+
+        stats.LargestFreeBytes = std::max(stats.LargestFreeBytes, std::max(vertexLargest, indexLargest));
+        largestSum += vertexLargest + indexLargest;
+    }
+
+    stats.UsedBytes = stats.ReservedBytes - freeBytes;
+
+    if (freeBytes > 0) {
+        stats.Fragmentation = 1.f - (float)largestSum / (float)freeBytes;
+    }
+
+    return stats;
+}
@@ -0,0 +1,175 @@
+#include <ImageDecoder.hpp>
+
+#include <Log.hpp>
+#include <MappedFile.hpp>
+#include <Program.hpp>
+
+#include <algorithm>
+
+#include <stb/stb_image.h>
+
+namespace {
+
+// Bytes a decode keeps alive. Containers are kept as stored, so they cost
+// their file size.
+size_t getDecodedBytes(const ImageDecoder::Source& source)
+{
+    if (source.Container) {
+        if (source.Filename.empty()) {
+            return source.Size;
+        }
+
+        MappedFile file;
+        return (file.Open(source.Filename) ? file.GetSize() : 0);
+    }
+
+    // Reading the header is cheap and tells us how much the decode will cost
+    glm::ivec2 size;
+    int comp = 0;
+    int ok = 0;
+    if (!source.Filename.empty()) {
+        ok = stbi_info(source.Filename.c_str(), &size.x, &size.y, &comp);
+    } else if (source.Data) {
+        ok = stbi_info_from_memory(source.Data, (int)source.Size, &size.x, &size.y, &comp);
+    }
+
+    return (ok ? (size_t)size.x * (size_t)size.y * STBI_rgb_alpha : 0);
+}
+
+} // namespace
+
+ImageDecoder::ImageDecoder(std::vector<Source> sources,
+    size_t memoryBudget /*= DefaultMemoryBudget*/,
+    JobSystem * jobs /*= nullptr*/)
+    : jobs_(jobs ? jobs : Program::GetJobSystem())
+    , sources_(std::move(sources))
+    , images_(sources_.size())
+    , imageBytes_(sources_.size(), 0)
+    , decoded_(new JobCounter[sources_.size()])
+    , memoryBudget_(memoryBudget)
+{
+    for (size_t i = 0; i < sources_.size(); ++i) {
+        imageBytes_[i] = getDecodedBytes(sources_[i]);
+        jobs_->Hold(decoded_[i]);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    schedule();
+}
+
+ImageDecoder::~ImageDecoder()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+
+        for (; nextTicket_ < sources_.size(); ++nextTicket_) {
+            jobs_->Release(decoded_[nextTicket_]);
+        }
+    }
+
+    for (size_t i = 0; i < sources_.size(); ++i) {
+        jobs_->Wait(decoded_[i]);
+    }
+
+    for (auto& image : images_) {
+        freeImage(image);
+    }
+}
+
+const ImageDecoder::Image& ImageDecoder::Wait(size_t index)
+{
+    jobs_->Wait(decoded_[index]);
+    return images_[index];
+}
+
+void ImageDecoder::Release(size_t index)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    freeImage(images_[index]);
+
+    bytesInFlight_ -= imageBytes_[index];
+    imageBytes_[index] = 0;
+
+    schedule();
+}
+
+void ImageDecoder::schedule()
+{
+    while (!cancelled_ && nextTicket_ < sources_.size()) {
+        size_t index = nextTicket_;
+        size_t bytes = imageBytes_[index];
+        if (bytesInFlight_ > 0 && bytesInFlight_ + bytes > memoryBudget_) {
+            return;
+        }
+
+        ++nextTicket_;
+        bytesInFlight_ += bytes;
+        peakBytes_ = std::max(peakBytes_, bytesInFlight_);
+
+        // Counted by the job before the hold goes, so waiters never see zero
+        jobs_->Submit([this, index]() { decode(index); }, &decoded_[index]);
+        jobs_->Release(decoded_[index]);
+    }
+}
+
+void ImageDecoder::freeImage(Image& image)
+{
+    if (image.Data) {
+        stbi_image_free(image.Data);
+        image.Data = nullptr;
+    }
+
+    delete image.Container;
+    image.Container = nullptr;
+}
+
+void ImageDecoder::decode(size_t index)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cancelled_) {
+            return;
+        }
+    }
+
+    const auto& source = sources_[index];
+
+    Image image;
+    if (source.Container) {
+        MappedFile file;
+        const uint8_t * data = source.Data;
+        size_t size = source.Size;
+        if (!source.Filename.empty()) {
+            data = (file.Open(source.Filename) ? file.GetData() : nullptr);
+            size = file.GetSize();
+        }
+
+        auto container = new TextureContainer();
+        if (data && ParseTextureContainer(data, size, *container)) {
+            image.Size = container->Size;
+            image.Container = container;
+        } else {
+            LogError("Failed to read texture container %zu", index);
+            delete container;
+        }
+    } else {
+        if (!source.Filename.empty()) {
+            image.Data = stbi_load(source.Filename.c_str(),
+                &image.Size.x, &image.Size.y, &image.Components, STBI_rgb_alpha);
+        } else if (source.Data) {
+            image.Data = stbi_load_from_memory(source.Data, (int)source.Size,
+                &image.Size.x, &image.Size.y, &image.Components, STBI_rgb_alpha);
+        }
+        image.Components = STBI_rgb_alpha;
+
+        // Sources with nothing to decode are skipped on purpose
+        if (!image.Data && (source.Data || !source.Filename.empty())) {
+            LogError("Failed to decode image %zu, %s", index, stbi_failure_reason());
+        }
+    }
+
+    // Waiters only read it once the job finished
+    images_[index] = image;
+}
@@ -0,0 +1,326 @@
+#include <JobSystem.hpp>
+
+#include <algorithm>
+
+namespace {
+
+// The system the calling thread is a worker of, and its deque there
+thread_local const JobSystem * t_system = nullptr;
+thread_local size_t t_index = 0;
+
+}
+
+JobSystem::JobSystem(unsigned workerCount /*= 0*/)
+    : mainThread_(std::this_thread::get_id())
+{
+    if (workerCount == 0) {
+        workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+
+    queues_.reserve(workerCount + 1);
+    for (unsigned i = 0; i <= workerCount; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+
+    threads_.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; ++i) {
+        threads_.emplace_back(&JobSystem::workerLoop, this, (size_t)i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    cond_.notify_all();
+
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void JobSystem::Submit(std::function<void()> job, JobCounter * counter /*= nullptr*/)
+{
+    if (counter) {
+        counter->pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    push(Job{ std::move(job), counter });
+}
+
+void JobSystem::Submit(std::function<void()> job, JobCounter * counter, JobCounter& after)
+{
+    if (counter) {
+        counter->pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    {
+        // finish() takes the lock for the last decrement, so after either
+        // still counts and queues the job later or is already done
+        std::lock_guard<std::mutex> lock(after.mutex_);
+        if (after.pending_.load(std::memory_order_acquire) > 0) {
+            after.waiting_.emplace_back(std::move(job), counter);
+            return;
+        }
+    }
+
+    push(Job{ std::move(job), counter });
+}
+
+void JobSystem::Hold(JobCounter& counter)
+{
+    counter.pending_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void JobSystem::Release(JobCounter& counter)
+{
+    finish(&counter);
+}
+
+void JobSystem::SubmitMain(std::function<void()> job, JobCounter * counter /*= nullptr*/)
+{
+    if (counter) {
+        counter->pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mainMutex_);
+        mainJobs_.push_back(Job{ std::move(job), counter });
+    }
+    mainQueued_.fetch_add(1, std::memory_order_release);
+
+    // The main thread may be sleeping in Wait
+    notify(true);
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+    const size_t index = getQueueIndex();
+    const bool main = IsMainThread();
+
+    while (!counter.IsDone()) {
+        if (main && RunMainJob()) {
+            continue;
+        }
+
+        if (tryRun(index)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        cond_.wait(lock, [&]() {
+            return counter.IsDone()
+                || queued_.load(std::memory_order_acquire) > 0
+                || (main && HasMainJobs());
+        });
+    }
+
+    // The last job may still be unlocking the counter
+    std::lock_guard<std::mutex> lock(counter.mutex_);
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& fn)
+{
+    if (count == 0) {
+        return;
+    }
+
+    if (grain == 0) {
+        size_t ranges = (threads_.size() + 1) * 4;
+        grain = std::max<size_t>(1, (count + ranges - 1) / ranges);
+    }
+
+    if (count <= grain) {
+        fn(0, count);
+        return;
+    }
+
+    JobCounter counter;
+
+    // The calling thread takes the first range itself
+    for (size_t begin = grain; begin < count; begin += grain) {
+        size_t end = std::min(count, begin + grain);
+        Submit([&fn, begin, end]() { fn(begin, end); }, &counter);
+    }
+
+    fn(0, grain);
+
+    Wait(counter);
+}
+
+bool JobSystem::RunMainJob()
+{
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(mainMutex_);
+        if (mainJobs_.empty()) {
+            return false;
+        }
+
+        job = std::move(mainJobs_.front());
+        mainJobs_.pop_front();
+    }
+    mainQueued_.fetch_sub(1, std::memory_order_relaxed);
+
+    run(job, *queues_.back(), false);
+
+    return true;
+}
+
+JobSystem::Stats JobSystem::GetStats() const
+{
+    Stats stats;
+    for (const auto& queue : queues_) {
+        stats.Executed += queue->Executed.load(std::memory_order_relaxed);
+        stats.Stolen += queue->Stolen.load(std::memory_order_relaxed);
+    }
+
+    return stats;
+}
+
+void JobSystem::ResetStats()
+{
+    for (auto& queue : queues_) {
+        queue->Executed.store(0, std::memory_order_relaxed);
+        queue->Stolen.store(0, std::memory_order_relaxed);
+    }
+}
+
+void JobSystem::workerLoop(size_t index)
+{
+    t_system = this;
+    t_index = index;
+
+    for (;;) {
+        if (tryRun(index)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        cond_.wait(lock, [this]() { return stopping_ || queued_.load(std::memory_order_acquire) > 0; });
+
+        // Queued jobs still run before stopping so owners can rely on completion
+        if (stopping_ && queued_.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+void JobSystem::push(Job job)
+{
+    auto& queue = *queues_[getQueueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        queue.Jobs.push_back(std::move(job));
+        queued_.fetch_add(1, std::memory_order_release);
+    }
+
+    notify(false);
+}
+
+bool JobSystem::tryRun(size_t index)
+{
+    const size_t count = queues_.size();
+    const size_t shared = count - 1;
+
+    Job job;
+
+    // The own deque first, newest first for workers as it's still in cache.
+    // Non workers share theirs and take the oldest, in submission order.
+    {
+        auto& own = *queues_[index];
+        std::lock_guard<std::mutex> lock(own.Mutex);
+        if (!own.Jobs.empty()) {
+            if (index == shared) {
+                job = std::move(own.Jobs.front());
+                own.Jobs.pop_front();
+            } else {
+                job = std::move(own.Jobs.back());
+                own.Jobs.pop_back();
+            }
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Then oldest first from the shared deque and the other workers',
+    // starting after the own one so thieves spread out
+    bool stolen = false;
+    for (size_t i = 0; i < count && !job.Func; ++i) {
+        size_t victim = (i == 0 ? shared : (index + i) % count);
+        if (victim == index || (i > 0 && victim == shared)) {
+            continue;
+        }
+
+        auto& queue = *queues_[victim];
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        if (!queue.Jobs.empty()) {
+            job = std::move(queue.Jobs.front());
+            queue.Jobs.pop_front();
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            stolen = (victim != shared);
+        }
+    }
+
+    if (!job.Func) {
+        return false;
+    }
+
+    run(job, *queues_[index], stolen);
+
+    return true;
+}
+
+void JobSystem::run(Job& job, Queue& queue, bool stolen)
+{
+    job.Func();
+
+    queue.Executed.fetch_add(1, std::memory_order_relaxed);
+    if (stolen) {
+        queue.Stolen.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (job.Counter) {
+        finish(job.Counter);
+    }
+}
+
+void JobSystem::finish(JobCounter * counter)
+{
+    std::vector<std::pair<std::function<void()>, JobCounter *>> waiting;
+    {
+        std::lock_guard<std::mutex> lock(counter->mutex_);
+        if (counter->pending_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+
+        waiting.swap(counter->waiting_);
+    }
+
+    // counter may be gone already, Wait returned once the lock was released
+    for (auto& [func, next] : waiting) {
+        push(Job{ std::move(func), next });
+    }
+
+    notify(true);
+}
+
+void JobSystem::notify(bool all)
+{
+    // Taking the lock orders this after a sleeper's check of its predicate
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+
+    if (all) {
+        cond_.notify_all();
+    } else {
+        cond_.notify_one();
+    }
+}
+
+size_t JobSystem::getQueueIndex() const
+{
+    return (t_system == this ? t_index : queues_.size() - 1);
+}
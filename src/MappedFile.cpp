@@ -0,0 +1,101 @@
+#include <MappedFile.hpp>
+
+#if defined(WIN32)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+bool MappedFile::Open(const std::string& filename)
+{
+    Close();
+
+#if defined(WIN32)
+
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void * data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    file_ = file;
+    mapping_ = mapping;
+    data_ = reinterpret_cast<const uint8_t *>(data);
+    size_ = (size_t)size.QuadPart;
+
+#else
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void * data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping keeps its own reference to the file
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    data_ = reinterpret_cast<const uint8_t *>(data);
+    size_ = (size_t)st.st_size;
+
+#endif
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (!data_) {
+        return;
+    }
+
+#if defined(WIN32)
+
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+    CloseHandle(file_);
+
+    file_ = nullptr;
+    mapping_ = nullptr;
+
+#else
+
+    munmap(const_cast<uint8_t *>(data_), size_);
+
+#endif
+
+    data_ = nullptr;
+    size_ = 0;
+}
@@ -0,0 +1,17 @@
+#include <Material.hpp>
+
+#include <Texture.hpp>
+#include <TextureBinder.hpp>
+
+void Material::Bind(GLuint firstUnit /*= 0*/) const
+{
+    const Texture * textures[MapCount] = {
+        BaseColorMap.Source.get(),
+        MetallicRoughnessMap.Source.get(),
+        NormalMap.Source.get(),
+        OcclusionMap.Source.get(),
+        EmissiveMap.Source.get(),
+    };
+
+    TextureBinder::Inst()->Bind(firstUnit, MapCount, textures);
+}
@@ -0,0 +1,38 @@
+#include <Mesh.hpp>
+
+Mesh::BufferSet::~BufferSet()
+{
+    if (!Names.empty()) {
+        // Names never uploaded are still 0, which glDeleteBuffers ignores
+        glDeleteBuffers((GLsizei)Names.size(), Names.data());
+    }
+}
+
+Mesh::~Mesh()
+{
+    for (const auto& primitive : primitives_) {
+        GeometryArena::Inst()->Free(primitive.Allocation);
+
+        // Arena pages share their VAO, own ones belong to the primitive
+        if (primitive.Buffers && primitive.VAO) {
+            glDeleteVertexArrays(1, &primitive.VAO);
+        }
+    }
+}
+
+void Mesh::Render()
+{
+    GLuint vao = 0;
+    for (const auto& primitive : primitives_) {
+        // Primitives sharing an arena page share the VAO too
+        if (primitive.VAO != vao) {
+            vao = primitive.VAO;
+            glBindVertexArray(vao);
+        }
+
+        glDrawElementsBaseVertex(primitive.Mode, primitive.Count, primitive.Type,
+            (void *)(intptr_t)primitive.Offset, primitive.BaseVertex);
+    }
+
+    glBindVertexArray(0);
+}
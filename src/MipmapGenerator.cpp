@@ -0,0 +1,407 @@
+#include <MipmapGenerator.hpp>
+
+#include <Program.hpp>
+#include <TextureEncoder.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define GLBP_MIPMAP_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace {
+
+// One linear RGBA texel, a single SSE register where there is one
+struct texel_t {
+#if defined(GLBP_MIPMAP_SSE2)
+    __m128 v;
+#else
+    float v[4];
+#endif
+};
+
+#if defined(GLBP_MIPMAP_SSE2)
+
+inline texel_t texelZero() {
+    return texel_t{ _mm_setzero_ps() };
+}
+
+inline texel_t texelSet(float r, float g, float b, float a) {
+    return texel_t{ _mm_setr_ps(r, g, b, a) };
+}
+
+// acc + t * w
+inline texel_t texelMulAdd(texel_t acc, texel_t t, float w) {
+    return texel_t{ _mm_add_ps(acc.v, _mm_mul_ps(t.v, _mm_set1_ps(w))) };
+}
+
+inline texel_t texelAverage(texel_t a, texel_t b, texel_t c, texel_t d) {
+    __m128 sum = _mm_add_ps(_mm_add_ps(a.v, b.v), _mm_add_ps(c.v, d.v));
+    return texel_t{ _mm_mul_ps(sum, _mm_set1_ps(0.25f)) };
+}
+
+// Clamped to [0, 1]
+inline void texelStore(texel_t t, float out[4]) {
+    _mm_storeu_ps(out, _mm_min_ps(_mm_max_ps(t.v, _mm_setzero_ps()), _mm_set1_ps(1.f)));
+}
+
+#else
+
+inline texel_t texelZero() {
+    return texel_t{ { 0.f, 0.f, 0.f, 0.f } };
+}
+
+inline texel_t texelSet(float r, float g, float b, float a) {
+    return texel_t{ { r, g, b, a } };
+}
+
+inline texel_t texelMulAdd(texel_t acc, texel_t t, float w) {
+    for (int i = 0; i < 4; ++i) {
+        acc.v[i] += t.v[i] * w;
+    }
+    return acc;
+}
+
+inline texel_t texelAverage(texel_t a, texel_t b, texel_t c, texel_t d) {
+    texel_t out;
+    for (int i = 0; i < 4; ++i) {
+        out.v[i] = (a.v[i] + b.v[i] + c.v[i] + d.v[i]) * 0.25f;
+    }
+    return out;
+}
+
+inline void texelStore(texel_t t, float out[4]) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = std::min(std::max(t.v[i], 0.f), 1.f);
+    }
+}
+
+#endif
+
+const int KaiserTaps = 8;
+
+// Steps in the linear to sRGB table, enough for every 8 bit output to
+// round the same as the exact curve away from black
+const int LinearSteps = 4096;
+
+struct tables_t {
+    float toLinear[256];
+    float unorm[256];
+    uint8_t toSRGB[LinearSteps + 1];
+};
+
+const tables_t& getTables()
+{
+    static const tables_t tables = []() {
+        tables_t t;
+        for (int i = 0; i < 256; ++i) {
+            float c = i / 255.f;
+            t.toLinear[i] = (c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f));
+            t.unorm[i] = c;
+        }
+        for (int i = 0; i <= LinearSteps; ++i) {
+            float l = (float)i / LinearSteps;
+            float c = (l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.f / 2.4f) - 0.055f);
+            t.toSRGB[i] = (uint8_t)std::lround(c * 255.f);
+        }
+        return t;
+    }();
+    return tables;
+}
+
+// Weights for halving, taps 2x-3 to 2x+4 of the source for texel x
+void getKaiserWeights(float weights[KaiserTaps])
+{
+    const float Pi = 3.14159265f;
+    const float Beta = 4.f;
+    const float Radius = KaiserTaps / 2.f;
+
+    // Zeroth order modified Bessel function of the first kind
+    auto bessel = [](float x) {
+        float sum = 1.f;
+        float term = 1.f;
+        for (int k = 1; k < 16; ++k) {
+            term *= (x / (2.f * k)) * (x / (2.f * k));
+            sum += term;
+        }
+        return sum;
+    };
+
+    float total = 0.f;
+    for (int i = 0; i < KaiserTaps; ++i) {
+        // Distance from the destination texel's centre in source texels
+        float d = (i - 3) + 0.5f - 1.f;
+        float x = d / 2.f;
+
+        float sinc = (x == 0.f ? 1.f : std::sin(Pi * x) / (Pi * x));
+        float r = d / Radius;
+        float window = bessel(Beta * std::sqrt(std::max(0.f, 1.f - r * r))) / bessel(Beta);
+
+        weights[i] = sinc * window;
+        total += weights[i];
+    }
+
+    for (int i = 0; i < KaiserTaps; ++i) {
+        weights[i] /= total;
+    }
+}
+
+// Source of a level, either the original bytes or the last level filtered
+struct level_t {
+    glm::ivec2 size;
+    const uint8_t * bytes = nullptr;
+    const texel_t * texels = nullptr;
+    bool srgb = false;
+};
+
+// The row as linear texels, straight from the level when it already is
+const texel_t * getRow(const level_t& level, int y, texel_t * scratch)
+{
+    if (level.texels) {
+        return level.texels + (size_t)y * level.size.x;
+    }
+
+    const auto& tables = getTables();
+    const float * rgb = (level.srgb ? tables.toLinear : tables.unorm);
+
+    const uint8_t * in = level.bytes + (size_t)y * level.size.x * 4;
+    for (int x = 0; x < level.size.x; ++x, in += 4) {
+        scratch[x] = texelSet(rgb[in[0]], rgb[in[1]], rgb[in[2]], tables.unorm[in[3]]);
+    }
+
+    return scratch;
+}
+
+// Calls fn for every row in [0, count) with a scratch buffer of scratchSize
+// texels per range of rows. Small levels aren't worth splitting up.
+void forEachRow(
+    JobSystem * jobs,
+    int count,
+    size_t rowTexels,
+    size_t scratchSize,
+    const std::function<void(int, std::vector<texel_t>&)>& fn)
+{
+    const size_t MinTexelsPerRange = 16384;
+
+    size_t ranges = ((size_t)jobs->GetWorkerCount() + 1) * 4;
+    size_t grain = std::max(((size_t)count + ranges - 1) / ranges,
+        MinTexelsPerRange / std::max<size_t>(1, rowTexels));
+
+    jobs->ParallelFor((size_t)count, std::max<size_t>(1, grain), [&](size_t begin, size_t end) {
+        std::vector<texel_t> scratch(scratchSize);
+        for (size_t row = begin; row < end; ++row) {
+            fn((int)row, scratch);
+        }
+    });
+}
+
+// 2x2 box filter, odd edges reuse the last row or column
+void filterBox(const level_t& src, texel_t * dst, glm::ivec2 dstSize, JobSystem * jobs)
+{
+    forEachRow(jobs, dstSize.y, (size_t)dstSize.x * 4, (size_t)src.size.x * 2,
+        [&](int y, std::vector<texel_t>& scratch) {
+            const texel_t * a = getRow(src, std::min(y * 2, src.size.y - 1), scratch.data());
+            const texel_t * b = getRow(src, std::min(y * 2 + 1, src.size.y - 1), scratch.data() + src.size.x);
+
+            texel_t * out = dst + (size_t)y * dstSize.x;
+            for (int x = 0; x < dstSize.x; ++x) {
+                int x0 = std::min(x * 2, src.size.x - 1);
+                int x1 = std::min(x * 2 + 1, src.size.x - 1);
+                out[x] = texelAverage(a[x0], a[x1], b[x0], b[x1]);
+            }
+        });
+}
+
+// Separable, every source row is filtered horizontally into tmp first and
+// then columns of tmp vertically. Taps past the edges clamp.
+void filterKaiser(const level_t& src, texel_t * dst, glm::ivec2 dstSize, std::vector<texel_t>& tmp, JobSystem * jobs)
+{
+    float weights[KaiserTaps];
+    getKaiserWeights(weights);
+
+    tmp.resize((size_t)src.size.y * dstSize.x);
+
+    forEachRow(jobs, src.size.y, (size_t)dstSize.x * KaiserTaps, (size_t)src.size.x,
+        [&](int y, std::vector<texel_t>& scratch) {
+            const texel_t * in = getRow(src, y, scratch.data());
+
+            texel_t * out = tmp.data() + (size_t)y * dstSize.x;
+            for (int x = 0; x < dstSize.x; ++x) {
+                texel_t acc = texelZero();
+                for (int i = 0; i < KaiserTaps; ++i) {
+                    int sx = std::min(std::max(x * 2 - 3 + i, 0), src.size.x - 1);
+                    acc = texelMulAdd(acc, in[sx], weights[i]);
+                }
+                out[x] = acc;
+            }
+        });
+
+    forEachRow(jobs, dstSize.y, (size_t)dstSize.x * KaiserTaps, 0,
+        [&](int y, std::vector<texel_t>&) {
+            const texel_t * rows[KaiserTaps];
+            for (int i = 0; i < KaiserTaps; ++i) {
+                int sy = std::min(std::max(y * 2 - 3 + i, 0), src.size.y - 1);
+                rows[i] = tmp.data() + (size_t)sy * dstSize.x;
+            }
+
+            texel_t * out = dst + (size_t)y * dstSize.x;
+            for (int x = 0; x < dstSize.x; ++x) {
+                texel_t acc = texelZero();
+                for (int i = 0; i < KaiserTaps; ++i) {
+                    acc = texelMulAdd(acc, rows[i][x], weights[i]);
+                }
+                out[x] = acc;
+            }
+        });
+}
+
+float getAlpha(texel_t t)
+{
+    float rgba[4];
+    texelStore(t, rgba);
+    return rgba[3];
+}
+
+// Fraction of texels whose scaled alpha passes cutoff
+float getCoverage(const texel_t * texels, size_t count, float cutoff, float scale)
+{
+    size_t covered = 0;
+    for (size_t i = 0; i < count; ++i) {
+        covered += (getAlpha(texels[i]) * scale > cutoff ? 1 : 0);
+    }
+    return (float)covered / count;
+}
+
+// Alpha scale that brings the level's coverage closest to coverage
+float getCoverageScale(const texel_t * texels, size_t count, float cutoff, float coverage)
+{
+    float low = 0.f;
+    float high = 1.f / std::max(cutoff, 1.f / 255.f);
+
+    // Coverage only grows with the scale, so bisect
+    for (int i = 0; i < 12; ++i) {
+        float mid = (low + high) * 0.5f;
+        if (getCoverage(texels, count, cutoff, mid) < coverage) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+
+    // Alpha is often quantized so neither side hits it exactly
+    float lowError = std::abs(getCoverage(texels, count, cutoff, low) - coverage);
+    float highError = std::abs(getCoverage(texels, count, cutoff, high) - coverage);
+    return (lowError < highError ? low : high);
+}
+
+void storeLevel(const texel_t * texels, glm::ivec2 size, bool srgb, float alphaScale, uint8_t * out, JobSystem * jobs)
+{
+    const auto& tables = getTables();
+
+    forEachRow(jobs, size.y, (size_t)size.x, 0,
+        [&](int y, std::vector<texel_t>&) {
+            const texel_t * in = texels + (size_t)y * size.x;
+            uint8_t * row = out + (size_t)y * size.x * 4;
+
+            for (int x = 0; x < size.x; ++x, row += 4) {
+                float rgba[4];
+                texelStore(in[x], rgba);
+
+                for (int i = 0; i < 3; ++i) {
+                    row[i] = (srgb
+                        ? tables.toSRGB[(int)(rgba[i] * LinearSteps + 0.5f)]
+                        : (uint8_t)(rgba[i] * 255.f + 0.5f));
+                }
+
+                row[3] = (uint8_t)(std::min(rgba[3] * alphaScale, 1.f) * 255.f + 0.5f);
+            }
+        });
+}
+
+} // namespace
+
+size_t GetMipChainSize(glm::ivec2 size, int levels)
+{
+    size_t total = 0;
+    for (int i = 0; i < levels; ++i) {
+        total += (size_t)size.x * size.y * 4;
+        size = glm::ivec2(std::max(1, size.x / 2), std::max(1, size.y / 2));
+    }
+    return total;
+}
+
+bool GenerateMipChain(
+    const uint8_t * pixels,
+    glm::ivec2 size,
+    const MipmapOptions& opts,
+    MipChain& out,
+    JobSystem * jobs /*= nullptr*/)
+{
+    if (!pixels || size.x <= 0 || size.y <= 0) {
+        return false;
+    }
+
+    if (!jobs) {
+        jobs = Program::GetJobSystem();
+    }
+
+    out.Size = size;
+    out.Levels = GetMipLevelCount(size);
+    out.Data.resize(GetMipChainSize(size, out.Levels));
+
+    memcpy(out.Data.data(), pixels, (size_t)size.x * size.y * 4);
+
+    float coverage = 0.f;
+    if (opts.AlphaCutoff > 0.f) {
+        size_t covered = 0;
+        size_t count = (size_t)size.x * size.y;
+        for (size_t i = 0; i < count; ++i) {
+            covered += (pixels[i * 4 + 3] / 255.f > opts.AlphaCutoff ? 1 : 0);
+        }
+        coverage = (float)covered / count;
+    }
+
+    level_t src;
+    src.size = size;
+    src.bytes = pixels;
+    src.srgb = opts.SRGB;
+
+    // The previous level stays in floating point so rounding doesn't pile up
+    // down the chain
+    std::vector<texel_t> prev;
+    std::vector<texel_t> next;
+    std::vector<texel_t> tmp;
+
+    uint8_t * levelOut = out.Data.data() + (size_t)size.x * size.y * 4;
+    for (int level = 1; level < out.Levels; ++level) {
+        glm::ivec2 dstSize(std::max(1, src.size.x / 2), std::max(1, src.size.y / 2));
+        size_t count = (size_t)dstSize.x * dstSize.y;
+        next.resize(count);
+
+        if (opts.Filter == MipFilter::Kaiser) {
+            filterKaiser(src, next.data(), dstSize, tmp, jobs);
+        } else {
+            filterBox(src, next.data(), dstSize, jobs);
+        }
+
+        float alphaScale = 1.f;
+        if (opts.AlphaCutoff > 0.f) {
+            alphaScale = getCoverageScale(next.data(), count, opts.AlphaCutoff, coverage);
+        }
+
+        storeLevel(next.data(), dstSize, opts.SRGB, alphaScale, levelOut, jobs);
+        levelOut += count * 4;
+
+        std::swap(prev, next);
+
+        src = level_t();
+        src.size = dstSize;
+        src.texels = prev.data();
+    }
+
+    return true;
+}
@@ -0,0 +1,51 @@
+#include <OverlapMeter.hpp>
+
+#include <algorithm>
+
+void OverlapMeter::Begin(size_t thread)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    start_[thread] = clock::now();
+    busy_[thread] = true;
+}
+
+void OverlapMeter::End(size_t thread)
+{
+    using namespace std::chrono;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!busy_[thread]) {
+        return;
+    }
+
+    auto now = clock::now();
+    stats_.BusyMs[thread] += duration_cast<double_ms>(now - start_[thread]).count();
+
+    // Busy together since whichever started last
+    size_t other = 1 - thread;
+    if (busy_[other]) {
+        stats_.OverlapMs += duration_cast<double_ms>(now - std::max(start_[thread], start_[other])).count();
+    }
+
+    busy_[thread] = false;
+}
+
+OverlapMeter::Stats OverlapMeter::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void OverlapMeter::Reset()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto now = clock::now();
+    for (size_t i = 0; i < 2; ++i) {
+        start_[i] = now;
+    }
+
+    stats_ = Stats();
+}
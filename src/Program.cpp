@@ -1,7 +1,16 @@
 #include <Program.hpp>
 #include <Log.hpp>
-
+#include <FramePacer.hpp>
+#include <GeometryArena.hpp>
+#include <RenderTarget.hpp>
+#include <SamplerCache.hpp>
+#include <StagingBuffer.hpp>
+#include <TextureBinder.hpp>
+#include <TextureStreamer.hpp>
+
+#include <algorithm>
 #include <chrono>
+#include <thread>
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wunused-function"
@@ -16,10 +25,28 @@
 
 #pragma GCC diagnostic pop
 
+Program::Options Program::options_;
+
 void Program::Run() {
+    GetJobSystem();
+
+    const bool headless = options_.Headless;
+
+    // Without a display a headless run falls back to SDL's offscreen
+    // driver, which creates contexts through EGL without any surface
+    bool offscreenDriver = false;
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        LogError("Failed to initialize SDL, %d", SDL_GetError());
-        return;
+        if (!headless) {
+            LogError("Failed to initialize SDL, %s", SDL_GetError());
+            return;
+        }
+
+        LogWarn("Failed to initialize SDL, %s, trying the offscreen driver", SDL_GetError());
+        if (SDL_VideoInit("offscreen") < 0) {
+            LogError("Failed to initialize SDL offscreen driver, %s", SDL_GetError());
+            return;
+        }
+        offscreenDriver = true;
     }
 
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
@@ -28,10 +55,11 @@ void Program::Run() {
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-    SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
+    SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, (headless ? 0 : 1));
 
     sdl_window_ = SDL_CreateWindow("GLBP", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 
-        1024, 768, SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
+        options_.Resolution.x, options_.Resolution.y,
+        SDL_WINDOW_OPENGL | (headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_RESIZABLE));
     if (!sdl_window_) {
         LogError("Failed to create SDL window, %s", SDL_GetError());
         return;
@@ -53,7 +81,15 @@ void Program::Run() {
     LogInfo("OpenGL Vendor %s", glGetString(GL_VENDOR));
     LogInfo("OpenGL Renderer %s", glGetString(GL_RENDERER));
 
-    SDL_GL_SetSwapInterval(1);
+    // Applies the swap interval of the pacing mode now there's a context,
+    // headless frames are never held back
+    auto pacing = frame_pacer_.GetOptions();
+    if (headless) {
+        pacing.Mode = PacingMode::Unlimited;
+    }
+
+    frame_pacer_.SetWindow(sdl_window_);
+    frame_pacer_.SetOptions(pacing);
 
     glEnable(GL_MULTISAMPLE);
 
@@ -65,18 +101,50 @@ void Program::Run() {
 
     glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
 
+    glm::ivec2 viewport;
+    SDL_GetWindowSize(sdl_window_, &viewport.x, &viewport.y);
+
+    // Headless frames go to a framebuffer of the requested size, which
+    // stays bound for the whole run
+    RenderTarget offscreen;
+    if (headless) {
+        if (!offscreen.Create(options_.Resolution)) {
+            return;
+        }
+
+        offscreen.Bind();
+
+        viewport = options_.Resolution;
+        glViewport(0, 0, viewport.x, viewport.y);
+
+        LogInfo("Rendering headless at %dx%d", viewport.x, viewport.y);
+    }
+
+    viewport_ = viewport;
+
+    const bool threaded = options_.ThreadedRender;
+
+    FramePacketExchange exchange;
+
+    // The context can only be current on one thread at a time
+    std::thread renderThread;
+    if (threaded) {
+        SDL_GL_MakeCurrent(sdl_window_, nullptr);
+        renderThread = std::thread(&Program::renderLoop, this, &exchange);
+    }
+
     using namespace std::chrono;
     typedef duration<double, std::milli> double_ms;
 
     unsigned long frames = 0;
+    uint64_t frameIndex = 0;
 
-    double_ms frameDelay = 1000ms / 60.0;
     double_ms fpsDelay = 250ms; // Update FPS 4 times per second
 
-    double_ms frameElap = 0ms;
     double_ms fpsElap = 0ms;
 
     auto timeOffset = high_resolution_clock::now();
+    auto runStart = timeOffset;
 
     SDL_Event evt;
 
@@ -85,6 +153,10 @@ void Program::Run() {
         auto elapsedTime = duration_cast<double_ms>(high_resolution_clock::now() - timeOffset);
         timeOffset = high_resolution_clock::now();
 
+        // Each headless frame is exactly one step, so every run does the
+        // same work however fast the machine is
+        double_ms stepTime = (headless ? simulation_clock_.GetStep() : elapsedTime);
+
         while (SDL_PollEvent(&evt)) {
             switch (evt.type)
             {
@@ -93,24 +165,57 @@ void Program::Run() {
                 break;
             case SDL_WINDOWEVENT:
                 if (evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
-                    glViewport(0, 0, evt.window.data1, evt.window.data2);
+                    viewport = glm::ivec2(evt.window.data1, evt.window.data2);
+                } else if (evt.window.event == SDL_WINDOWEVENT_MOVED) {
+                    // Possibly onto a display with another refresh rate
+                    frame_pacer_.SetWindow(sdl_window_);
                 }
                 break;
             }
         }
 
-        Update();
+        // Nothing is drawn while the window can't be seen, and the loop only
+        // wakes up for input once loading has finished too
+        bool hidden = !headless && (SDL_GetWindowFlags(sdl_window_) & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_HIDDEN)) != 0;
+
+        overlap_.Begin(UpdateThread);
 
-        frameElap += elapsedTime;
-        if (frameDelay <= frameElap) {
-            frameElap = 0ms;
+        int steps = simulation_clock_.Advance(stepTime);
+        double dt = duration_cast<duration<double>>(simulation_clock_.GetStep()).count();
+        for (int i = 0; i < steps; ++i) {
+            Update(dt);
+        }
+
+        if (!threaded) {
+            runFrameTasks();
+        }
+
+        if (!hidden) {
             ++frames;
 
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            FramePacket& packet = exchange.GetBack();
+            packet.Clear();
+            packet.Frame = frameIndex++;
+            packet.Alpha = simulation_clock_.GetAlpha();
+            packet.Viewport = viewport;
+
+            BuildFrame(packet);
 
-            Render();
+            overlap_.End(UpdateThread);
 
-            SDL_GL_SwapWindow(sdl_window_);
+            if (threaded) {
+                exchange.Publish();
+            } else {
+                renderFrame(packet);
+
+                present();
+            }
+
+            if (options_.FrameCount > 0 && frameIndex >= options_.FrameCount) {
+                _running = false;
+            }
+        } else {
+            overlap_.End(UpdateThread);
         }
  
         fpsElap += elapsedTime;
@@ -122,23 +227,190 @@ void Program::Run() {
             sprintf(buffer, "GLBP - %0.2f", fps);
             SDL_SetWindowTitle(sdl_window_, buffer);
 
+            // The binder belongs to the render thread otherwise
+            if (!threaded) {
+                auto binds = TextureBinder::Inst()->GetStats();
+                if (binds.Binds > 0 || binds.Elided > 0) {
+                    LogPerf("Texture binds per frame, %zu issued, %zu elided", binds.Binds, binds.Elided);
+                }
+            }
+
+            auto pacing = frame_pacer_.GetStats();
+            if (pacing.Frames > 0) {
+                LogPerf("Frame time %.2fms, jitter %.3fms, worst %.3fms off target, %.1fms slept, %.1fms spun",
+                    pacing.AverageMs, pacing.JitterMs, pacing.MaxErrorMs, pacing.SleepMs, pacing.SpinMs);
+            }
+            frame_pacer_.ResetStats();
+
+            // Busy time per frame and how much of it the threads hid from
+            // each other, the frame time saved over rendering in line
+            auto overlap = overlap_.GetStats();
+            if (threaded && frames > 0) {
+                LogPerf("Update thread %.2fms, render thread %.2fms, %.2fms overlapped per frame",
+                    overlap.BusyMs[UpdateThread] / frames, overlap.BusyMs[RenderThread] / frames, overlap.OverlapMs / frames);
+            }
+            overlap_.Reset();
+
             frames = 0;
             fpsElap = 0ms;
         }
+
+        if (threaded) {
+            // Stay at most one frame ahead of the render thread
+            if (!hidden) {
+                exchange.WaitTaken();
+            }
+
+            // Main thread tasks are the render thread's to wake up for
+            frame_pacer_.Wait(hidden);
+        } else {
+            frame_pacer_.Wait(hidden && !hasMainThreadTasks());
+        }
     }
-    
+
+    if (threaded) {
+        exchange.Close();
+        renderThread.join();
+
+        SDL_GL_MakeCurrent(sdl_window_, sdl_context_);
+        GetJobSystem()->SetMainThread();
+    }
+
+    if (headless) {
+        // Whatever is still queued counts towards the run
+        glFinish();
+
+        double runMs = duration_cast<double_ms>(high_resolution_clock::now() - runStart).count();
+        LogPerf("Rendered %llu frames at %dx%d in %.1fms, %.3fms per frame",
+            (unsigned long long)frameIndex, viewport.x, viewport.y, runMs, runMs / std::max<uint64_t>(frameIndex, 1));
+    }
+
+    offscreen.Delete();
+
+    ShutdownSingletons();
+
     SDL_GL_DeleteContext(sdl_context_);
 
     SDL_DestroyWindow(sdl_window_);
     sdl_window_ = nullptr;
 
+    if (offscreenDriver) {
+        SDL_VideoQuit();
+    }
+
     SDL_Quit();
 }
 
-void Program::Update() {
+void Program::RunOnMainThread(std::function<void()> task) {
+    GetJobSystem()->SubmitMain(std::move(task));
+}
+
+JobSystem * Program::GetJobSystem() {
+    static JobSystem jobs;
+    return &jobs;
+}
+
+void Program::ShutdownSingletons() {
+    TextureStreamer::Inst()->Shutdown();
+    SamplerCache::Inst()->Shutdown();
+    GeometryArena::Inst()->Shutdown();
+    StagingBuffer::Inst()->Shutdown();
+
+    // Bindings of this context mean nothing to the next
+    TextureBinder::Inst()->Reset();
+}
+
+bool Program::hasMainThreadTasks() {
+    return GetJobSystem()->HasMainJobs();
+}
+
+void Program::runFrameTasks() {
+    using namespace std::chrono;
+
+    // Textures drawn last frame get their levels ahead of new loads
+    TextureStreamer::Inst()->Update();
+
+    runMainThreadTasks(2ms);
+
+    StagingBuffer::Inst()->EndFrame();
+}
+
+void Program::renderFrame(const FramePacket& packet) {
+    if (packet.Viewport != viewport_) {
+        viewport_ = packet.Viewport;
+        glViewport(0, 0, viewport_.x, viewport_.y);
+    }
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    Render(packet);
+
+    TextureBinder::Inst()->EndFrame();
+}
+
+void Program::present() {
+    // Nothing to swap to, but the frame's commands are submitted as a swap
+    // would, keeping the driver from queueing up frames without bound
+    if (options_.Headless) {
+        glFlush();
+        return;
+    }
+
+    SDL_GL_SwapWindow(sdl_window_);
+}
+
+void Program::renderLoop(FramePacketExchange * exchange) {
+    using namespace std::chrono;
+
+    SDL_GL_MakeCurrent(sdl_window_, sdl_context_);
+    GetJobSystem()->SetMainThread();
+
+    while (!exchange->IsClosed()) {
+        // Loading goes on while no frames come, e.g. when hidden
+        const FramePacket * packet = exchange->Take(hasMainThreadTasks() ? 0ms : 16ms);
+
+        overlap_.Begin(RenderThread);
+
+        runFrameTasks();
+
+        if (packet) {
+            renderFrame(*packet);
+        }
+
+        overlap_.End(RenderThread);
+
+        // Waiting for vsync isn't work the threads overlap
+        if (packet) {
+            present();
+        }
+    }
+
+    SDL_GL_MakeCurrent(sdl_window_, nullptr);
+}
+
+void Program::runMainThreadTasks(std::chrono::duration<double, std::milli> budget) {
+    using namespace std::chrono;
+
+    auto start = high_resolution_clock::now();
+
+    JobSystem * jobs = GetJobSystem();
+
+    // Always run at least one task so a small budget can't stall loading
+    do {
+        if (!jobs->RunMainJob()) {
+            break;
+        }
+    } while (high_resolution_clock::now() - start < budget && !StagingBuffer::Inst()->IsOverBudget());
+}
+
+void Program::Update(double dt) {
+
+}
+
+void Program::BuildFrame(FramePacket& packet) {
 
 }
 
-void Program::Render() {
+void Program::Render(const FramePacket& packet) {
 
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include <RenderTarget.hpp>
+
+#include <Log.hpp>
+
+RenderTarget::~RenderTarget()
+{
+    Delete();
+}
+
+bool RenderTarget::Create(glm::ivec2 size)
+{
+    Delete();
+
+    glGenRenderbuffers(1, &color_);
+    glBindRenderbuffer(GL_RENDERBUFFER, color_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
+
+    glGenRenderbuffers(1, &depth_);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size.x, size.y);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &framebuffer_);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LogError("Incomplete %dx%d framebuffer, status 0x%04X", size.x, size.y, status);
+        Delete();
+        return false;
+    }
+
+    size_ = size;
+
+    return true;
+}
+
+void RenderTarget::Delete()
+{
+    if (framebuffer_) {
+        glDeleteFramebuffers(1, &framebuffer_);
+        framebuffer_ = 0;
+    }
+
+    if (color_) {
+        glDeleteRenderbuffers(1, &color_);
+        color_ = 0;
+    }
+
+    if (depth_) {
+        glDeleteRenderbuffers(1, &depth_);
+        depth_ = 0;
+    }
+
+    size_ = glm::ivec2(0);
+}
+
+void RenderTarget::Bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+}
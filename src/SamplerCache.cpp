@@ -0,0 +1,116 @@
+#include <SamplerCache.hpp>
+
+#include <Log.hpp>
+
+#include <algorithm>
+
+SamplerCache * SamplerCache::Inst()
+{
+    static SamplerCache cache;
+    return &cache;
+}
+
+SamplerCache::~SamplerCache()
+{
+    Shutdown();
+}
+
+void SamplerCache::Shutdown()
+{
+    for (const auto& [key, sampler] : samplers_) {
+        glDeleteSamplers(1, &sampler);
+    }
+
+    samplers_.clear();
+}
+
+GLuint SamplerCache::Get(const Texture::Options& opts)
+{
+    uint64_t key = getKey(opts);
+
+    auto it = samplers_.find(key);
+    if (it != samplers_.end()) {
+        return it->second;
+    }
+
+    GLuint sampler = 0;
+    glGenSamplers(1, &sampler);
+    if (!sampler) {
+        LogError("Failed to create sampler");
+        return 0;
+    }
+
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, opts.WrapS);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, opts.WrapT);
+
+    glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, opts.MagFilter);
+    glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, opts.MinFilter);
+
+    apply(sampler);
+
+    LogVerbose("Created sampler %u", sampler);
+
+    samplers_.emplace(key, sampler);
+    return sampler;
+}
+
+void SamplerCache::Bind(GLuint first, GLsizei count, const GLuint * samplers)
+{
+    if (GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_multi_bind) {
+        glBindSamplers(first, count, samplers);
+        return;
+    }
+
+    for (GLsizei i = 0; i < count; ++i) {
+        glBindSampler(first + i, samplers[i]);
+    }
+}
+
+void SamplerCache::SetAnisotropy(float anisotropy)
+{
+    if (!hasAnisotropy()) {
+        return;
+    }
+
+    GLfloat limit = 1.f;
+    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &limit);
+
+    anisotropy_ = std::min(std::max(anisotropy, 1.f), limit);
+
+    for (const auto& [key, sampler] : samplers_) {
+        apply(sampler);
+    }
+}
+
+void SamplerCache::SetLODBias(float bias)
+{
+    lodBias_ = bias;
+
+    for (const auto& [key, sampler] : samplers_) {
+        apply(sampler);
+    }
+}
+
+uint64_t SamplerCache::getKey(const Texture::Options& opts)
+{
+    return ((uint64_t)(opts.WrapS & 0xFFFF)
+        | ((uint64_t)(opts.WrapT & 0xFFFF) << 16)
+        | ((uint64_t)(opts.MagFilter & 0xFFFF) << 32)
+        | ((uint64_t)(opts.MinFilter & 0xFFFF) << 48));
+}
+
+bool SamplerCache::hasAnisotropy()
+{
+    // Core in GL 4.6, whose drivers still list the ARB extension
+    return (GLAD_GL_ARB_texture_filter_anisotropic || GLAD_GL_EXT_texture_filter_anisotropic);
+}
+
+void SamplerCache::apply(GLuint sampler)
+{
+    // GL_TEXTURE_MAX_ANISOTROPY and the _EXT name share a value
+    if (hasAnisotropy()) {
+        glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY, anisotropy_);
+    }
+
+    glSamplerParameterf(sampler, GL_TEXTURE_LOD_BIAS, lodBias_);
+}
@@ -0,0 +1,34 @@
+#include <SimulationClock.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+void SimulationClock::SetOptions(const Options& opts)
+{
+    opts_ = opts;
+    opts_.Rate = (opts_.Rate > 0.0 ? opts_.Rate : 60.0);
+    opts_.MaxSteps = std::max(1, opts_.MaxSteps);
+
+    step_ = double_ms(1000.0 / opts_.Rate);
+
+    // A shorter step would otherwise leave the alpha above 1
+    accumulator_ = std::min(accumulator_, step_ * 0.999);
+}
+
+int SimulationClock::Advance(double_ms elapsed)
+{
+    accumulator_ += std::max(double_ms(0.0), elapsed);
+
+    // Steps summing to exactly the elapsed time mustn't round one short
+    int steps = (int)std::floor(accumulator_ / step_ + 1e-9);
+    accumulator_ = std::max(double_ms(0.0), accumulator_ - step_ * steps);
+
+    if (steps > opts_.MaxSteps) {
+        dropped_ += (uint64_t)(steps - opts_.MaxSteps);
+        steps = opts_.MaxSteps;
+    }
+
+    steps_ += (uint64_t)steps;
+
+    return steps;
+}
@@ -0,0 +1,273 @@
+#include <StagingBuffer.hpp>
+
+#include <Log.hpp>
+
+#include <chrono>
+#include <cstring>
+
+StagingBuffer * StagingBuffer::Inst()
+{
+    static StagingBuffer staging;
+    return &staging;
+}
+
+StagingBuffer::~StagingBuffer()
+{
+    Shutdown();
+}
+
+void StagingBuffer::Shutdown()
+{
+    for (auto& segment : segments_) {
+        glDeleteSync(segment.Fence);
+    }
+    segments_.clear();
+
+    if (buffer_) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer_);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        glDeleteBuffers(1, &buffer_);
+        buffer_ = 0;
+    }
+
+    // IsSupported stays false from here on
+    initialized_ = true;
+    mapping_ = nullptr;
+    head_ = 0;
+    used_ = 0;
+    pending_ = 0;
+}
+
+bool StagingBuffer::IsSupported()
+{
+    if (initialized_) {
+        return (mapping_ != nullptr);
+    }
+
+    initialized_ = true;
+
+    if (!GLAD_GL_VERSION_4_4 && !GLAD_GL_ARB_buffer_storage) {
+        LogWarn("glBufferStorage unavailable, uploading without staging");
+        return false;
+    }
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &buffer_);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer_);
+    glBufferStorage(GL_COPY_READ_BUFFER, (GLsizeiptr)capacity_, nullptr, flags);
+    mapping_ = static_cast<uint8_t *>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)capacity_, flags));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    if (!mapping_) {
+        LogWarn("Failed to map staging buffer, uploading without staging");
+        glDeleteBuffers(1, &buffer_);
+        buffer_ = 0;
+        return false;
+    }
+
+    LogVerbose("StagingBuffer %zu bytes mapped", capacity_);
+
+    return true;
+}
+
+StagingBuffer::Allocation StagingBuffer::Allocate(size_t size, size_t alignment /*= 16*/)
+{
+    Allocation alloc;
+
+    if (size == 0 || size > capacity_ || !IsSupported()) {
+        return alloc;
+    }
+
+    using namespace std::chrono;
+
+    auto stallStart = high_resolution_clock::now();
+    bool stalled = false;
+
+    size_t offset, needed;
+    for (;;) {
+        offset = (head_ + alignment - 1) / alignment * alignment;
+        if (offset + size > capacity_) {
+            // Skip the tail, the allocation has to be contiguous
+            offset = 0;
+        }
+
+        size_t skipped = (offset >= head_ ? offset - head_ : capacity_ - head_);
+        needed = skipped + size;
+
+        if (capacity_ - used_ >= needed) {
+            break;
+        }
+
+        if (!stalled) {
+            stalled = true;
+            stallStart = high_resolution_clock::now();
+            ++stalls_;
+        }
+
+        // The ring is full of this frame's own writes, fence them first
+        if (segments_.empty()) {
+            fence();
+        }
+
+        if (!retire(true)) {
+            break;
+        }
+    }
+
+    if (stalled) {
+        stallMilliseconds_ += duration<double, std::milli>(high_resolution_clock::now() - stallStart).count();
+    }
+
+    if (capacity_ - used_ < needed) {
+        return alloc;
+    }
+
+    used_ += needed;
+    pending_ += needed;
+    head_ = offset + size;
+
+    frameBytes_ += size;
+    totalBytes_ += size;
+
+    alloc.Data = mapping_ + offset;
+    alloc.Offset = offset;
+    alloc.Size = size;
+    return alloc;
+}
+
+void StagingBuffer::CopyToBuffer(const Allocation& alloc, GLuint buffer, size_t offset)
+{
+    if (!alloc.Data) {
+        return;
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer_);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+        (GLintptr)alloc.Offset, (GLintptr)offset, (GLsizeiptr)alloc.Size);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+void StagingBuffer::Upload(GLuint buffer, size_t offset, const void * data, size_t size)
+{
+    auto alloc = Allocate(size);
+    if (alloc.Data) {
+        memcpy(alloc.Data, data, size);
+        CopyToBuffer(alloc, buffer, offset);
+        return;
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)offset, (GLsizeiptr)size, data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void StagingBuffer::CopyToTexture(const Allocation& alloc, GLint level, glm::ivec2 size, GLenum format, GLenum type)
+{
+    if (!alloc.Data) {
+        return;
+    }
+
+    // With an unpack buffer bound the pixel pointer is an offset into it
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer_);
+    glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, size.x, size.y, format, type,
+        (const void *)alloc.Offset);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void StagingBuffer::CopyToCompressedTexture(const Allocation& alloc, GLint level, glm::ivec2 size, GLenum internalFormat)
+{
+    if (!alloc.Data) {
+        return;
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer_);
+    glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, size.x, size.y, internalFormat,
+        (GLsizei)alloc.Size, (const void *)alloc.Offset);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void StagingBuffer::CopyToTextureLayer(const Allocation& alloc, GLint level, GLint layer, glm::ivec2 size, GLenum format, GLenum type)
+{
+    if (!alloc.Data) {
+        return;
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer_);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, size.x, size.y, 1, format, type,
+        (const void *)alloc.Offset);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void StagingBuffer::EndFrame()
+{
+    fence();
+    retire(false);
+
+    frameBytes_ = 0;
+}
+
+StagingBuffer::Stats StagingBuffer::GetStats() const
+{
+    Stats stats;
+    stats.Capacity = capacity_;
+    stats.BytesInFlight = used_;
+    stats.FrameBytes = frameBytes_;
+    stats.TotalBytes = totalBytes_;
+    stats.Stalls = stalls_;
+    stats.StallMilliseconds = stallMilliseconds_;
+    stats.Fences = segments_.size();
+    return stats;
+}
+
+void StagingBuffer::fence()
+{
+    if (pending_ == 0) {
+        return;
+    }
+
+    segments_.push_back(Segment{ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), pending_ });
+    pending_ = 0;
+}
+
+bool StagingBuffer::retire(bool wait)
+{
+    // Waits are bounded so a lost context can't hang the main thread forever
+    const GLuint64 Timeout = 1000000000; // 1s
+
+    while (!segments_.empty()) {
+        auto& segment = segments_.front();
+
+        GLenum status = glClientWaitSync(segment.Fence,
+            (wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0),
+            (wait ? Timeout : 0));
+
+        if (status == GL_WAIT_FAILED) {
+            LogError("Failed to wait on staging fence");
+            return false;
+        }
+
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            return true;
+        }
+
+        glDeleteSync(segment.Fence);
+        used_ -= segment.Bytes;
+        segments_.pop_front();
+
+        if (used_ == 0) {
+            // Nothing in flight, start over to avoid skipping the tail
+            head_ = 0;
+        }
+
+        if (wait) {
+            return true;
+        }
+    }
+
+    return true;
+}
@@ -1,72 +1,518 @@
 #include <Texture.hpp>
 
 #include <Log.hpp>
+#include <MappedFile.hpp>
+#include <SamplerCache.hpp>
+#include <StagingBuffer.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
 #include <stb/stb_image.h>
 
+namespace {
+
+// stb_image only loads PNGs at 16 bits, which it can't tell apart from 8 bit
+// ones without decoding them. The bit depth is the first byte after the
+// width and height in the IHDR chunk, which always comes first.
+bool isPNG16(const std::string& filename)
+{
+    static const uint8_t Signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    MappedFile file;
+    if (!file.Open(filename) || file.GetSize() < 25) {
+        return false;
+    }
+
+    const uint8_t * header = file.GetData();
+    return (memcmp(header, Signature, sizeof(Signature)) == 0
+        && memcmp(header + 12, "IHDR", 4) == 0 && header[24] == 16);
+}
+
+} // namespace
+
 bool Texture::LoadFromFile(const std::string& filename, Options opts /*= Options()*/)
 {
+    // Containers already hold their final format and every mip level
+    if (IsTextureContainerFile(filename)) {
+        TextureContainer container;
+        if (!LoadTextureContainer(filename, container) || !LoadFromContainer(container, opts)) {
+            LogError("Failed to load texture '%s'", filename);
+            return false;
+        }
+
+        LogLoad("Loaded Texture from '%s'", filename);
+        return true;
+    }
+
+    // The encoders and GenerateMipChain only take RGBA8
+    bool rgba8 = (opts.Compression != BlockFormat::None || (opts.Mipmap && opts.CPUMipmaps));
+
     int comp;
     glm::ivec2 size;
+    void * pixels = nullptr;
+    GLenum type = GL_UNSIGNED_BYTE;
 
-    uint8_t * buffer = stbi_load(filename.c_str(), &size.x, &size.y, &comp, STBI_rgb_alpha);
-    if (!buffer) {
-        LogError("Failed to load texture '%s'", filename);
+    if (!rgba8 && stbi_is_hdr(filename.c_str())) {
+        pixels = stbi_loadf(filename.c_str(), &size.x, &size.y, &comp, 0);
+        type = GL_FLOAT;
+    } else if (!rgba8 && isPNG16(filename)) {
+        pixels = stbi_load_16(filename.c_str(), &size.x, &size.y, &comp, 0);
+        type = GL_UNSIGNED_SHORT;
+    } else {
+        pixels = stbi_load(filename.c_str(), &size.x, &size.y, &comp, (rgba8 ? STBI_rgb_alpha : 0));
+
+        // comp is still what the file holds
+        if (rgba8) {
+            comp = STBI_rgb_alpha;
+        }
+    }
+
+    if (!pixels) {
+        LogError("Failed to load texture '%s', %s", filename, stbi_failure_reason());
         return false;
     }
 
-    if (!LoadFromBuffer(buffer, size, comp, opts)) {
+    bool ok = (type == GL_UNSIGNED_BYTE
+        ? LoadFromBuffer((const uint8_t *)pixels, size, comp, opts)
+        : LoadFromPixels(pixels, size, comp, type, opts));
+
+    stbi_image_free(pixels);
+
+    if (!ok) {
         LogError("Failed to load texture '%s'", filename);
         return false;
     }
 
     LogLoad("Loaded Texture from '%s", filename);
 
-    stbi_image_free(buffer);
-
     return true;
 }
 
 bool Texture::LoadFromBuffer(const uint8_t * buffer, glm::ivec2 size, int comp /*= 4*/, Options opts /*= Options()*/)
 {
-    if (id_) {
-        glDeleteTextures(1, &id_);
-        id_ = 0;
+    MipChain chain;
+    if (opts.Mipmap && comp == 4 && (opts.CPUMipmaps || opts.Compression != BlockFormat::None)) {
+        GenerateMipChain(buffer, size, opts.Mipmaps, chain);
+    }
+
+    if (opts.Compression != BlockFormat::None) {
+        if (comp == 4 && IsBlockFormatSupported(opts.Compression)) {
+            EncodedTexture encoded;
+            bool ok = (chain.Levels > 0
+                ? EncodeMipChain(chain, opts.Compression, encoded)
+                : EncodeTexture(buffer, size, opts.Compression, false, encoded));
+
+            if (ok) {
+                return LoadFromBlocks(encoded.Format, encoded.Size, encoded.Levels, encoded.Data.data(), opts);
+            }
+        }
+
+        LogWarn("Texture compression unavailable, uploading uncompressed");
+    }
+
+    if (chain.Levels > 0 && opts.CPUMipmaps) {
+        return LoadFromMipChain(chain, opts);
+    }
+
+    return LoadFromPixels(buffer, size, comp, GL_UNSIGNED_BYTE, opts);
+}
+
+bool Texture::LoadFromPixels(const void * pixels, glm::ivec2 size, int comp, GLenum type, Options opts /*= Options()*/)
+{
+    const auto& format = GetPixelFormat(comp, type);
+    if (format.InternalFormat == 0) {
+        LogError("Unsupported texture with %d components of type %04x", comp, type);
+        return false;
+    }
+
+    int levels = (opts.Mipmap ? GetMipLevelCount(size) : 1);
+    if (!Create(size, format.InternalFormat, levels, opts)) {
+        return false;
+    }
+
+    if (!Upload(0, pixels, format.Format, format.Type)) {
+        return false;
+    }
+
+    if (opts.Mipmap) {
+        GenerateMipmaps();
+    }
+
+    return true;
+}
+
+bool Texture::LoadFromBlocks(BlockFormat format, glm::ivec2 size, int levels, const uint8_t * data, Options opts /*= Options()*/)
+{
+    TextureContainer container;
+    container.InternalFormat = GetBlockFormatGL(format);
+    container.Size = size;
+
+    for (int level = 0; level < levels; ++level) {
+        size_t levelSize = GetEncodedSize(format, size, 1);
+        container.Levels.push_back(TextureContainer::Level{ data, levelSize });
+
+        data += levelSize;
+        size = glm::ivec2(std::max(1, size.x / 2), std::max(1, size.y / 2));
+    }
+
+    return LoadFromContainer(container, opts);
+}
+
+bool Texture::LoadFromMipChain(const MipChain& chain, Options opts /*= Options()*/)
+{
+    if (chain.Levels < 1 || chain.Data.size() < GetMipChainSize(chain.Size, chain.Levels)) {
+        LogError("Invalid texture mip chain");
+        return false;
+    }
+
+    TextureContainer container;
+    container.InternalFormat = GL_RGBA8;
+    container.Format = GL_RGBA;
+    container.Type = GL_UNSIGNED_BYTE;
+    container.Size = chain.Size;
+
+    const uint8_t * data = chain.Data.data();
+    glm::ivec2 size = chain.Size;
+    for (int level = 0; level < chain.Levels; ++level) {
+        size_t levelSize = (size_t)size.x * size.y * 4;
+        container.Levels.push_back(TextureContainer::Level{ data, levelSize });
+
+        data += levelSize;
+        size = glm::ivec2(std::max(1, size.x / 2), std::max(1, size.y / 2));
+    }
+
+    return LoadFromContainer(container, opts);
+}
+
+bool Texture::LoadFromContainer(const TextureContainer& container, Options opts /*= Options()*/)
+{
+    if (container.InternalFormat == 0 || container.Levels.empty()) {
+        LogError("Invalid texture format");
+        return false;
+    }
+
+    if (!IsTextureFormatSupported(container.InternalFormat)) {
+        LogError("Unsupported texture format %04x", container.InternalFormat);
+        return false;
     }
 
-    glGenTextures(1, &id_);
+    // Anything past the 1x1 level can't be stored
+    int levels = std::min((int)container.Levels.size(), GetMipLevelCount(container.Size));
 
-    GLenum format = GL_RGBA;
+    if (!Create(container.Size, container.InternalFormat, levels, opts)) {
+        return false;
+    }
+
+    for (int level = 0; level < levels; ++level) {
+        const auto& data = container.Levels[level];
+
+        bool ok = (container.IsCompressed()
+            ? UploadCompressed(level, data.Data, data.Size)
+            : Upload(level, data.Data, container.Format, container.Type));
+
+        if (!ok) {
+            return false;
+        }
+    }
 
-    switch (comp) 
+    return true;
+}
+
+namespace {
+
+size_t getPixelSize(GLenum format, GLenum type)
+{
+    size_t components = 4;
+    switch (format)
     {
-    case 1:
-        format = GL_RED;
+    case GL_RED:
+        components = 1;
         break;
-    case 2:
-        format = GL_RG;
+    case GL_RG:
+        components = 2;
         break;
-    case 3:
-        format = GL_RGB;
+    case GL_RGB:
+    case GL_BGR:
+        components = 3;
         break;
     }
 
+    switch (type)
+    {
+    case GL_HALF_FLOAT:
+    case GL_UNSIGNED_SHORT:
+        return components * 2;
+    case GL_FLOAT:
+        return components * 4;
+    default:
+        return components;
+    }
+}
+
+} // namespace
+
+bool Texture::Create(glm::ivec2 size, GLenum internalFormat, int levels, Options opts /*= Options()*/)
+{
+    return create(GL_TEXTURE_2D, size, 0, internalFormat, levels, opts);
+}
+
+bool Texture::CreateArray(glm::ivec2 size, int layers, GLenum internalFormat, int levels, Options opts /*= Options()*/)
+{
+    if (layers < 1) {
+        LogError("Invalid texture array with %d layers", layers);
+        return false;
+    }
+
+    // Arrays are only filled with UploadLayer
+    if (IsCompressedTextureFormat(internalFormat)) {
+        LogError("Unsupported texture array format %04x", internalFormat);
+        return false;
+    }
+
+    return create(GL_TEXTURE_2D_ARRAY, size, layers, internalFormat, levels, opts);
+}
+
+bool Texture::Upload(int level, const void * pixels, GLenum format, GLenum type)
+{
+    if (!id_ || target_ != GL_TEXTURE_2D || level < 0 || level >= levels_ || !pixels) {
+        LogError("Invalid texture upload to level %d", level);
+        return false;
+    }
+
+    glm::ivec2 size(std::max(1, size_.x >> level), std::max(1, size_.y >> level));
+
     glBindTexture(GL_TEXTURE_2D, id_);
 
-    LogVerbose("Binding texture to ID %u", id_);
+    // Rows are tightly packed whatever their width
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    auto staging = StagingBuffer::Inst();
+    auto alloc = staging->Allocate((size_t)size.x * size.y * getPixelSize(format, type));
+    if (alloc.Data) {
+        memcpy(alloc.Data, pixels, alloc.Size);
+        staging->CopyToTexture(alloc, level, size, format, type);
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, size.x, size.y, format, type, pixels);
+    }
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, opts.WrapS);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, opts.WrapT);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, opts.MagFilter);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, opts.MinFilter);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    TextureBinder::Inst()->Invalidate(GL_TEXTURE_2D);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, (GLint)format, size.x, size.y, 0, format, GL_UNSIGNED_BYTE, buffer);
+    fenceUpload();
 
-    if (opts.Mipmap) {
-        glGenerateMipmap(GL_TEXTURE_2D);
+    return true;
+}
+
+bool Texture::UploadCompressed(int level, const void * data, size_t size)
+{
+    if (!id_ || target_ != GL_TEXTURE_2D || level < 0 || level >= levels_ || !data) {
+        LogError("Invalid texture upload to level %d", level);
+        return false;
+    }
+
+    glm::ivec2 levelSize(std::max(1, size_.x >> level), std::max(1, size_.y >> level));
+
+    glBindTexture(GL_TEXTURE_2D, id_);
+
+    if (immutable_) {
+        auto staging = StagingBuffer::Inst();
+        auto alloc = staging->Allocate(size);
+        if (alloc.Data) {
+            memcpy(alloc.Data, data, alloc.Size);
+            staging->CopyToCompressedTexture(alloc, level, levelSize, internalFormat_);
+        } else {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, levelSize.x, levelSize.y, internalFormat_, (GLsizei)size, data);
+        }
+    } else {
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat_, levelSize.x, levelSize.y, 0, (GLsizei)size, data);
     }
 
     glBindTexture(GL_TEXTURE_2D, 0);
+    TextureBinder::Inst()->Invalidate(GL_TEXTURE_2D);
+
+    fenceUpload();
+
+    return true;
+}
+
+bool Texture::UploadLayer(int layer, int level, const void * pixels, GLenum format, GLenum type)
+{
+    if (!id_ || target_ != GL_TEXTURE_2D_ARRAY || layer < 0 || layer >= layers_
+        || level < 0 || level >= levels_ || !pixels) {
+        LogError("Invalid texture upload to layer %d level %d", layer, level);
+        return false;
+    }
+
+    glm::ivec2 size(std::max(1, size_.x >> level), std::max(1, size_.y >> level));
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id_);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    auto staging = StagingBuffer::Inst();
+    auto alloc = staging->Allocate((size_t)size.x * size.y * getPixelSize(format, type));
+    if (alloc.Data) {
+        memcpy(alloc.Data, pixels, alloc.Size);
+        staging->CopyToTextureLayer(alloc, level, layer, size, format, type);
+    } else {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, size.x, size.y, 1, format, type, pixels);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    TextureBinder::Inst()->Invalidate(GL_TEXTURE_2D_ARRAY);
+
+    fenceUpload();
 
     return true;
-}
\ No newline at end of file
+}
+
+void Texture::GenerateMipmaps()
+{
+    if (!id_ || levels_ < 2) {
+        return;
+    }
+
+    glBindTexture(target_, id_);
+    glGenerateMipmap(target_);
+    glBindTexture(target_, 0);
+    TextureBinder::Inst()->Invalidate(target_);
+
+    fenceUpload();
+}
+
+bool Texture::IsReady()
+{
+    if (ready_ || !fence_) {
+        return ready_;
+    }
+
+    GLint status = GL_UNSIGNALED;
+    glGetSynciv(fence_, GL_SYNC_STATUS, sizeof(status), nullptr, &status);
+    if (status == GL_SIGNALED) {
+        glDeleteSync(fence_);
+        fence_ = nullptr;
+        ready_ = true;
+    }
+
+    return ready_;
+}
+
+size_t Texture::GetByteSize() const
+{
+    size_t bytes = 0;
+
+    glm::ivec2 size = size_;
+    for (int level = 0; level < levels_; ++level) {
+        bytes += GetTextureLevelSize(internalFormat_, size);
+        size = glm::ivec2(std::max(1, size.x / 2), std::max(1, size.y / 2));
+    }
+
+    return bytes * std::max(1, layers_);
+}
+
+void Texture::Swap(Texture& other)
+{
+    std::swap(id_, other.id_);
+    std::swap(target_, other.target_);
+    std::swap(sampler_, other.sampler_);
+    std::swap(size_, other.size_);
+    std::swap(internalFormat_, other.internalFormat_);
+    std::swap(levels_, other.levels_);
+    std::swap(layers_, other.layers_);
+    std::swap(immutable_, other.immutable_);
+    std::swap(fence_, other.fence_);
+    std::swap(ready_, other.ready_);
+}
+
+bool Texture::create(GLenum target, glm::ivec2 size, int layers, GLenum internalFormat, int levels, Options opts)
+{
+    if (size.x <= 0 || size.y <= 0 || levels < 1 || levels > GetMipLevelCount(size)) {
+        LogError("Invalid texture size %dx%d with %d levels", size.x, size.y, levels);
+        return false;
+    }
+
+    if (opts.SRGB) {
+        GLenum srgb = GetSRGBTextureFormat(internalFormat);
+        if (IsTextureFormatSupported(srgb)) {
+            internalFormat = srgb;
+        }
+    }
+
+    if (fence_) {
+        glDeleteSync(fence_);
+        fence_ = nullptr;
+    }
+
+    ready_ = false;
+
+    bool reuse = (id_ && target == target_ && size == size_ && layers == layers_
+        && internalFormat == internalFormat_ && levels == levels_);
+    if (!reuse && id_) {
+        TextureBinder::Inst()->Forget(id_);
+        glDeleteTextures(1, &id_);
+        id_ = 0;
+    }
+
+    if (!id_) {
+        glGenTextures(1, &id_);
+    }
+
+    target_ = target;
+    size_ = size;
+    layers_ = layers;
+    internalFormat_ = internalFormat;
+    levels_ = levels;
+
+    glBindTexture(target_, id_);
+
+    LogVerbose("Binding texture to ID %u", id_);
+
+    // Wrap and filter modes live in the shared sampler bound with it
+    sampler_ = SamplerCache::Inst()->Get(opts);
+
+    // The texture is only complete if it stops at the levels it has
+    glTexParameteri(target_, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+    if (!reuse) {
+        immutable_ = (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_storage);
+        if (immutable_) {
+            if (target_ == GL_TEXTURE_2D_ARRAY) {
+                glTexStorage3D(target_, levels, internalFormat, size.x, size.y, layers);
+            } else {
+                glTexStorage2D(target_, levels, internalFormat, size.x, size.y);
+            }
+        } else if (!IsCompressedTextureFormat(internalFormat)) {
+            // Mutable storage of the same shape, compressed levels are
+            // specified as they are uploaded instead
+            for (int level = 0; level < levels; ++level) {
+                if (target_ == GL_TEXTURE_2D_ARRAY) {
+                    glTexImage3D(target_, level, (GLint)internalFormat, size.x, size.y, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+                } else {
+                    glTexImage2D(target_, level, (GLint)internalFormat, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+                }
+                size = glm::ivec2(std::max(1, size.x / 2), std::max(1, size.y / 2));
+            }
+        }
+    }
+
+    glBindTexture(target_, 0);
+    TextureBinder::Inst()->Invalidate(target_);
+
+    return true;
+}
+
+void Texture::fenceUpload()
+{
+    if (fence_) {
+        glDeleteSync(fence_);
+    }
+
+    fence_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ready_ = false;
+}
@@ -0,0 +1,171 @@
+#include <TextureBinder.hpp>
+
+#include <Texture.hpp>
+
+TextureBinder * TextureBinder::Inst()
+{
+    static TextureBinder binder;
+    return &binder;
+}
+
+void TextureBinder::Bind(GLuint unit, const Texture * texture)
+{
+    GLenum target = (texture ? texture->GetTarget() : GL_TEXTURE_2D);
+    GLuint id = (texture ? texture->GetID() : 0);
+    GLuint sampler = (texture ? texture->GetSampler() : 0);
+
+    auto& state = getUnit(unit);
+    auto& bound = state.Textures[getTargetIndex(target)];
+
+    if (bound == id && state.Sampler == sampler) {
+        ++frame_.Elided;
+        return;
+    }
+
+    if (bound != id) {
+        // glBindTextureUnit with 0 would unbind every target
+        if (id && (GLAD_GL_VERSION_4_5 || GLAD_GL_ARB_direct_state_access)) {
+            glBindTextureUnit(unit, id);
+        } else {
+            setActive(unit);
+            glBindTexture(target, id);
+        }
+
+        bound = id;
+        ++frame_.Binds;
+    }
+
+    if (state.Sampler != sampler) {
+        glBindSampler(unit, sampler);
+        state.Sampler = sampler;
+        ++frame_.Binds;
+    }
+}
+
+void TextureBinder::Bind(GLuint first, GLsizei count, const Texture * const * textures)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    if (!GLAD_GL_VERSION_4_4 && !GLAD_GL_ARB_multi_bind) {
+        for (GLsizei i = 0; i < count; ++i) {
+            Bind(first + (GLuint)i, textures[i]);
+        }
+        return;
+    }
+
+    ids_.resize(count);
+    samplers_.resize(count);
+
+    bool texturesChanged = false;
+    bool samplersChanged = false;
+
+    for (GLsizei i = 0; i < count; ++i) {
+        const auto * texture = textures[i];
+        auto& state = getUnit(first + (GLuint)i);
+
+        ids_[i] = (texture ? texture->GetID() : 0);
+        samplers_[i] = (texture ? texture->GetSampler() : 0);
+
+        bool textureBound = (texture
+            ? state.Textures[getTargetIndex(texture->GetTarget())] == ids_[i]
+            : state.Textures[Target2D] == 0 && state.Textures[Target2DArray] == 0);
+        bool samplerBound = (state.Sampler == samplers_[i]);
+
+        if (textureBound && samplerBound) {
+            ++frame_.Elided;
+        }
+
+        texturesChanged |= !textureBound;
+        samplersChanged |= !samplerBound;
+    }
+
+    // Binding a unit's texture binds it to its own target and leaves the
+    // others, binding 0 clears every target
+    if (texturesChanged) {
+        glBindTextures(first, count, ids_.data());
+        ++frame_.Binds;
+
+        for (GLsizei i = 0; i < count; ++i) {
+            auto& state = units_[first + i];
+            if (textures[i]) {
+                state.Textures[getTargetIndex(textures[i]->GetTarget())] = ids_[i];
+            } else {
+                state.Textures[Target2D] = 0;
+                state.Textures[Target2DArray] = 0;
+            }
+        }
+    }
+
+    if (samplersChanged) {
+        glBindSamplers(first, count, samplers_.data());
+        ++frame_.Binds;
+
+        for (GLsizei i = 0; i < count; ++i) {
+            units_[first + i].Sampler = samplers_[i];
+        }
+    }
+}
+
+void TextureBinder::Invalidate(GLenum target)
+{
+    size_t index = getTargetIndex(target);
+
+    if (active_ < units_.size()) {
+        units_[active_].Textures[index] = ~0u;
+        return;
+    }
+
+    for (auto& unit : units_) {
+        unit.Textures[index] = ~0u;
+    }
+}
+
+void TextureBinder::Forget(GLuint texture)
+{
+    if (!texture) {
+        return;
+    }
+
+    for (auto& unit : units_) {
+        for (auto& bound : unit.Textures) {
+            if (bound == texture) {
+                bound = 0;
+            }
+        }
+    }
+}
+
+void TextureBinder::Reset()
+{
+    units_.clear();
+    active_ = ~0u;
+}
+
+void TextureBinder::EndFrame()
+{
+    lastFrame_ = frame_;
+    frame_ = Stats();
+}
+
+size_t TextureBinder::getTargetIndex(GLenum target)
+{
+    return (target == GL_TEXTURE_2D_ARRAY ? Target2DArray : Target2D);
+}
+
+TextureBinder::Unit& TextureBinder::getUnit(GLuint unit)
+{
+    if (unit >= units_.size()) {
+        units_.resize(unit + 1);
+    }
+    return units_[unit];
+}
+
+void TextureBinder::setActive(GLuint unit)
+{
+    if (active_ != unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        active_ = unit;
+    }
+}
@@ -0,0 +1,117 @@
+#include <TextureCache.hpp>
+
+#include <Hash.hpp>
+
+#include <cstring>
+
+TextureCache * TextureCache::Inst()
+{
+    static TextureCache cache;
+    return &cache;
+}
+
+std::shared_ptr<Texture> TextureCache::Find(const Key& key)
+{
+    if (key.Hash == 0) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = entries_.find(hash(key));
+    if (it != entries_.end() && equal(it->second.Id, key)) {
+        auto texture = it->second.Handle.lock();
+        if (texture) {
+            ++hits_;
+            bytesSaved_ += texture->GetByteSize();
+            return texture;
+        }
+
+        entries_.erase(it);
+    }
+
+    ++misses_;
+    return nullptr;
+}
+
+std::shared_ptr<Texture> TextureCache::Insert(const Key& key, std::shared_ptr<Texture> texture)
+{
+    if (key.Hash == 0 || !texture) {
+        return texture;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto& entry = entries_[hash(key)];
+    if (equal(entry.Id, key)) {
+        auto existing = entry.Handle.lock();
+        if (existing) {
+            return existing;
+        }
+    }
+
+    entry.Id = key;
+    entry.Handle = texture;
+    return texture;
+}
+
+TextureCache::Stats TextureCache::GetStats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Drop what has been freed since, so Entries only counts live textures
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second.Handle.expired()) {
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    Stats stats;
+    stats.Hits = hits_;
+    stats.Misses = misses_;
+    stats.BytesSaved = bytesSaved_;
+    stats.Entries = entries_.size();
+    return stats;
+}
+
+uint64_t TextureCache::hash(const Key& key)
+{
+    const auto& opts = key.Options;
+
+    uint32_t cutoff;
+    memcpy(&cutoff, &opts.Mipmaps.AlphaCutoff, sizeof(cutoff));
+
+    const uint32_t state[] = {
+        opts.WrapS,
+        opts.WrapT,
+        opts.MagFilter,
+        opts.MinFilter,
+        opts.Mipmap,
+        (uint32_t)opts.Compression,
+        opts.CPUMipmaps,
+        (uint32_t)opts.Mipmaps.Filter,
+        opts.Mipmaps.SRGB,
+        cutoff,
+        opts.SRGB,
+    };
+
+    return Hash64(state, sizeof(state), key.Hash);
+}
+
+bool TextureCache::equal(const Key& a, const Key& b)
+{
+    return (a.Hash == b.Hash &&
+        a.Options.WrapS == b.Options.WrapS &&
+        a.Options.WrapT == b.Options.WrapT &&
+        a.Options.MagFilter == b.Options.MagFilter &&
+        a.Options.MinFilter == b.Options.MinFilter &&
+        a.Options.Mipmap == b.Options.Mipmap &&
+        a.Options.Compression == b.Options.Compression &&
+        a.Options.CPUMipmaps == b.Options.CPUMipmaps &&
+        a.Options.Mipmaps.Filter == b.Options.Mipmaps.Filter &&
+        a.Options.Mipmaps.SRGB == b.Options.Mipmaps.SRGB &&
+        a.Options.Mipmaps.AlphaCutoff == b.Options.Mipmaps.AlphaCutoff &&
+        a.Options.SRGB == b.Options.SRGB);
+}
@@ -0,0 +1,469 @@
+#include <TextureContainer.hpp>
+
+#include <Log.hpp>
+#include <MappedFile.hpp>
+#include <Util.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+// Layouts from the KTX 2.0 specification and the DirectDraw Surface
+// documentation, both little-endian
+
+const uint8_t KTX2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+const size_t KTX2HeaderSize = 80;
+const size_t KTX2LevelSize = 24;
+
+const uint32_t DDSMagic = 0x20534444; // "DDS "
+
+const size_t DDSHeaderSize = 124;
+const size_t DDSHeaderDX10Size = 20;
+
+const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+const uint32_t DDPF_FOURCC = 0x4;
+const uint32_t DDPF_RGB = 0x40;
+const uint32_t DDPF_LUMINANCE = 0x20000;
+const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+const uint32_t DDSCAPS2_VOLUME = 0x200000;
+const uint32_t D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+const uint32_t D3D10_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+constexpr uint32_t fourCC(const char * code)
+{
+    return (uint32_t)code[0] | ((uint32_t)code[1] << 8) | ((uint32_t)code[2] << 16) | ((uint32_t)code[3] << 24);
+}
+
+struct format_t {
+    // VkFormat and DXGI_FORMAT, 0 where the container has no equivalent
+    uint32_t vkFormat;
+    uint32_t dxgiFormat;
+
+    GLenum internalFormat;
+    GLenum format;
+    GLenum type;
+
+    // Bytes per 4x4 block for compressed formats, per pixel otherwise
+    uint32_t blockBytes;
+    uint32_t pixelBytes;
+};
+
+const format_t Formats[] = {
+    {   9, 61, GL_R8,           GL_RED,  GL_UNSIGNED_BYTE, 0,  1 },
+    {  16, 49, GL_RG8,          GL_RG,   GL_UNSIGNED_BYTE, 0,  2 },
+    {  37, 28, GL_RGBA8,        GL_RGBA, GL_UNSIGNED_BYTE, 0,  4 },
+    {  43, 29, GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, 0,  4 },
+    {  44, 87, GL_RGBA8,        GL_BGRA, GL_UNSIGNED_BYTE, 0,  4 },
+    {  50, 91, GL_SRGB8_ALPHA8, GL_BGRA, GL_UNSIGNED_BYTE, 0,  4 },
+    {  97, 10, GL_RGBA16F,      GL_RGBA, GL_HALF_FLOAT,    0,  8 },
+    { 109,  2, GL_RGBA32F,      GL_RGBA, GL_FLOAT,         0, 16 },
+    {  70, 56, GL_R16,          GL_RED,  GL_UNSIGNED_SHORT, 0, 2 },
+    {  77, 35, GL_RG16,         GL_RG,   GL_UNSIGNED_SHORT, 0, 4 },
+    {  91, 11, GL_RGBA16,       GL_RGBA, GL_UNSIGNED_SHORT, 0, 8 },
+    {  76, 54, GL_R16F,         GL_RED,  GL_HALF_FLOAT,    0,  2 },
+    {  83, 34, GL_RG16F,        GL_RG,   GL_HALF_FLOAT,    0,  4 },
+    {   0,  0, GL_RGB8,         GL_RGB,  GL_UNSIGNED_BYTE, 0,  3 }, // Only from memory
+    {   0,  0, GL_SRGB8,        GL_RGB,  GL_UNSIGNED_BYTE, 0,  3 }, // Only from memory
+    {   0,  0, GL_RGB16,        GL_RGB,  GL_UNSIGNED_SHORT, 0, 6 }, // Only from memory
+    {   0,  0, GL_RGB16F,       GL_RGB,  GL_HALF_FLOAT,    0,  6 }, // Only from memory
+    { 131,  0, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,             0, 0,  8, 0 },
+    { 132,  0, GL_COMPRESSED_SRGB_S3TC_DXT1_EXT,            0, 0,  8, 0 },
+    { 133, 71, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,            0, 0,  8, 0 },
+    { 134, 72, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT,      0, 0,  8, 0 },
+    { 135, 74, GL_COMPRESSED_RGBA_S3TC_DXT3_EXT,            0, 0, 16, 0 },
+    { 136, 75, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT,      0, 0, 16, 0 },
+    { 137, 77, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,            0, 0, 16, 0 },
+    { 138, 78, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT,      0, 0, 16, 0 },
+    { 139, 80, GL_COMPRESSED_RED_RGTC1,                     0, 0,  8, 0 },
+    { 140, 81, GL_COMPRESSED_SIGNED_RED_RGTC1,              0, 0,  8, 0 },
+    { 141, 83, GL_COMPRESSED_RG_RGTC2,                      0, 0, 16, 0 },
+    { 142, 84, GL_COMPRESSED_SIGNED_RG_RGTC2,               0, 0, 16, 0 },
+    { 143, 95, GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT,       0, 0, 16, 0 },
+    { 144, 96, GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT,         0, 0, 16, 0 },
+    { 145, 98, GL_COMPRESSED_RGBA_BPTC_UNORM,               0, 0, 16, 0 },
+    { 146, 99, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM,         0, 0, 16, 0 },
+};
+
+const format_t * findVkFormat(uint32_t vkFormat)
+{
+    for (const auto& format : Formats) {
+        if (format.vkFormat == vkFormat) {
+            return &format;
+        }
+    }
+    return nullptr;
+}
+
+const format_t * findDXGIFormat(uint32_t dxgiFormat)
+{
+    for (const auto& format : Formats) {
+        if (dxgiFormat != 0 && format.dxgiFormat == dxgiFormat) {
+            return &format;
+        }
+    }
+    return nullptr;
+}
+
+uint32_t readU32(const uint8_t * data, size_t offset)
+{
+    uint32_t value;
+    memcpy(&value, data + offset, sizeof(value));
+    return value;
+}
+
+uint64_t readU64(const uint8_t * data, size_t offset)
+{
+    uint64_t value;
+    memcpy(&value, data + offset, sizeof(value));
+    return value;
+}
+
+size_t getLevelSize(const format_t& format, glm::ivec2 size)
+{
+    if (format.blockBytes > 0) {
+        return (size_t)((size.x + 3) / 4) * (size_t)((size.y + 3) / 4) * format.blockBytes;
+    }
+    return (size_t)size.x * (size_t)size.y * format.pixelBytes;
+}
+
+void setFormat(const format_t& format, TextureContainer& out)
+{
+    out.InternalFormat = format.internalFormat;
+    out.Format = format.format;
+    out.Type = format.type;
+}
+
+bool parseKTX2(const uint8_t * data, size_t size, TextureContainer& out)
+{
+    if (size < KTX2HeaderSize) {
+        LogError("KTX2 file too small");
+        return false;
+    }
+
+    uint32_t vkFormat = readU32(data, 12);
+    uint32_t width = readU32(data, 20);
+    uint32_t height = readU32(data, 24);
+    uint32_t depth = readU32(data, 28);
+    uint32_t layerCount = readU32(data, 32);
+    uint32_t faceCount = readU32(data, 36);
+    uint32_t levelCount = std::max(1u, readU32(data, 40));
+    uint32_t supercompression = readU32(data, 44);
+
+    if (supercompression != 0 || vkFormat == 0) {
+        LogError("Supercompressed and Basis Universal KTX2 files are not supported");
+        return false;
+    }
+
+    if (width == 0 || height == 0 || depth > 1 || layerCount > 1 || faceCount != 1) {
+        LogError("Only 2D KTX2 textures are supported");
+        return false;
+    }
+
+    const auto format = findVkFormat(vkFormat);
+    if (!format) {
+        LogError("Unsupported KTX2 vkFormat %u", vkFormat);
+        return false;
+    }
+
+    if (size < KTX2HeaderSize + levelCount * KTX2LevelSize) {
+        LogError("KTX2 level index out of bounds");
+        return false;
+    }
+
+    setFormat(*format, out);
+    out.Size = glm::ivec2(width, height);
+
+    // The level index is in level order even though the data is stored
+    // smallest level first
+    glm::ivec2 levelSize = out.Size;
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        size_t entry = KTX2HeaderSize + level * KTX2LevelSize;
+        uint64_t offset = readU64(data, entry);
+        uint64_t length = readU64(data, entry + 8);
+
+        if (offset > size || length > size - offset || length < getLevelSize(*format, levelSize)) {
+            LogError("KTX2 level %u out of bounds", level);
+            return false;
+        }
+
+        out.Levels.push_back(TextureContainer::Level{ data + offset, getLevelSize(*format, levelSize) });
+        levelSize = glm::ivec2(std::max(1, levelSize.x / 2), std::max(1, levelSize.y / 2));
+    }
+
+    return true;
+}
+
+const format_t * getDDSFormat(const uint8_t * header)
+{
+    uint32_t flags = readU32(header, 76);
+    uint32_t code = readU32(header, 80);
+    uint32_t bitCount = readU32(header, 84);
+    uint32_t redMask = readU32(header, 88);
+    uint32_t greenMask = readU32(header, 92);
+    uint32_t blueMask = readU32(header, 96);
+
+    if (flags & DDPF_FOURCC) {
+        static const std::pair<uint32_t, uint32_t> codes[] = {
+            { fourCC("DXT1"), 71 },
+            { fourCC("DXT3"), 74 },
+            { fourCC("DXT5"), 77 },
+            { fourCC("ATI1"), 80 },
+            { fourCC("BC4U"), 80 },
+            { fourCC("ATI2"), 83 },
+            { fourCC("BC5U"), 83 },
+            { 113, 10 }, // D3DFMT_A16B16G16R16F
+            { 116, 2 },  // D3DFMT_A32B32G32R32F
+        };
+
+        for (const auto& pair : codes) {
+            if (pair.first == code) {
+                return findDXGIFormat(pair.second);
+            }
+        }
+    } else if ((flags & DDPF_RGB) && bitCount == 32 && greenMask == 0x0000FF00) {
+        if (redMask == 0x000000FF && blueMask == 0x00FF0000) {
+            return findDXGIFormat(28);
+        } else if (redMask == 0x00FF0000 && blueMask == 0x000000FF) {
+            return findDXGIFormat(87);
+        }
+    } else if ((flags & DDPF_LUMINANCE) && bitCount == 8) {
+        return findDXGIFormat(61);
+    }
+
+    return nullptr;
+}
+
+bool parseDDS(const uint8_t * data, size_t size, TextureContainer& out)
+{
+    if (size < 4 + DDSHeaderSize || readU32(data, 4) != DDSHeaderSize) {
+        LogError("Invalid DDS header");
+        return false;
+    }
+
+    const uint8_t * header = data + 4;
+    size_t offset = 4 + DDSHeaderSize;
+
+    uint32_t flags = readU32(header, 4);
+    uint32_t height = readU32(header, 8);
+    uint32_t width = readU32(header, 12);
+    uint32_t levelCount = ((flags & DDSD_MIPMAPCOUNT) ? std::max(1u, readU32(header, 24)) : 1);
+    uint32_t caps2 = readU32(header, 108);
+
+    if (width == 0 || height == 0 || (caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME))) {
+        LogError("Only 2D DDS textures are supported");
+        return false;
+    }
+
+    const format_t * format = nullptr;
+    if (readU32(header, 80) == fourCC("DX10") && (readU32(header, 76) & DDPF_FOURCC)) {
+        if (size < offset + DDSHeaderDX10Size) {
+            LogError("Invalid DDS DX10 header");
+            return false;
+        }
+
+        uint32_t dxgiFormat = readU32(data, offset);
+        uint32_t dimension = readU32(data, offset + 4);
+        uint32_t miscFlag = readU32(data, offset + 8);
+        uint32_t arraySize = readU32(data, offset + 12);
+        offset += DDSHeaderDX10Size;
+
+        if (dimension != D3D10_RESOURCE_DIMENSION_TEXTURE2D || (miscFlag & D3D10_RESOURCE_MISC_TEXTURECUBE) || arraySize > 1) {
+            LogError("Only 2D DDS textures are supported");
+            return false;
+        }
+
+        format = findDXGIFormat(dxgiFormat);
+        if (!format) {
+            LogError("Unsupported DDS DXGI format %u", dxgiFormat);
+            return false;
+        }
+    } else {
+        format = getDDSFormat(header);
+        if (!format) {
+            LogError("Unsupported DDS pixel format");
+            return false;
+        }
+    }
+
+    setFormat(*format, out);
+    out.Size = glm::ivec2(width, height);
+
+    // Levels follow each other with no padding
+    glm::ivec2 levelSize = out.Size;
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        size_t length = getLevelSize(*format, levelSize);
+        if (length > size - offset) {
+            LogError("DDS level %u out of bounds", level);
+            return false;
+        }
+
+        out.Levels.push_back(TextureContainer::Level{ data + offset, length });
+        offset += length;
+        levelSize = glm::ivec2(std::max(1, levelSize.x / 2), std::max(1, levelSize.y / 2));
+    }
+
+    return true;
+}
+
+} // namespace
+
+bool IsTextureContainer(const uint8_t * data, size_t size)
+{
+    if (size >= sizeof(KTX2Identifier) && memcmp(data, KTX2Identifier, sizeof(KTX2Identifier)) == 0) {
+        return true;
+    }
+
+    return (size >= 4 && readU32(data, 0) == DDSMagic);
+}
+
+bool IsTextureContainerFile(const std::string& filename)
+{
+    std::string ext = GetExtension(filename);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)tolower(c); });
+    return (ext == "ktx2" || ext == "dds");
+}
+
+bool IsTextureContainerMimeType(const std::string& mimeType)
+{
+    return (mimeType == "image/ktx2" || mimeType == "image/vnd-ms.dds");
+}
+
+bool ParseTextureContainer(const uint8_t * data, size_t size, TextureContainer& out)
+{
+    out = TextureContainer();
+
+    if (!data || !IsTextureContainer(data, size)) {
+        LogError("Not a KTX2 or DDS file");
+        return false;
+    }
+
+    out.File.assign(data, data + size);
+
+    bool ok = (readU32(data, 0) == DDSMagic
+        ? parseDDS(out.File.data(), out.File.size(), out)
+        : parseKTX2(out.File.data(), out.File.size(), out));
+
+    if (!ok) {
+        out = TextureContainer();
+    }
+
+    return ok;
+}
+
+bool LoadTextureContainer(const std::string& filename, TextureContainer& out)
+{
+    MappedFile file;
+    if (!file.Open(filename)) {
+        LogError("Failed to open '%s'", filename);
+        return false;
+    }
+
+    return ParseTextureContainer(file.GetData(), file.GetSize(), out);
+}
+
+size_t GetTextureLevelSize(GLenum internalFormat, glm::ivec2 size)
+{
+    for (const auto& format : Formats) {
+        if (format.internalFormat == internalFormat) {
+            return getLevelSize(format, size);
+        }
+    }
+    return 0;
+}
+
+PixelFormat GetPixelFormat(int comp, GLenum type)
+{
+    static const GLenum Transfer[] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+    static const GLenum Unorm8[] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+    static const GLenum Unorm16[] = { GL_R16, GL_RG16, GL_RGB16, GL_RGBA16 };
+    static const GLenum Half[] = { GL_R16F, GL_RG16F, GL_RGB16F, GL_RGBA16F };
+
+    PixelFormat out;
+    if (comp < 1 || comp > 4) {
+        return out;
+    }
+
+    switch (type)
+    {
+    case GL_UNSIGNED_BYTE:
+        out.InternalFormat = Unorm8[comp - 1];
+        break;
+    case GL_UNSIGNED_SHORT:
+        out.InternalFormat = Unorm16[comp - 1];
+        break;
+    case GL_FLOAT:
+        out.InternalFormat = Half[comp - 1];
+        break;
+    default:
+        return out;
+    }
+
+    out.Format = Transfer[comp - 1];
+    out.Type = type;
+    return out;
+}
+
+GLenum GetSRGBTextureFormat(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+    case GL_RGB8:
+        return GL_SRGB8;
+    case GL_RGBA8:
+        return GL_SRGB8_ALPHA8;
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+    default:
+        return internalFormat;
+    }
+}
+
+bool IsCompressedTextureFormat(GLenum internalFormat)
+{
+    for (const auto& format : Formats) {
+        if (format.blockBytes > 0 && format.internalFormat == internalFormat) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IsTextureFormatSupported(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        return GLAD_GL_EXT_texture_compression_s3tc;
+    case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+        return (GLAD_GL_EXT_texture_compression_s3tc && GLAD_GL_EXT_texture_sRGB);
+    case GL_COMPRESSED_RED_RGTC1:
+    case GL_COMPRESSED_SIGNED_RED_RGTC1:
+    case GL_COMPRESSED_RG_RGTC2:
+    case GL_COMPRESSED_SIGNED_RG_RGTC2:
+        return GLAD_GL_VERSION_3_0;
+    case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+    case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+        return (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_compression_bptc);
+    default:
+        return true;
+    }
+}
@@ -0,0 +1,904 @@
+#include <TextureEncoder.hpp>
+
+#include <Log.hpp>
+#include <MipmapGenerator.hpp>
+#include <Program.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define GLBP_ENCODER_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace {
+
+// 4x4 RGBA texels, row major
+typedef uint8_t block_t[16][4];
+
+size_t getBlockBytes(BlockFormat format)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+    case BlockFormat::BC4:
+        return 8;
+    case BlockFormat::BC3:
+    case BlockFormat::BC5:
+    case BlockFormat::BC7:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+// Edge blocks of sizes that aren't a multiple of 4 repeat the last texel
+void loadBlock(const uint8_t * pixels, glm::ivec2 size, int bx, int by, block_t& block)
+{
+    for (int y = 0; y < 4; ++y) {
+        int py = std::min(by * 4 + y, size.y - 1);
+        for (int x = 0; x < 4; ++x) {
+            int px = std::min(bx * 4 + x, size.x - 1);
+            memcpy(block[y * 4 + x], pixels + ((size_t)py * size.x + px) * 4, 4);
+        }
+    }
+}
+
+#if defined(GLBP_ENCODER_SSE2)
+
+// The block's texels as floats, one register each
+inline void loadTexels(const block_t& block, __m128 texels[16])
+{
+    const __m128i zero = _mm_setzero_si128();
+    for (int i = 0; i < 16; i += 4) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)block[i]);
+        __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+        __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+        texels[i + 0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+        texels[i + 1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+        texels[i + 2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+        texels[i + 3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+    }
+}
+
+// The block's channels as floats, channels[c][g] holds channel c of texels
+// 4g to 4g+3
+inline void loadChannels(const block_t& block, __m128 channels[4][4])
+{
+    __m128 texels[16];
+    loadTexels(block, texels);
+
+    for (int g = 0; g < 4; ++g) {
+        __m128 t0 = texels[g * 4 + 0];
+        __m128 t1 = texels[g * 4 + 1];
+        __m128 t2 = texels[g * 4 + 2];
+        __m128 t3 = texels[g * 4 + 3];
+        _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+        channels[0][g] = t0;
+        channels[1][g] = t1;
+        channels[2][g] = t2;
+        channels[3][g] = t3;
+    }
+}
+
+inline __m128 broadcast(__m128 v, int lane)
+{
+    switch (lane)
+    {
+    case 0: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+    case 1: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+    case 2: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+    default: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+}
+
+// Sum of the first Channels lanes, added in lane order like the scalar code
+template <int Channels>
+inline float sumLanes(__m128 v)
+{
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, v);
+
+    float sum = 0.f;
+    for (int c = 0; c < Channels; ++c) {
+        sum += lanes[c];
+    }
+    return sum;
+}
+
+// Endpoints at the extremes of the block's principal axis over the first
+// Channels channels, found by power iteration on the covariance. Every lane
+// adds up in the same order as the scalar version, so both give the same
+// endpoints.
+template <int Channels>
+void fitLine(const block_t& block, float lo[4], float hi[4])
+{
+    // Channels past the ones fitted stay out of the axis
+    const __m128 mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, (Channels > 3 ? -1 : 0)));
+
+    __m128 texels[16];
+    loadTexels(block, texels);
+
+    __m128 sum = _mm_setzero_ps();
+    __m128 minv = _mm_set1_ps(255.f);
+    __m128 maxv = _mm_setzero_ps();
+    for (int i = 0; i < 16; ++i) {
+        sum = _mm_add_ps(sum, texels[i]);
+        minv = _mm_min_ps(minv, texels[i]);
+        maxv = _mm_max_ps(maxv, texels[i]);
+    }
+
+    __m128 mean = _mm_div_ps(sum, _mm_set1_ps(16.f));
+    __m128 axis = _mm_and_ps(_mm_sub_ps(maxv, minv), mask);
+
+    // Row a holds cov[a][b] in lane b
+    __m128 cov[Channels];
+    for (int a = 0; a < Channels; ++a) {
+        cov[a] = _mm_setzero_ps();
+    }
+
+    for (int i = 0; i < 16; ++i) {
+        __m128 d = _mm_sub_ps(texels[i], mean);
+        for (int a = 0; a < Channels; ++a) {
+            cov[a] = _mm_add_ps(cov[a], _mm_mul_ps(d, broadcast(d, a)));
+        }
+    }
+
+    for (int iter = 0; iter < 8; ++iter) {
+        // The covariance is symmetric, so summing rows gives the product
+        __m128 next = _mm_setzero_ps();
+        for (int b = 0; b < Channels; ++b) {
+            next = _mm_add_ps(next, _mm_mul_ps(cov[b], broadcast(axis, b)));
+        }
+
+        float length = sumLanes<Channels>(_mm_mul_ps(next, next));
+
+        // A flat block, keep the bounding box diagonal
+        if (length < 1e-6f) {
+            break;
+        }
+
+        axis = _mm_and_ps(_mm_div_ps(next, _mm_set1_ps(sqrtf(length))), mask);
+    }
+
+    alignas(16) float meanOut[4];
+    _mm_store_ps(meanOut, mean);
+
+    float length = sumLanes<Channels>(_mm_mul_ps(axis, axis));
+    if (length < 1e-6f) {
+        for (int c = 0; c < Channels; ++c) {
+            lo[c] = hi[c] = meanOut[c];
+        }
+        return;
+    }
+
+    axis = _mm_div_ps(axis, _mm_set1_ps(sqrtf(length)));
+
+    alignas(16) float axisOut[4];
+    _mm_store_ps(axisOut, axis);
+
+    // Projections four texels at a time, channel by channel
+    __m128 channels[4][4];
+    loadChannels(block, channels);
+
+    __m128 tmin = _mm_setzero_ps();
+    __m128 tmax = _mm_setzero_ps();
+    for (int g = 0; g < 4; ++g) {
+        __m128 t = _mm_setzero_ps();
+        for (int c = 0; c < Channels; ++c) {
+            __m128 d = _mm_sub_ps(channels[c][g], _mm_set1_ps(meanOut[c]));
+            t = _mm_add_ps(t, _mm_mul_ps(d, _mm_set1_ps(axisOut[c])));
+        }
+        tmin = _mm_min_ps(tmin, t);
+        tmax = _mm_max_ps(tmax, t);
+    }
+
+    alignas(16) float tmins[4];
+    alignas(16) float tmaxs[4];
+    _mm_store_ps(tmins, tmin);
+    _mm_store_ps(tmaxs, tmax);
+
+    float t0 = std::min(std::min(tmins[0], tmins[1]), std::min(tmins[2], tmins[3]));
+    float t1 = std::max(std::max(tmaxs[0], tmaxs[1]), std::max(tmaxs[2], tmaxs[3]));
+
+    for (int c = 0; c < Channels; ++c) {
+        lo[c] = std::clamp(meanOut[c] + axisOut[c] * t0, 0.f, 255.f);
+        hi[c] = std::clamp(meanOut[c] + axisOut[c] * t1, 0.f, 255.f);
+    }
+}
+
+// Index of the palette entry closest to each texel, returns the total error.
+// Four texels are compared against an entry at once, entries in order so
+// ties keep the lowest index. Errors stay below 2^24, exact as floats.
+template <int Entries, int Channels>
+int pickIndices(const __m128 channels[][4], const int palette[Entries][4], int indices[16])
+{
+    __m128 best[4];
+    __m128i bestIndex[4];
+    for (int g = 0; g < 4; ++g) {
+        best[g] = _mm_set1_ps(FLT_MAX);
+        bestIndex[g] = _mm_setzero_si128();
+    }
+
+    for (int e = 0; e < Entries; ++e) {
+        __m128 entry[Channels];
+        for (int c = 0; c < Channels; ++c) {
+            entry[c] = _mm_set1_ps((float)palette[e][c]);
+        }
+
+        const __m128i index = _mm_set1_epi32(e);
+        for (int g = 0; g < 4; ++g) {
+            __m128 d = _mm_sub_ps(channels[0][g], entry[0]);
+            __m128 error = _mm_mul_ps(d, d);
+            for (int c = 1; c < Channels; ++c) {
+                d = _mm_sub_ps(channels[c][g], entry[c]);
+                error = _mm_add_ps(error, _mm_mul_ps(d, d));
+            }
+
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(error, best[g]));
+            best[g] = _mm_min_ps(error, best[g]);
+            bestIndex[g] = _mm_or_si128(_mm_and_si128(closer, index), _mm_andnot_si128(closer, bestIndex[g]));
+        }
+    }
+
+    alignas(16) float errors[16];
+    for (int g = 0; g < 4; ++g) {
+        _mm_store_ps(errors + g * 4, best[g]);
+        _mm_storeu_si128((__m128i *)(indices + g * 4), bestIndex[g]);
+    }
+
+    int total = 0;
+    for (int i = 0; i < 16; ++i) {
+        total += (int)errors[i];
+    }
+    return total;
+}
+
+template <int Entries, int Channels>
+int pickIndices(const block_t& block, const int palette[Entries][4], int indices[16])
+{
+    __m128 channels[4][4];
+    loadChannels(block, channels);
+
+    return pickIndices<Entries, Channels>(channels, palette, indices);
+}
+
+// Least squares endpoints for the chosen indices, where weights[index] is
+// how far along from e0 to e1 that index lies. False for degenerate fits.
+template <int Channels>
+bool refineEndpoints(const block_t& block, const float * weights, const int indices[16], float e0[4], float e1[4])
+{
+    __m128 texels[16];
+    loadTexels(block, texels);
+
+    float aa = 0.f, ab = 0.f, bb = 0.f;
+    __m128 ax = _mm_setzero_ps();
+    __m128 bx = _mm_setzero_ps();
+    for (int i = 0; i < 16; ++i) {
+        float t = weights[indices[i]];
+        float s = 1.f - t;
+        aa += s * s;
+        ab += s * t;
+        bb += t * t;
+        ax = _mm_add_ps(ax, _mm_mul_ps(_mm_set1_ps(s), texels[i]));
+        bx = _mm_add_ps(bx, _mm_mul_ps(_mm_set1_ps(t), texels[i]));
+    }
+
+    float det = aa * bb - ab * ab;
+    if (fabsf(det) < 1e-6f) {
+        return false;
+    }
+
+    alignas(16) float axOut[4];
+    alignas(16) float bxOut[4];
+    _mm_store_ps(axOut, ax);
+    _mm_store_ps(bxOut, bx);
+
+    for (int c = 0; c < Channels; ++c) {
+        e0[c] = std::clamp((bb * axOut[c] - ab * bxOut[c]) / det, 0.f, 255.f);
+        e1[c] = std::clamp((aa * bxOut[c] - ab * axOut[c]) / det, 0.f, 255.f);
+    }
+    return true;
+}
+
+#else
+
+// Endpoints at the extremes of the block's principal axis over the first
+// Channels Channels, found by power iteration on the covariance
+template <int Channels>
+void fitLine(const block_t& block, float lo[4], float hi[4])
+{
+    float mean[4] = { 0.f };
+    float minv[4] = { 255.f, 255.f, 255.f, 255.f };
+    float maxv[4] = { 0.f };
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < Channels; ++c) {
+            mean[c] += block[i][c];
+            minv[c] = std::min(minv[c], (float)block[i][c]);
+            maxv[c] = std::max(maxv[c], (float)block[i][c]);
+        }
+    }
+
+    float axis[4];
+    for (int c = 0; c < Channels; ++c) {
+        mean[c] /= 16.f;
+        axis[c] = maxv[c] - minv[c];
+    }
+
+    float cov[4][4] = { { 0.f } };
+    for (int i = 0; i < 16; ++i) {
+        float d[4];
+        for (int c = 0; c < Channels; ++c) {
+            d[c] = block[i][c] - mean[c];
+        }
+        for (int a = 0; a < Channels; ++a) {
+            for (int b = 0; b < Channels; ++b) {
+                cov[a][b] += d[a] * d[b];
+            }
+        }
+    }
+
+    for (int iter = 0; iter < 8; ++iter) {
+        float next[4] = { 0.f };
+        float length = 0.f;
+        for (int a = 0; a < Channels; ++a) {
+            for (int b = 0; b < Channels; ++b) {
+                next[a] += cov[a][b] * axis[b];
+            }
+            length += next[a] * next[a];
+        }
+
+        // A flat block, keep the bounding box diagonal
+        if (length < 1e-6f) {
+            break;
+        }
+
+        length = sqrtf(length);
+        for (int c = 0; c < Channels; ++c) {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float length = 0.f;
+    for (int c = 0; c < Channels; ++c) {
+        length += axis[c] * axis[c];
+    }
+
+    if (length < 1e-6f) {
+        for (int c = 0; c < Channels; ++c) {
+            lo[c] = hi[c] = mean[c];
+        }
+        return;
+    }
+
+    length = sqrtf(length);
+    for (int c = 0; c < Channels; ++c) {
+        axis[c] /= length;
+    }
+
+    float tmin = 0.f;
+    float tmax = 0.f;
+    for (int i = 0; i < 16; ++i) {
+        float t = 0.f;
+        for (int c = 0; c < Channels; ++c) {
+            t += (block[i][c] - mean[c]) * axis[c];
+        }
+        tmin = std::min(tmin, t);
+        tmax = std::max(tmax, t);
+    }
+
+    for (int c = 0; c < Channels; ++c) {
+        lo[c] = std::clamp(mean[c] + axis[c] * tmin, 0.f, 255.f);
+        hi[c] = std::clamp(mean[c] + axis[c] * tmax, 0.f, 255.f);
+    }
+}
+
+// Index of the palette entry closest to each texel, returns the total error
+template <int Entries, int Channels>
+int pickIndices(const block_t& block, const int palette[Entries][4], int indices[16])
+{
+    int total = 0;
+    for (int i = 0; i < 16; ++i) {
+        int best = 0;
+        int bestError = INT32_MAX;
+        for (int e = 0; e < Entries; ++e) {
+            int error = 0;
+            for (int c = 0; c < Channels; ++c) {
+                int d = (int)block[i][c] - palette[e][c];
+                error += d * d;
+            }
+            if (error < bestError) {
+                bestError = error;
+                best = e;
+            }
+        }
+        indices[i] = best;
+        total += bestError;
+    }
+    return total;
+}
+
+// Least squares endpoints for the chosen indices, where weights[index] is
+// how far along from e0 to e1 that index lies. False for degenerate fits.
+template <int Channels>
+bool refineEndpoints(const block_t& block, const float * weights, const int indices[16], float e0[4], float e1[4])
+{
+    float aa = 0.f, ab = 0.f, bb = 0.f;
+    float ax[4] = { 0.f };
+    float bx[4] = { 0.f };
+    for (int i = 0; i < 16; ++i) {
+        float t = weights[indices[i]];
+        float s = 1.f - t;
+        aa += s * s;
+        ab += s * t;
+        bb += t * t;
+        for (int c = 0; c < Channels; ++c) {
+            ax[c] += s * block[i][c];
+            bx[c] += t * block[i][c];
+        }
+    }
+
+    float det = aa * bb - ab * ab;
+    if (fabsf(det) < 1e-6f) {
+        return false;
+    }
+
+    for (int c = 0; c < Channels; ++c) {
+        e0[c] = std::clamp((bb * ax[c] - ab * bx[c]) / det, 0.f, 255.f);
+        e1[c] = std::clamp((aa * bx[c] - ab * ax[c]) / det, 0.f, 255.f);
+    }
+    return true;
+}
+
+#endif
+
+uint16_t pack565(const float color[4])
+{
+    int r = (int)(color[0] * 31.f / 255.f + 0.5f);
+    int g = (int)(color[1] * 63.f / 255.f + 0.5f);
+    int b = (int)(color[2] * 31.f / 255.f + 0.5f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+void unpack565(uint16_t packed, int color[4])
+{
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+    color[3] = 255;
+}
+
+// Palette and indices for a pair of 565 endpoints with c0 > c1, returns the
+// error
+int pickColorIndices(const block_t& block, uint16_t c0, uint16_t c1, int indices[16])
+{
+    int palette[4][4];
+    unpack565(c0, palette[0]);
+    unpack565(c1, palette[1]);
+    for (int c = 0; c < 3; ++c) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+    }
+
+    return pickIndices<4, 3>(block, palette, indices);
+}
+
+// BC1 block, always in 4 color mode so it is also valid inside BC3
+void encodeColor(const block_t& block, uint8_t * out)
+{
+    static const float Weights[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+
+    float lo[4], hi[4];
+    fitLine<3>(block, lo, hi);
+
+    uint16_t c0 = std::max(pack565(hi), pack565(lo));
+    uint16_t c1 = std::min(pack565(hi), pack565(lo));
+
+    uint32_t bits = 0;
+    if (c0 != c1) {
+        int indices[16];
+        int error = pickColorIndices(block, c0, c1, indices);
+
+        // One least squares pass on the endpoints, kept if it helps
+        float e0[4], e1[4];
+        if (refineEndpoints<3>(block, Weights, indices, e0, e1)) {
+            uint16_t r0 = std::max(pack565(e0), pack565(e1));
+            uint16_t r1 = std::min(pack565(e0), pack565(e1));
+
+            int refined[16];
+            if (r0 != r1 && pickColorIndices(block, r0, r1, refined) < error) {
+                c0 = r0;
+                c1 = r1;
+                memcpy(indices, refined, sizeof(refined));
+            }
+        }
+
+        for (int i = 0; i < 16; ++i) {
+            bits |= (uint32_t)indices[i] << (2 * i);
+        }
+    }
+
+    out[0] = (uint8_t)c0;
+    out[1] = (uint8_t)(c0 >> 8);
+    out[2] = (uint8_t)c1;
+    out[3] = (uint8_t)(c1 >> 8);
+    for (int i = 0; i < 4; ++i) {
+        out[4 + i] = (uint8_t)(bits >> (8 * i));
+    }
+}
+
+// BC4 block of one channel, in the 8 value mode
+void encodeChannel(const block_t& block, int channel, uint8_t * out)
+{
+    int a0 = 0;
+    int a1 = 255;
+    for (int i = 0; i < 16; ++i) {
+        a0 = std::max(a0, (int)block[i][channel]);
+        a1 = std::min(a1, (int)block[i][channel]);
+    }
+
+    uint64_t bits = 0;
+    if (a0 != a1) {
+        int palette[8];
+        palette[0] = a0;
+        palette[1] = a1;
+        for (int i = 2; i < 8; ++i) {
+            palette[i] = ((8 - i) * a0 + (i - 1) * a1 + 3) / 7;
+        }
+
+#if defined(GLBP_ENCODER_SSE2)
+        // The closest by squared distance is the closest by distance too
+        int entries[8][4] = {};
+        for (int e = 0; e < 8; ++e) {
+            entries[e][0] = palette[e];
+        }
+
+        __m128 channels[4][4];
+        loadChannels(block, channels);
+
+        int indices[16];
+        pickIndices<8, 1>(channels + channel, entries, indices);
+        for (int i = 0; i < 16; ++i) {
+            bits |= (uint64_t)indices[i] << (3 * i);
+        }
+#else
+        for (int i = 0; i < 16; ++i) {
+            int best = 0;
+            int bestError = INT32_MAX;
+            for (int e = 0; e < 8; ++e) {
+                int error = std::abs((int)block[i][channel] - palette[e]);
+                if (error < bestError) {
+                    bestError = error;
+                    best = e;
+                }
+            }
+            bits |= (uint64_t)best << (3 * i);
+        }
+#endif
+    }
+
+    out[0] = (uint8_t)a0;
+    out[1] = (uint8_t)a1;
+    for (int i = 0; i < 6; ++i) {
+        out[2 + i] = (uint8_t)(bits >> (8 * i));
+    }
+}
+
+// Quantizes an endpoint to 7 bits per channel plus the shared p-bit that
+// reconstructs it best
+void quantizeEndpoint(const float color[4], int quantized[4], int& pbit)
+{
+    float bestError = 1e30f;
+    for (int p = 0; p < 2; ++p) {
+        int q[4];
+        float error = 0.f;
+        for (int c = 0; c < 4; ++c) {
+            q[c] = std::clamp((int)((color[c] - p) / 2.f + 0.5f), 0, 127);
+            float d = (float)(q[c] * 2 + p) - color[c];
+            error += d * d;
+        }
+
+        if (error < bestError) {
+            bestError = error;
+            pbit = p;
+            memcpy(quantized, q, sizeof(q));
+        }
+    }
+}
+
+struct bitWriter_t {
+    uint8_t * out;
+    int pos = 0;
+
+    inline void write(uint32_t value, int bits) {
+        for (int i = 0; i < bits; ++i, ++pos) {
+            if ((value >> i) & 1) {
+                out[pos >> 3] |= (uint8_t)(1 << (pos & 7));
+            }
+        }
+    }
+};
+
+const int BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Quantizes both endpoints and picks indices against the resulting palette,
+// returns the error
+int pickBC7Indices(const block_t& block, const float e0[4], const float e1[4], int q[2][4], int p[2], int indices[16])
+{
+    quantizeEndpoint(e0, q[0], p[0]);
+    quantizeEndpoint(e1, q[1], p[1]);
+
+    int palette[16][4];
+    for (int c = 0; c < 4; ++c) {
+        int a = (q[0][c] << 1) | p[0];
+        int b = (q[1][c] << 1) | p[1];
+        for (int i = 0; i < 16; ++i) {
+            palette[i][c] = ((64 - BC7Weights[i]) * a + BC7Weights[i] * b + 32) >> 6;
+        }
+    }
+
+    return pickIndices<16, 4>(block, palette, indices);
+}
+
+// BC7 mode 6, one subset with 7.7.7.7 endpoints, p-bits and 4 bit indices
+void encodeBC7(const block_t& block, uint8_t * out)
+{
+    static float weights[16];
+    static bool init = [](){
+        for (int i = 0; i < 16; ++i) {
+            weights[i] = BC7Weights[i] / 64.f;
+        }
+        return true;
+    }();
+    (void)init;
+
+    float lo[4], hi[4];
+    fitLine<4>(block, lo, hi);
+
+    int q[2][4];
+    int p[2];
+    int indices[16];
+    int error = pickBC7Indices(block, lo, hi, q, p, indices);
+
+    // One least squares pass on the endpoints, kept if it helps
+    float e0[4], e1[4];
+    if (error > 0 && refineEndpoints<4>(block, weights, indices, e0, e1)) {
+        int rq[2][4];
+        int rp[2];
+        int refined[16];
+        if (pickBC7Indices(block, e0, e1, rq, rp, refined) < error) {
+            memcpy(q, rq, sizeof(rq));
+            memcpy(p, rp, sizeof(rp));
+            memcpy(indices, refined, sizeof(refined));
+        }
+    }
+
+    // The first index is stored without its top bit, swap the endpoints so
+    // it is clear. The weights are symmetric so the palette just reverses.
+    if (indices[0] & 8) {
+        std::swap(q[0], q[1]);
+        std::swap(p[0], p[1]);
+        for (int i = 0; i < 16; ++i) {
+            indices[i] = 15 - indices[i];
+        }
+    }
+
+    memset(out, 0, 16);
+    bitWriter_t writer = { out };
+
+    writer.write(1 << 6, 7);
+    for (int c = 0; c < 4; ++c) {
+        writer.write(q[0][c], 7);
+        writer.write(q[1][c], 7);
+    }
+    writer.write(p[0], 1);
+    writer.write(p[1], 1);
+
+    writer.write(indices[0], 3);
+    for (int i = 1; i < 16; ++i) {
+        writer.write(indices[i], 4);
+    }
+}
+
+void encodeBlock(const block_t& block, BlockFormat format, uint8_t * out)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        encodeColor(block, out);
+        break;
+    case BlockFormat::BC3:
+        encodeChannel(block, 3, out);
+        encodeColor(block, out + 8);
+        break;
+    case BlockFormat::BC4:
+        encodeChannel(block, 0, out);
+        break;
+    case BlockFormat::BC5:
+        encodeChannel(block, 0, out);
+        encodeChannel(block, 1, out + 8);
+        break;
+    case BlockFormat::BC7:
+        encodeBC7(block, out);
+        break;
+    default:
+        break;
+    }
+}
+
+struct blockRow_t {
+    const uint8_t * pixels;
+    glm::ivec2 size;
+    int row;
+    uint8_t * out;
+};
+
+// Encodes every block of the row
+void encodeRow(const blockRow_t& row, BlockFormat format)
+{
+    const size_t blockBytes = getBlockBytes(format);
+    int blocksX = (row.size.x + 3) / 4;
+
+    block_t block;
+    for (int bx = 0; bx < blocksX; ++bx) {
+        loadBlock(row.pixels, row.size, bx, row.row, block);
+        encodeBlock(block, format, row.out + bx * blockBytes);
+    }
+}
+
+} // namespace
+
+GLenum GetBlockFormatGL(BlockFormat format)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case BlockFormat::BC3:
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case BlockFormat::BC4:
+        return GL_COMPRESSED_RED_RGTC1;
+    case BlockFormat::BC5:
+        return GL_COMPRESSED_RG_RGTC2;
+    case BlockFormat::BC7:
+        return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    default:
+        return GL_NONE;
+    }
+}
+
+BlockFormat GetBlockFormat(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        return BlockFormat::BC1;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        return BlockFormat::BC3;
+    case GL_COMPRESSED_RED_RGTC1:
+        return BlockFormat::BC4;
+    case GL_COMPRESSED_RG_RGTC2:
+        return BlockFormat::BC5;
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        return BlockFormat::BC7;
+    default:
+        return BlockFormat::None;
+    }
+}
+
+size_t GetEncodedSize(BlockFormat format, glm::ivec2 size, int levels)
+{
+    size_t total = 0;
+    for (int i = 0; i < levels; ++i) {
+        total += (size_t)((size.x + 3) / 4) * ((size.y + 3) / 4) * getBlockBytes(format);
+        size = glm::ivec2(std::max(1, size.x / 2), std::max(1, size.y / 2));
+    }
+    return total;
+}
+
+int GetMipLevelCount(glm::ivec2 size)
+{
+    int levels = 1;
+    for (int largest = std::max(size.x, size.y); largest > 1; largest /= 2) {
+        ++levels;
+    }
+    return levels;
+}
+
+bool IsBlockFormatSupported(BlockFormat format)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+    case BlockFormat::BC3:
+        return GLAD_GL_EXT_texture_compression_s3tc;
+    case BlockFormat::BC4:
+    case BlockFormat::BC5:
+        return GLAD_GL_VERSION_3_0;
+    case BlockFormat::BC7:
+        return (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_compression_bptc);
+    default:
+        return false;
+    }
+}
+
+bool EncodeTexture(
+    const uint8_t * pixels,
+    glm::ivec2 size,
+    BlockFormat format,
+    bool mipmaps,
+    EncodedTexture& out,
+    JobSystem * jobs /*= nullptr*/)
+{
+    if (!pixels || size.x <= 0 || size.y <= 0 || format == BlockFormat::None) {
+        return false;
+    }
+
+    MipChain chain;
+    if (mipmaps) {
+        if (!GenerateMipChain(pixels, size, MipmapOptions(), chain, jobs)) {
+            return false;
+        }
+    } else {
+        chain.Size = size;
+        chain.Levels = 1;
+        chain.Data.assign(pixels, pixels + (size_t)size.x * size.y * 4);
+    }
+
+    return EncodeMipChain(chain, format, out, jobs);
+}
+
+bool EncodeMipChain(
+    const MipChain& chain,
+    BlockFormat format,
+    EncodedTexture& out,
+    JobSystem * jobs /*= nullptr*/)
+{
+    if (chain.Levels < 1 || chain.Data.size() < GetMipChainSize(chain.Size, chain.Levels) || format == BlockFormat::None) {
+        return false;
+    }
+
+    out.Format = format;
+    out.Size = chain.Size;
+    out.Levels = chain.Levels;
+    out.Data.assign(GetEncodedSize(format, chain.Size, out.Levels), 0);
+
+    if (!jobs) {
+        jobs = Program::GetJobSystem();
+    }
+
+    std::vector<blockRow_t> rows;
+
+    const uint8_t * levelPixels = chain.Data.data();
+    glm::ivec2 levelSize = chain.Size;
+    uint8_t * levelOut = out.Data.data();
+    for (int level = 0; level < out.Levels; ++level) {
+        int blocksX = (levelSize.x + 3) / 4;
+        int blocksY = (levelSize.y + 3) / 4;
+        size_t rowBytes = (size_t)blocksX * getBlockBytes(format);
+
+        for (int by = 0; by < blocksY; ++by) {
+            rows.push_back(blockRow_t{ levelPixels, levelSize, by, levelOut + by * rowBytes });
+        }
+
+        levelOut += rowBytes * blocksY;
+        levelPixels += (size_t)levelSize.x * levelSize.y * 4;
+        levelSize = glm::ivec2(std::max(1, levelSize.x / 2), std::max(1, levelSize.y / 2));
+    }
+
+    // The rows of every level are split up together, so the small levels at
+    // the end don't each wait on a handful of jobs of their own
+    jobs->ParallelFor(rows.size(), 0, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            encodeRow(rows[i], format);
+        }
+    });
+
+    return true;
+}
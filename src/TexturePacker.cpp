@@ -0,0 +1,285 @@
+#include <TexturePacker.hpp>
+
+#include <Log.hpp>
+#include <TextureEncoder.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <tuple>
+
+TexturePacker::TexturePacker(Options opts /*= Options()*/)
+    : opts_(opts)
+{
+    opts_.Padding = std::max(0, opts_.Padding);
+    opts_.MaxLayers = std::max(1, opts_.MaxLayers);
+
+    // Every atlas image has to fit a page with its gutter
+    opts_.PageSize = std::max(opts_.PageSize, opts_.MaxAtlasSize + opts_.Padding * 2);
+}
+
+size_t TexturePacker::Add(const uint8_t * pixels, glm::ivec2 size, const Texture::Options& opts)
+{
+    Image image;
+    image.Options = opts;
+
+    // Still takes an index so callers' indices line up, its map stays empty
+    if (packed_ || !pixels || size.x <= 0 || size.y <= 0) {
+        LogError("Invalid image for texture packing");
+        images_.push_back(std::move(image));
+        return images_.size() - 1;
+    }
+
+    image.Pixels.assign(pixels, pixels + (size_t)size.x * size.y * 4);
+    image.Size = size;
+
+    images_.push_back(std::move(image));
+
+    return images_.size() - 1;
+}
+
+void TexturePacker::Pack()
+{
+    if (packed_) {
+        return;
+    }
+
+    arrays_.clear();
+    stats_ = Stats();
+    stats_.Images = images_.size();
+
+    // Ordered so the same images always pack the same way
+    using layerKey_t = std::tuple<int, int, GLenum, GLenum, GLenum, GLenum, bool, bool>;
+    using atlasKey_t = std::tuple<GLenum, GLenum, bool, bool>;
+
+    std::map<layerKey_t, std::vector<size_t>> layerGroups;
+    std::map<atlasKey_t, std::vector<size_t>> atlasGroups;
+
+    for (size_t i = 0; i < images_.size(); ++i) {
+        const auto& image = images_[i];
+        const auto& opts = image.Options;
+
+        if (image.Pixels.empty()) {
+            continue;
+        }
+
+        // Pages clamp and their gutters repeat the edge, so tiling images
+        // keep a layer of their own to wrap on
+        bool clamped = (opts.WrapS == GL_CLAMP_TO_EDGE && opts.WrapT == GL_CLAMP_TO_EDGE);
+
+        if (clamped && image.Size.x <= opts_.MaxAtlasSize && image.Size.y <= opts_.MaxAtlasSize) {
+            atlasGroups[{ opts.MagFilter, opts.MinFilter, opts.Mipmap, opts.SRGB }].push_back(i);
+        } else {
+            layerGroups[{ image.Size.x, image.Size.y, opts.WrapS, opts.WrapT, opts.MagFilter, opts.MinFilter, opts.Mipmap, opts.SRGB }].push_back(i);
+        }
+    }
+
+    for (const auto& [key, group] : layerGroups) {
+        packLayers(group);
+    }
+
+    for (const auto& [key, group] : atlasGroups) {
+        packAtlas(group);
+    }
+
+    for (auto& image : images_) {
+        image.Pixels = std::vector<uint8_t>();
+    }
+
+    stats_.Arrays = arrays_.size();
+    for (const auto& array : arrays_) {
+        stats_.Layers += array.Layers.size();
+    }
+
+    packed_ = true;
+}
+
+std::vector<TextureMap> TexturePacker::Upload()
+{
+    Pack();
+
+    std::vector<std::shared_ptr<Texture>> textures;
+    for (auto& array : arrays_) {
+        auto texture = std::make_shared<Texture>();
+        if (!texture->CreateArray(array.Size, (int)array.Layers.size(), GL_RGBA8, array.Levels, array.Options)) {
+            textures.push_back(nullptr);
+            continue;
+        }
+
+        for (size_t layer = 0; layer < array.Layers.size(); ++layer) {
+            texture->UploadLayer((int)layer, 0, array.Layers[layer].data(), GL_RGBA, GL_UNSIGNED_BYTE);
+        }
+
+        if (array.Levels > 1) {
+            texture->GenerateMipmaps();
+        }
+
+        array.Layers = std::vector<std::vector<uint8_t>>();
+
+        LogVerbose("Packed texture array %dx%d with %zu layers", array.Size.x, array.Size.y, (size_t)texture->GetLayerCount());
+
+        textures.push_back(std::move(texture));
+    }
+
+    std::vector<TextureMap> maps;
+    maps.reserve(images_.size());
+
+    for (const auto& image : images_) {
+        if (image.ArrayIndex >= textures.size()) {
+            maps.emplace_back();
+            continue;
+        }
+
+        TextureMap map(textures[image.ArrayIndex]);
+        map.Layer = image.Layer;
+        map.Transform = image.Transform;
+        maps.push_back(std::move(map));
+    }
+
+    return maps;
+}
+
+void TexturePacker::packLayers(const std::vector<size_t>& group)
+{
+    for (size_t first = 0; first < group.size(); first += opts_.MaxLayers) {
+        size_t last = std::min(first + (size_t)opts_.MaxLayers, group.size());
+
+        const auto& front = images_[group[first]];
+
+        Array array;
+        array.Size = front.Size;
+        array.Levels = (front.Options.Mipmap ? GetMipLevelCount(front.Size) : 1);
+        array.Options = front.Options;
+
+        for (size_t i = first; i < last; ++i) {
+            auto& image = images_[group[i]];
+            image.ArrayIndex = arrays_.size();
+            image.Layer = (int)array.Layers.size();
+            array.Layers.push_back(std::move(image.Pixels));
+        }
+
+        arrays_.push_back(std::move(array));
+    }
+}
+
+void TexturePacker::packAtlas(const std::vector<size_t>& group)
+{
+    const int pad = opts_.Padding;
+
+    // Tallest first keeps the shelves full
+    auto order = group;
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return images_[a].Size.y > images_[b].Size.y;
+    });
+
+    struct place_t {
+        int page;
+        glm::ivec2 pos;
+    };
+
+    std::vector<place_t> places(order.size());
+
+    int page = 0;
+    glm::ivec2 cursor(0);
+    int shelfHeight = 0;
+    glm::ivec2 used(0);
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        glm::ivec2 cell(images_[order[i]].Size.x + pad * 2, images_[order[i]].Size.y + pad * 2);
+
+        if (cursor.x + cell.x > opts_.PageSize) {
+            cursor = glm::ivec2(0, cursor.y + shelfHeight);
+            shelfHeight = 0;
+        }
+
+        if (cursor.y + cell.y > opts_.PageSize) {
+            ++page;
+            cursor = glm::ivec2(0);
+            shelfHeight = 0;
+        }
+
+        places[i] = place_t{ page, cursor };
+
+        cursor.x += cell.x;
+        shelfHeight = std::max(shelfHeight, cell.y);
+        used = glm::ivec2(std::max(used.x, cursor.x), std::max(used.y, cursor.y + shelfHeight));
+    }
+
+    // Gutters are only clean down to the level where a texel covers Padding
+    // texels of the first
+    bool mipmap = images_[order.front()].Options.Mipmap;
+    int levels = 1;
+    if (mipmap) {
+        while ((1 << levels) <= pad) {
+            ++levels;
+        }
+    }
+
+    // A lone page only needs to hold what was placed, rounded so its mip
+    // levels stay aligned with the gutters
+    glm::ivec2 pageSize(opts_.PageSize);
+    if (page == 0) {
+        int align = (1 << (levels - 1));
+        pageSize.x = (used.x + align - 1) / align * align;
+        pageSize.y = (used.y + align - 1) / align * align;
+    }
+
+    levels = std::min(levels, GetMipLevelCount(pageSize));
+
+    Texture::Options opts = images_[order.front()].Options;
+    opts.WrapS = GL_CLAMP_TO_EDGE;
+    opts.WrapT = GL_CLAMP_TO_EDGE;
+
+    size_t firstArray = arrays_.size();
+    int pageCount = page + 1;
+
+    for (int first = 0; first < pageCount; first += opts_.MaxLayers) {
+        int count = std::min(opts_.MaxLayers, pageCount - first);
+
+        Array array;
+        array.Size = pageSize;
+        array.Levels = levels;
+        array.Options = opts;
+        array.Layers.resize(count);
+
+        for (auto& layer : array.Layers) {
+            layer.resize((size_t)pageSize.x * pageSize.y * 4, 0);
+        }
+
+        arrays_.push_back(std::move(array));
+    }
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        auto& image = images_[order[i]];
+        const auto& place = places[i];
+
+        image.ArrayIndex = firstArray + place.page / opts_.MaxLayers;
+        image.Layer = place.page % opts_.MaxLayers;
+        image.Transform = glm::vec4(
+            (float)image.Size.x / pageSize.x,
+            (float)image.Size.y / pageSize.y,
+            (float)(place.pos.x + pad) / pageSize.x,
+            (float)(place.pos.y + pad) / pageSize.y);
+
+        auto& layer = arrays_[image.ArrayIndex].Layers[image.Layer];
+
+        // Every row of the cell repeats the nearest image row, and starts and
+        // ends with copies of that row's edge texels
+        const size_t rowBytes = (size_t)image.Size.x * 4;
+        for (int y = 0; y < image.Size.y + pad * 2; ++y) {
+            int srcY = std::min(std::max(y - pad, 0), image.Size.y - 1);
+            const uint8_t * src = image.Pixels.data() + srcY * rowBytes;
+            uint8_t * dst = layer.data() + ((size_t)(place.pos.y + y) * pageSize.x + place.pos.x) * 4;
+
+            for (int x = 0; x < pad; ++x) {
+                memcpy(dst + x * 4, src, 4);
+                memcpy(dst + (pad + image.Size.x + x) * 4, src + rowBytes - 4, 4);
+            }
+
+            memcpy(dst + pad * 4, src, rowBytes);
+        }
+
+        ++stats_.AtlasImages;
+    }
+}
@@ -0,0 +1,370 @@
+#include <TextureStreamer.hpp>
+
+#include <Log.hpp>
+#include <StagingBuffer.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+glm::ivec2 getLevelSize(glm::ivec2 size, int level)
+{
+    return glm::ivec2(std::max(1, size.x >> level), std::max(1, size.y >> level));
+}
+
+} // namespace
+
+TextureStreamer * TextureStreamer::Inst()
+{
+    static TextureStreamer streamer;
+    return &streamer;
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    Shutdown();
+}
+
+void TextureStreamer::Shutdown()
+{
+    for (auto& entry : entries_) {
+        cancelPending(entry);
+    }
+
+    entries_.clear();
+    lookup_.clear();
+    residentBytes_ = 0;
+}
+
+std::shared_ptr<Texture> TextureStreamer::Add(Source source, Texture::Options opts /*= Texture::Options()*/)
+{
+    if (source.InternalFormat == 0 || source.Levels.empty() || source.Size.x <= 0 || source.Size.y <= 0) {
+        LogError("Invalid streamed texture");
+        return nullptr;
+    }
+
+    if (!IsTextureFormatSupported(source.InternalFormat)) {
+        LogError("Unsupported texture format %04x", source.InternalFormat);
+        return nullptr;
+    }
+
+    // Anything past the 1x1 level can't be stored
+    source.Levels.resize(std::min((int)source.Levels.size(), GetMipLevelCount(source.Size)));
+
+    auto texture = std::make_shared<Texture>();
+
+    // A texture freed since the last Update may have left its address behind
+    auto found = lookup_.find(texture.get());
+    if (found != lookup_.end()) {
+        auto& stale = *found->second;
+        cancelPending(stale);
+        residentBytes_ -= getResidentBytes(stale, stale.Resident);
+        entries_.erase(found->second);
+        lookup_.erase(found);
+    }
+
+    Entry entry;
+    entry.Handle = texture;
+    entry.Key = texture.get();
+    entry.Options = opts;
+    entry.Data = std::move(source);
+    entry.Resident = (int)entry.Data.Levels.size();
+    entry.LastFrame = frame_;
+
+    for (size_t level = 0; level < entry.Data.Levels.size(); ++level) {
+        size_t bytes = GetTextureLevelSize(entry.Data.InternalFormat, getLevelSize(entry.Data.Size, (int)level));
+        entry.LevelBytes.push_back(bytes ? bytes : entry.Data.Levels[level].size());
+    }
+
+    entries_.push_front(std::move(entry));
+    lookup_[texture.get()] = entries_.begin();
+
+    // The smallest levels are always allowed, even over budget
+    auto& added = entries_.front();
+    added.Wanted = getMinResident(added);
+    if (!upload(added, added.Wanted, *texture)) {
+        lookup_.erase(texture.get());
+        entries_.pop_front();
+        return nullptr;
+    }
+
+    added.Resident = added.Wanted;
+    residentBytes_ += getResidentBytes(added, added.Resident);
+
+    return texture;
+}
+
+void TextureStreamer::MakeSource(const MipChain& chain, Source& out)
+{
+    out = Source();
+    out.InternalFormat = GL_RGBA8;
+    out.Format = GL_RGBA;
+    out.Type = GL_UNSIGNED_BYTE;
+    out.Size = chain.Size;
+
+    const uint8_t * data = chain.Data.data();
+    for (int level = 0; level < chain.Levels; ++level) {
+        glm::ivec2 size = getLevelSize(chain.Size, level);
+        size_t bytes = (size_t)size.x * size.y * 4;
+
+        out.Levels.emplace_back(data, data + bytes);
+        data += bytes;
+    }
+}
+
+void TextureStreamer::MakeSource(const EncodedTexture& encoded, Source& out)
+{
+    out = Source();
+    out.InternalFormat = GetBlockFormatGL(encoded.Format);
+    out.Size = encoded.Size;
+
+    const uint8_t * data = encoded.Data.data();
+    for (int level = 0; level < encoded.Levels; ++level) {
+        size_t bytes = GetEncodedSize(encoded.Format, getLevelSize(encoded.Size, level), 1);
+
+        out.Levels.emplace_back(data, data + bytes);
+        data += bytes;
+    }
+}
+
+void TextureStreamer::MakeSource(const TextureContainer& container, Source& out)
+{
+    out = Source();
+    out.InternalFormat = container.InternalFormat;
+    out.Format = container.Format;
+    out.Type = container.Type;
+    out.Size = container.Size;
+
+    for (const auto& level : container.Levels) {
+        out.Levels.emplace_back(level.Data, level.Data + level.Size);
+    }
+}
+
+void TextureStreamer::Request(const Texture * texture, float screenSize)
+{
+    auto found = lookup_.find(texture);
+    if (found == lookup_.end()) {
+        return;
+    }
+
+    auto& entry = *found->second;
+
+    // Each level down is half the size, so the level that is about one texel
+    // per pixel
+    float largest = (float)std::max(entry.Data.Size.x, entry.Data.Size.y);
+    int level = 0;
+    if (screenSize < largest) {
+        level = (int)std::floor(std::log2(largest / std::max(screenSize, 1.f)));
+    }
+
+    level = std::min(level, getMinResident(entry));
+
+    if (entry.LastFrame != frame_) {
+        entry.LastFrame = frame_;
+        entry.Wanted = level;
+        entry.ScreenSize = screenSize;
+    } else {
+        entry.Wanted = std::min(entry.Wanted, level);
+        entry.ScreenSize = std::max(entry.ScreenSize, screenSize);
+    }
+
+    entries_.splice(entries_.begin(), entries_, found->second);
+}
+
+void TextureStreamer::Update()
+{
+    frameStats_ = Stats();
+
+    std::vector<Entry *> requested;
+
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        auto& entry = *it;
+
+        auto texture = entry.Handle.lock();
+        if (!texture) {
+            cancelPending(entry);
+            residentBytes_ -= getResidentBytes(entry, entry.Resident);
+
+            // Add may have already reused the address
+            auto found = lookup_.find(entry.Key);
+            if (found != lookup_.end() && found->second == it) {
+                lookup_.erase(found);
+            }
+
+            it = entries_.erase(it);
+            continue;
+        }
+
+        // The old levels go with the replacement once they're swapped out
+        if (entry.Pending && entry.Pending->IsReady()) {
+            texture->Swap(*entry.Pending);
+            entry.Pending.reset();
+
+            residentBytes_ -= getResidentBytes(entry, entry.Resident);
+            entry.Resident = entry.PendingFirst;
+        }
+
+        if (entry.LastFrame == frame_ && entry.Wanted < entry.Resident) {
+            ++frameStats_.PendingRequests;
+
+            if (!entry.Pending || entry.PendingFirst > entry.Wanted) {
+                requested.push_back(&entry);
+            }
+        }
+
+        ++it;
+    }
+
+    std::stable_sort(requested.begin(), requested.end(), [](const Entry * a, const Entry * b) {
+        return a->ScreenSize > b->ScreenSize;
+    });
+
+    auto staging = StagingBuffer::Inst();
+
+    for (Entry * entry : requested) {
+        if (staging->IsOverBudget()) {
+            break;
+        }
+
+        // A coarser replacement on its way is outdated now
+        cancelPending(*entry);
+
+        // Settle for coarser levels when nothing else can give way
+        int first = entry->Wanted;
+        for (; first < entry->Resident; ++first) {
+            size_t bytes = getResidentBytes(*entry, first);
+            if (residentBytes_ + bytes <= budget_ || evict(residentBytes_ + bytes - budget_, entry)) {
+                break;
+            }
+        }
+
+        if (first >= entry->Resident) {
+            continue;
+        }
+
+        auto pending = std::make_unique<Texture>();
+        if (!upload(*entry, first, *pending)) {
+            continue;
+        }
+
+        entry->Pending = std::move(pending);
+        entry->PendingFirst = first;
+        residentBytes_ += getResidentBytes(*entry, first);
+    }
+
+    totalEvictions_ += frameStats_.Evictions;
+
+    ++frame_;
+}
+
+TextureStreamer::Stats TextureStreamer::GetStats() const
+{
+    Stats stats = frameStats_;
+    stats.Textures = entries_.size();
+    stats.ResidentBytes = residentBytes_;
+    stats.BudgetBytes = budget_;
+    stats.TotalEvictions = totalEvictions_;
+    return stats;
+}
+
+size_t TextureStreamer::getResidentBytes(const Entry& entry, int first)
+{
+    size_t bytes = 0;
+    for (int level = first; level < (int)entry.LevelBytes.size(); ++level) {
+        bytes += entry.LevelBytes[level];
+    }
+    return bytes;
+}
+
+int TextureStreamer::getMinResident(const Entry& entry) const
+{
+    int levels = (int)entry.Data.Levels.size();
+
+    int level = 0;
+    while (level < levels - 1) {
+        glm::ivec2 size = getLevelSize(entry.Data.Size, level);
+        if (size.x <= minResidentSize_ && size.y <= minResidentSize_) {
+            break;
+        }
+        ++level;
+    }
+
+    return level;
+}
+
+bool TextureStreamer::upload(Entry& entry, int first, Texture& texture)
+{
+    const auto& data = entry.Data;
+    int levels = (int)data.Levels.size();
+
+    if (!texture.Create(getLevelSize(data.Size, first), data.InternalFormat, levels - first, entry.Options)) {
+        return false;
+    }
+
+    for (int level = first; level < levels; ++level) {
+        const auto& pixels = data.Levels[level];
+
+        bool ok = (data.Format == 0
+            ? texture.UploadCompressed(level - first, pixels.data(), pixels.size())
+            : texture.Upload(level - first, pixels.data(), data.Format, data.Type));
+
+        if (!ok) {
+            return false;
+        }
+
+        ++frameStats_.Uploads;
+        frameStats_.UploadedBytes += pixels.size();
+    }
+
+    return true;
+}
+
+void TextureStreamer::cancelPending(Entry& entry)
+{
+    if (entry.Pending) {
+        residentBytes_ -= getResidentBytes(entry, entry.PendingFirst);
+        entry.Pending.reset();
+    }
+}
+
+bool TextureStreamer::evict(size_t bytes, const Entry * keep)
+{
+    size_t freed = 0;
+
+    // Least recently requested first, up to the ones requested this frame
+    for (auto it = entries_.rbegin(); it != entries_.rend() && freed < bytes; ++it) {
+        auto& entry = *it;
+        if (entry.LastFrame == frame_) {
+            break;
+        }
+
+        if (&entry == keep) {
+            continue;
+        }
+
+        auto texture = entry.Handle.lock();
+        if (!texture) {
+            continue;
+        }
+
+        size_t before = residentBytes_;
+        cancelPending(entry);
+
+        // Evicted textures haven't been drawn lately, so they can be emptied
+        // and refilled in place
+        int first = getMinResident(entry);
+        if (entry.Resident < first && upload(entry, first, *texture)) {
+            residentBytes_ -= getResidentBytes(entry, entry.Resident);
+            residentBytes_ += getResidentBytes(entry, first);
+            entry.Resident = first;
+        }
+
+        if (residentBytes_ < before) {
+            freed += before - residentBytes_;
+            ++frameStats_.Evictions;
+        }
+    }
+
+    return (freed >= bytes);
+}
@@ -1,18 +1,33 @@
 #include <glTF2.hpp>
 
 #include <Util.hpp>
+#include <GeometryArena.hpp>
+#include <Hash.hpp>
+#include <glTF2Cache.hpp>
+#include <glTF2Document.hpp>
+#include <glTF2Loader.hpp>
+#include <ImageDecoder.hpp>
 #include <Log.hpp>
+#include <MappedFile.hpp>
 #include <Material.hpp>
 #include <Mesh.hpp>
+#include <Program.hpp>
+#include <StagingBuffer.hpp>
 #include <Texture.hpp>
+#include <TextureCache.hpp>
+#include <TexturePacker.hpp>
+#include <TextureStreamer.hpp>
 
-#include <depend/JSON.hpp>
 #include <depend/Base64.hpp>
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 #include <stb/stb_image.h>
@@ -27,279 +42,612 @@ enum class ChunkType : uint32_t
 	BIN  = 0x004E4942, // BIN
 };
 
+bool readFile(const std::string& filename, storage_t& storage, const Options& opts, buffer_t& out)
+{
+    if (opts.MapFiles) {
+        auto file = std::make_unique<MappedFile>();
+        if (file->Open(filename)) {
+            out = buffer_t{ file->GetData(), file->GetSize() };
+            storage.files.push_back(std::move(file));
+            return true;
+        }
+    }
+
+    std::ifstream file(filename, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    size_t size = (size_t)file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    storage.blocks.push_back(std::vector<uint8_t>(size));
+    auto& block = storage.blocks.back();
+
+    file.read(reinterpret_cast<char *>(block.data()), size);
+    file.close();
 
-glm::vec3 parseVec3(const json& value, glm::vec3 def) 
+    out = buffer_t{ block.data(), block.size() };
+    return true;
+}
+
+std::vector<buffer_t> loadBuffers(
+    const document_t& doc, 
+    const std::string& dir, 
+    const std::vector<buffer_t>& binChunks,
+    storage_t& storage,
+    const Options& opts)
 {
-    if (value.is_array() && value.size() == 3) {
-        const auto& v = value.get<std::vector<float>>();
-        return glm::make_vec3(v.data());
+    std::vector<buffer_t> buffers;
+    
+    for (const auto& desc : doc.buffers) {
+        const auto& uri = desc.uri;
+
+        // Keep indices stable even if a buffer fails to load
+        buffers.push_back(buffer_t{ nullptr, 0 });
+        auto& buffer = buffers.back();
+
+        if (uri.empty()) {
+            // Only the first buffer may refer to the BIN chunk of a GLB
+            if (buffers.size() > 1 || binChunks.empty()) {
+                LogError("glTF buffer %zu is missing a uri", buffers.size() - 1);
+                continue;
+            }
+
+            buffer = binChunks.front();
+        } else if (uri.compare(0, strlen("data:"), "data:") == 0) {
+            std::string_view payload(uri);
+            payload.remove_prefix(uri.find(',') + 1);
+
+            storage.blocks.push_back(std::vector<uint8_t>(macaron::Base64::DecodedLength(payload)));
+            auto& block = storage.blocks.back();
+
+            if (!macaron::Base64::Decode(payload, block.data(), block.size())) {
+                LogError("Invalid base64 data in glTF buffer %zu", buffers.size() - 1);
+                continue;
+            }
+
+            buffer = buffer_t{ block.data(), block.size() };
+        } else {
+            LogVerbose("glTF buffer %zu, %s", desc.byteLength, uri);
+
+            if (!readFile(dir + "/" + uri, storage, opts, buffer)) {
+                LogError("Failed to open glTF data file '%s'", uri);
+                continue;
+            }
+
+            LogLoad("glTF data file '%s'", uri);
+        }
+
+        if (buffer.size < desc.byteLength) {
+            LogWarn("Buffer size mismatch %zu < %zu", buffer.size, desc.byteLength);
+        }
     }
-    return def;
+
+    return buffers;
 }
 
-glm::vec4 parseVec4(const json& value, glm::vec4 def)
+// Checks every bufferView against the loaded buffers once. Views pointing
+// at a missing or failed buffer, or reaching past its end, get a buffer of
+// -1, which getBufferViewData turns into nullptr for their consumers.
+void validateBufferViews(document_t& doc, const std::vector<buffer_t>& buffers)
 {
-    if (value.is_array() && value.size() == 4) {
-        const auto& v = value.get<std::vector<float>>();
-        return glm::make_vec4(v.data());
+    for (size_t i = 0; i < doc.bufferViews.size(); ++i) {
+        auto& bufferView = doc.bufferViews[i];
+
+        if (bufferView.buffer < 0 || bufferView.buffer >= (int)buffers.size()) {
+            LogError("Invalid glTF bufferView %zu buffer %d", i, bufferView.buffer);
+            bufferView.buffer = -1;
+            continue;
+        }
+
+        const auto& buffer = buffers[bufferView.buffer];
+        if (!buffer.data) {
+            LogError("glTF bufferView %zu refers to buffer %d, which failed to load", i, bufferView.buffer);
+            bufferView.buffer = -1;
+            continue;
+        }
+
+        if (bufferView.byteOffset > buffer.size || bufferView.byteLength > buffer.size - bufferView.byteOffset) {
+            LogError("glTF bufferView %zu out of bounds, %zu + %zu > %zu", i,
+                bufferView.byteOffset, bufferView.byteLength, buffer.size);
+            bufferView.buffer = -1;
+        }
     }
-    return def;
 }
 
-glm::quat parseQuat(const json& value, glm::quat def) 
+// The first byte of a bufferView that passed validateBufferViews, nullptr
+// for one that didn't
+const uint8_t * getBufferViewData(const bufferView_t& bufferView, const std::vector<buffer_t>& buffers)
 {
-    if (value.is_array() && value.size() == 4) {
-        const auto& v = value.get<std::vector<float>>();
-        return glm::quat(v[3], v[0], v[1], v[2]);
+    if (bufferView.buffer < 0 || bufferView.buffer >= (int)buffers.size() || !buffers[bufferView.buffer].data) {
+        return nullptr;
     }
-    return def;
+
+    return buffers[bufferView.buffer].data + bufferView.byteOffset;
 }
 
-std::vector<std::vector<uint8_t>> loadBuffers(const json& data, const std::string& dir)
+std::unique_ptr<ImageDecoder> loadImages(
+    const document_t& doc, 
+    const std::string& dir, 
+    const std::vector<buffer_t>& buffers,
+    const Options& opts,
+    const std::vector<bool>& skip /*= {}*/)
 {
-    std::vector<std::vector<uint8_t>> buffers;
-    
-    auto it = data.find("buffers");
-    if (it != data.end()) {
-        if (it.value().is_array()) {
-            auto& array = it.value();
-            for (auto& object : array) {
-                if (object.is_object()) {
-                    size_t byteLength = object.value<size_t>("byteLength", 0);
-                    const auto& uri = object.value("uri", "");
-
-					if (uri.compare(0, strlen("data:"), "data:") == 0) {
-						size_t pivot = uri.find(',');
-						buffers.push_back(macaron::Base64::Decode(uri.substr(pivot + 1)));
-					} else {
-						LogVerbose("glTF buffer %zu, %s", byteLength, uri);
-
-						std::ifstream bufferFile(dir + "/" + uri, std::ios::in | std::ios::binary);
-						if (!bufferFile.is_open()) {
-							LogError("Failed to open glTF data file '%s'", uri);
-							continue;
-						}
-
-						buffers.push_back(std::vector<uint8_t>(byteLength));
-						auto& buffer = buffers.back();
-
-						bufferFile.read(reinterpret_cast<char *>(buffer.data()), byteLength);
-						bufferFile.close();
-
-						LogLoad("glTF data file '%s'", uri);
-
-						if (buffer.size() != byteLength) {
-							LogWarn("Buffer size mismatch %zu != %zu", buffer.size(), byteLength);
-						}
-					}
-                }
+    std::vector<ImageDecoder::Source> sources;
+
+    for (size_t i = 0; i < doc.images.size(); ++i) {
+        const auto& image = doc.images[i];
+
+        sources.push_back(ImageDecoder::Source{});
+        auto& source = sources.back();
+
+        if (i < skip.size() && skip[i]) {
+            continue;
+        }
+
+        source.Container = (IsTextureContainerMimeType(image.mimeType) || IsTextureContainerFile(image.uri));
+
+        if (!image.uri.empty()) {
+            source.Filename = dir + "/" + image.uri;
+            LogVerbose("glTF image file '%s'", image.uri);
+        } else {
+            int bufferViewIndex = image.bufferView;
+
+            if (bufferViewIndex < 0 || bufferViewIndex >= (int)doc.bufferViews.size()) {
+                LogError("Invalid glTF image bufferView %d", bufferViewIndex);
+                continue;
+            }
+
+            const auto& bufferView = doc.bufferViews[bufferViewIndex];
+
+            source.Data = getBufferViewData(bufferView, buffers);
+            if (!source.Data) {
+                LogError("glTF image %zu has no data", i);
+                continue;
             }
+
+            source.Size = bufferView.byteLength;
         }
     }
 
-    return buffers;
+    // Decoding starts right away on the job system
+    return std::make_unique<ImageDecoder>(std::move(sources), opts.ImageMemoryBudget);
 }
 
-struct bufferView_t {
-    int buffer;
-    size_t byteLength;
-    size_t byteOffset;
-    size_t byteStride;
-    GLenum target;
-};
+// Block format for each texture from how materials sample it, None for all
+// of them unless opts.CompressTextures is set
+std::vector<BlockFormat> getTextureFormats(const document_t& doc, const Options& opts)
+{
+    std::vector<BlockFormat> formats(doc.textures.size(), BlockFormat::None);
+    if (!opts.CompressTextures) {
+        return formats;
+    }
 
-std::vector<bufferView_t> loadBufferViews(const json& data)
-{
-    std::vector<bufferView_t> bufferViews;
-
-    const auto it = data.find("bufferViews");
-    if (it != data.cend()) {
-        if (it.value().is_array()) {
-            const auto& array = it.value();
-            for (const auto& object : array) {
-                if (object.is_object()) {
-                    bufferViews.push_back(bufferView_t{
-                        object.value("buffer", -1),
-                        object.value<size_t>("byteLength", 0),
-                        object.value<size_t>("byteOffset", 0),
-                        object.value<size_t>("byteStride", 0),
-                        object.value<GLenum>("target", GL_INVALID_ENUM),
-                    });
-
-                    LogVerbose("BufferView %zu, %zu, %zu, %zu", 
-                        bufferViews.back().buffer, 
-                        bufferViews.back().byteLength, 
-                        bufferViews.back().byteOffset, 
-                        bufferViews.back().target);
-                }
-            }
+    enum : uint8_t {
+        UseBaseColor = 1 << 0,
+        UseMetallicRoughness = 1 << 1,
+        UseNormal = 1 << 2,
+        UseOcclusion = 1 << 3,
+        UseEmissive = 1 << 4,
+    };
+
+    std::vector<uint8_t> uses(doc.textures.size(), 0);
+
+    auto addUse = [&uses](const textureRef_t& ref, uint8_t use) {
+        if (ref.index >= 0 && ref.index < (int)uses.size()) {
+            uses[ref.index] |= use;
         }
+    };
+
+    for (const auto& material : doc.materials) {
+        addUse(material.baseColorTexture, UseBaseColor);
+        addUse(material.metallicRoughnessTexture, UseMetallicRoughness);
+        addUse(material.normalTexture, UseNormal);
+        addUse(material.occlusionTexture, UseOcclusion);
+        addUse(material.emissiveTexture, UseEmissive);
+    }
+
+    // BC4 and BC5 are core since 3.0, BC7 needs 4.2 or
+    // ARB_texture_compression_bptc and BC1 and BC3 always need
+    // EXT_texture_compression_s3tc
+    BlockFormat general = BlockFormat::BC7;
+    if (!IsBlockFormatSupported(BlockFormat::BC7)) {
+        general = (IsBlockFormatSupported(BlockFormat::BC3) ? BlockFormat::BC3 : BlockFormat::None);
     }
 
-    return bufferViews;
+    for (size_t i = 0; i < formats.size(); ++i) {
+        switch (uses[i])
+        {
+        case 0:
+            break;
+        case UseNormal:
+            formats[i] = BlockFormat::BC5;
+            break;
+        case UseOcclusion:
+            formats[i] = BlockFormat::BC4;
+            break;
+        case UseEmissive:
+            formats[i] = (IsBlockFormatSupported(BlockFormat::BC1) ? BlockFormat::BC1 : general);
+            break;
+        default:
+            formats[i] = general;
+            break;
+        }
+    }
+
+    return formats;
 }
 
-struct accessor_t {
-    int bufferView;
-    std::string type;
-    size_t byteOffset;
-    GLenum componentType;
-	bool normalized;
-    size_t count;
-    // TODO: min, max
-};
+// The sampler, plus how the levels are filtered on the loader thread: base
+// color and emissive maps in linear space and stored as sRGB, and base color
+// maps of MASK materials keeping their alpha test coverage
+Texture::Options getTextureOptions(const document_t& doc, size_t index, const Options& loadOpts)
+{
+    const auto& desc = doc.textures[index];
 
-std::vector<accessor_t> loadAccessors(const json& data)
-{
-    std::vector<accessor_t> accessors;
-
-    const auto& it = data.find("accessors");
-    if (it != data.cend()) {
-        if (it.value().is_array()) {
-            const auto& array = it.value();
-            for (const auto& object : array) {
-                if (object.is_object()) {
-                    accessors.push_back(accessor_t{
-                        object.value("bufferView", -1),
-                        object.value("type", ""),
-                        object.value<size_t>("byteOffset", 0),
-                        object.value<GLenum>("componentType", GL_INVALID_ENUM),
-						object.value<bool>("normalized", false),
-                        object.value<size_t>("count", 0),
-                        // TODO: min, max
-                    });
-                }
+    auto opts = (desc.sampler >= 0 && desc.sampler < (int)doc.samplers.size() 
+        ? doc.samplers[desc.sampler] 
+        : Texture::Options());
+
+    opts.CPUMipmaps = loadOpts.CPUMipmaps;
+    opts.Mipmaps.Filter = loadOpts.MipmapFilter;
+
+    for (const auto& material : doc.materials) {
+        if (material.baseColorTexture.index == (int)index) {
+            opts.SRGB = true;
+            opts.Mipmaps.SRGB = true;
+            if (material.alphaMode == "MASK") {
+                opts.Mipmaps.AlphaCutoff = material.alphaCutoff;
             }
         }
+
+        if (material.emissiveTexture.index == (int)index) {
+            opts.SRGB = true;
+            opts.Mipmaps.SRGB = true;
+        }
     }
 
-    return accessors;
+    return opts;
 }
 
-struct image_t {
-    glm::ivec2 size;
-    int components;
-    std::unique_ptr<uint8_t> data;
+// Options for each texture, resolved once since every material is searched
+std::vector<Texture::Options> getTextureOptions(const document_t& doc, const Options& opts)
+{
+    std::vector<Texture::Options> options(doc.textures.size());
+    for (size_t i = 0; i < doc.textures.size(); ++i) {
+        options[i] = getTextureOptions(doc, i, opts);
+    }
+
+    return options;
+}
+
+// Encoding is the slow part of a compressed texture, so it is kept separate
+// from the upload for the async loader to run it off the main thread. Empty
+// when format is None.
+EncodedTexture encodeTexture(
+    const ImageDecoder::Image& image,
+    BlockFormat format,
+    const Texture::Options& opts)
+{
+    EncodedTexture encoded;
+    if (format == BlockFormat::None || !image.Data || image.Components != 4) {
+        return encoded;
+    }
+
+    bool ok = false;
+    if (opts.Mipmap) {
+        MipChain chain;
+        ok = (GenerateMipChain(image.Data, image.Size, opts.Mipmaps, chain)
+            && EncodeMipChain(chain, format, encoded));
+    } else {
+        ok = EncodeTexture(image.Data, image.Size, format, false, encoded);
+    }
+
+    if (!ok) {
+        encoded = EncodedTexture();
+    }
+
+    return encoded;
+}
+
+// The levels of a texture uploaded uncompressed, filtered here for the same
+// reason as encodeTexture. Empty when it has no mipmaps.
+MipChain generateMipChain(
+    const ImageDecoder::Image& image,
+    const Texture::Options& opts)
+{
+    MipChain chain;
+    if (!image.Data || image.Components != 4) {
+        return chain;
+    }
+
+    if (!opts.Mipmap || !opts.CPUMipmaps) {
+        return chain;
+    }
+
+    if (!GenerateMipChain(image.Data, image.Size, opts.Mipmaps, chain)) {
+        chain = MipChain();
+    }
+
+    return chain;
+}
+
+// Textures that are already live in the TextureCache, looked up before any
+// decoding so images used only by them can be skipped
+struct sharedTextures_t {
+    std::vector<TextureCache::Key> keys;
+    std::vector<std::shared_ptr<Texture>> textures;
+    std::vector<bool> skipImages;
 };
 
-std::vector<image_t> loadImages(
-    const json& data, 
-    const std::string& dir, 
-    const std::vector<bufferView_t>& bufferViews, 
-    const std::vector<std::vector<uint8_t>>& buffers)
-{
-    std::vector<image_t> images;
-
-    const auto it = data.find("images");
-    if (it != data.cend()) {
-        if (it.value().is_array()) {
-            const auto& array = it.value();
-            for (const auto& object : array) {
-                if (object.is_object()) {
-                    images.push_back(image_t{});
-                    auto& image = images.back();
-
-                    const auto& uri = object.value("uri", "");
-                    if (!uri.empty()) {
-						const auto& imageFilename = dir + "/" + uri;
-						image.data.reset(stbi_load(
-							imageFilename.c_str(),
-							&image.size.x,
-							&image.size.y,
-							&image.components,
-							STBI_rgb_alpha)
-						);
-						image.components = STBI_rgb_alpha;
-
-						if (!image.data) {
-							LogError("Failed to load glTF image file '%s'", imageFilename);
-							continue;
-						}
-
-						LogLoad("glTF image file '%s'", uri);
-                    } else {
-                        int bufferViewIndex = object.value("bufferView", -1);
-                        //const auto& mimeType = object.value("mimeType", "");
-
-                        const auto& bufferView = bufferViews[bufferViewIndex];
-                        const auto& buffer = buffers[bufferView.buffer];
-
-                        image.data.reset(stbi_load_from_memory(
-                            buffer.data() + bufferView.byteOffset, 
-                            bufferView.byteLength, 
-                            &image.size.x, 
-                            &image.size.y, 
-                            &image.components, 
-                            STBI_rgb_alpha)
-                        );
-						image.components = STBI_rgb_alpha;
-                    }
-                }
+// Keys every texture by the hash of its image's file or bufferView bytes.
+// With keepImages nothing is skipped, the runtime cache needs the pixels of
+// every texture to bake.
+sharedTextures_t findSharedTextures(
+    const document_t& doc,
+    const std::string& dir,
+    const std::vector<buffer_t>& buffers,
+    const std::vector<BlockFormat>& formats,
+    const std::vector<Texture::Options>& textureOptions,
+    const Options& opts,
+    bool keepImages)
+{
+    sharedTextures_t shared;
+    shared.keys.resize(doc.textures.size());
+    shared.textures.resize(doc.textures.size());
+    shared.skipImages.resize(doc.images.size(), false);
+
+    if (!opts.ShareTextures) {
+        return shared;
+    }
+
+    std::vector<uint64_t> hashes(doc.images.size(), 0);
+    for (size_t i = 0; i < doc.images.size(); ++i) {
+        const auto& image = doc.images[i];
+
+        if (!image.uri.empty()) {
+            MappedFile file;
+            if (file.Open(dir + "/" + image.uri)) {
+                hashes[i] = Hash64(file.GetData(), file.GetSize());
+            }
+        } else if (image.bufferView >= 0 && image.bufferView < (int)doc.bufferViews.size()) {
+            const auto& bufferView = doc.bufferViews[image.bufferView];
+            const uint8_t * data = getBufferViewData(bufferView, buffers);
+            if (data) {
+                hashes[i] = Hash64(data, bufferView.byteLength);
             }
         }
     }
 
-    return images;
+    // An image can be skipped once every texture using it has been found
+    std::vector<bool> needed(doc.images.size(), false);
+
+    for (size_t i = 0; i < doc.textures.size(); ++i) {
+        int source = doc.textures[i].source;
+        if (source < 0 || source >= (int)doc.images.size()) {
+            continue;
+        }
+
+        auto& key = shared.keys[i];
+        key.Hash = hashes[source];
+        key.Options = textureOptions[i];
+        key.Options.Compression = formats[i];
+
+        shared.textures[i] = TextureCache::Inst()->Find(key);
+        if (!shared.textures[i]) {
+            needed[source] = true;
+        }
+    }
+
+    for (size_t i = 0; i < doc.images.size(); ++i) {
+        shared.skipImages[i] = (!keepImages && !needed[i]);
+    }
+
+    return shared;
 }
 
-std::vector<Texture::Options> loadSamplers(const json& data)
+// Creates the texture from encoded or mips if either has any data, the
+// image's container or pixels otherwise. With stream, textures with mip
+// levels are handed to the TextureStreamer.
+std::shared_ptr<Texture> createTexture(
+    const document_t& doc,
+    size_t index,
+    const ImageDecoder::Image& image,
+    const EncodedTexture& encoded,
+    const MipChain& mips,
+    const Texture::Options& opts,
+    bool stream)
 {
-    std::vector<Texture::Options> samplers;
+    const auto& desc = doc.textures[index];
+
+    LogVerbose("Texture %d, %d", desc.sampler, desc.source);
+
+    if (stream) {
+        TextureStreamer::Source source;
+        if (!encoded.Data.empty()) {
+            TextureStreamer::MakeSource(encoded, source);
+        } else if (image.Container) {
+            TextureStreamer::MakeSource(*image.Container, source);
+        } else if (!mips.Data.empty()) {
+            TextureStreamer::MakeSource(mips, source);
+        }
 
-    const auto it = data.find("samplers");
-    if (it != data.cend()) {
-        if (it.value().is_array()) {
-            const auto& array = it.value();
-            for (const auto& object : array) {
-                if (object.is_object()) {
-                    samplers.push_back(Texture::Options{});
-                    auto& sampler = samplers.back();
-                    
-                    sampler.MagFilter = object.value<GLenum>("magFilter", sampler.MagFilter);
-                    sampler.MinFilter = object.value<GLenum>("minFilter", sampler.MinFilter);
-                    sampler.WrapS = object.value<GLenum>("wrapS", sampler.WrapS);
-                    sampler.WrapT = object.value<GLenum>("wrapT", sampler.WrapT);
-                }
-            }
+        if (source.Levels.size() > 1) {
+            return TextureStreamer::Inst()->Add(std::move(source), opts);
         }
     }
 
-    return samplers;
+    if (!encoded.Data.empty()) {
+        return std::make_shared<Texture>(
+            encoded.Format,
+            encoded.Size,
+            encoded.Levels,
+            encoded.Data.data(),
+            opts
+        );
+    }
+
+    if (image.Container) {
+        return std::make_shared<Texture>(*image.Container, opts);
+    }
+
+    if (!mips.Data.empty()) {
+        return std::make_shared<Texture>(mips, opts);
+    }
+
+    if (!image.Data) {
+        return nullptr;
+    }
+
+    return std::make_shared<Texture>(
+        image.Data, 
+        image.Size,
+        image.Components,
+        opts
+    );
 }
 
-std::vector<Texture *> loadTextures(
-    const json& data, 
-    const std::vector<image_t>& images,
-    const std::vector<Texture::Options> samplers)
+// Bakes whichever form the texture was loaded in
+void bakeLoadedTexture(
+    size_t index,
+    const ImageDecoder::Image& image,
+    const EncodedTexture& encoded,
+    const MipChain& mips,
+    const Texture::Options& opts,
+    bakedAsset_t& baked)
 {
-    std::vector<Texture *> textures;
+    if (!encoded.Data.empty()) {
+        bakeEncodedTexture(index, opts, encoded, baked);
+    } else if (!mips.Data.empty()) {
+        bakeMipChain(index, opts, mips, baked);
+    } else if (image.Container) {
+        bakeContainerTexture(index, opts, *image.Container, baked);
+    } else if (image.Data) {
+        bakeTexture(index, opts, image, baked);
+    }
+}
 
-    const auto it = data.find("textures");
-    if (it != data.cend()) {
-        if (it.value().is_array()) {
-            const auto& array = it.value();
-            for (const auto& object : array) {
-                if (object.is_object()) {
-                    int sampler = object.value("sampler", -1);
-                    int source = object.value("source", -1);
+// Reuses the shared texture if there is one
+std::shared_ptr<Texture> loadTexture(
+    const document_t& doc,
+    size_t index,
+    const ImageDecoder::Image& image,
+    const EncodedTexture& encoded,
+    const MipChain& mips,
+    const Texture::Options& opts,
+    const sharedTextures_t& shared,
+    bakedAsset_t * baked,
+    bool stream)
+{
+    if (baked) {
+        bakeLoadedTexture(index, image, encoded, mips, opts, *baked);
+    }
 
-                    if (source < 0) {
-                        LogError("Invalid glTF texture source %d", source);
-                        continue;
-                    }
+    if (shared.textures[index]) {
+        return shared.textures[index];
+    }
+
+    auto texture = createTexture(doc, index, image, encoded, mips, opts, stream);
+    if (texture) {
+        texture = TextureCache::Inst()->Insert(shared.keys[index], texture);
+    }
+
+    return texture;
+}
+
+// Only plain RGBA pixels are packed, compressed textures and those found in
+// the TextureCache keep their own
+bool isPackable(
+    size_t index,
+    const ImageDecoder::Image& image,
+    const EncodedTexture& encoded,
+    const sharedTextures_t& shared)
+{
+    return (!shared.textures[index] && encoded.Data.empty() && !image.Container
+        && image.Data && image.Components == 4);
+}
 
-                    const auto& image = images[source];
-                    textures.push_back(new Texture(
-                        image.data.get(), 
-                        image.size,
-                        image.components,
-                        (sampler >= 0 ? samplers[sampler] : Texture::Options())
-                    ));
+// Fills in the textures given to the packer, packed holds each one's index
+// into maps or SIZE_MAX
+void setPackedTextures(
+    const std::vector<size_t>& packed,
+    const std::vector<TextureMap>& maps,
+    std::vector<TextureMap>& textures)
+{
+    for (size_t index = 0; index < packed.size(); ++index) {
+        if (packed[index] < maps.size()) {
+            textures[index] = maps[packed[index]];
+        }
+    }
+}
 
-                    LogVerbose("Texture %zu, %zu", sampler, source);
+// Returns the indices into the textures array that use each image
+std::vector<std::vector<size_t>> getImageUsers(const std::vector<texture_desc_t>& textures, size_t imageCount)
+{
+    std::vector<std::vector<size_t>> users(imageCount);
+
+    for (size_t i = 0; i < textures.size(); ++i) {
+        int source = textures[i].source;
+
+        if (source < 0 || source >= (int)imageCount) {
+            LogError("Invalid glTF texture source %d", source);
+            continue;
+        }
+
+        users[source].push_back(i);
+    }
+
+    return users;
+}
+
+// Textures are packed into arrays and atlas pages when packer is set, the
+// rest are streamed with stream
+std::vector<TextureMap> loadTextures(
+    const document_t& doc, 
+    ImageDecoder& images,
+    const std::vector<BlockFormat>& formats,
+    const std::vector<Texture::Options>& options,
+    const sharedTextures_t& shared,
+    bakedAsset_t * baked,
+    TexturePacker * packer,
+    bool stream)
+{
+    // Indices stay stable for materials, even on failure
+    std::vector<TextureMap> textures(doc.textures.size());
+    std::vector<size_t> packed(doc.textures.size(), SIZE_MAX);
+
+    // Go image by image so each one can be freed as soon as every texture
+    // using it has been uploaded
+    const auto& users = getImageUsers(doc.textures, images.GetCount());
+    for (size_t i = 0; i < users.size(); ++i) {
+        const auto& image = images.Wait(i);
+        for (size_t index : users[i]) {
+            EncodedTexture encoded;
+            if (!shared.textures[index] || baked) {
+                encoded = encodeTexture(image, formats[index], options[index]);
+            }
+
+            if (packer && isPackable(index, image, encoded, shared)) {
+                if (baked) {
+                    bakeLoadedTexture(index, image, encoded, MipChain(), options[index], *baked);
                 }
+                packed[index] = packer->Add(image.Data, image.Size, options[index]);
+                continue;
             }
+
+            MipChain mips;
+            if ((!shared.textures[index] || baked) && encoded.Data.empty()) {
+                mips = generateMipChain(image, options[index]);
+            }
+
+            textures[index] = loadTexture(doc, index, image, encoded, mips, options[index], shared, baked, stream);
         }
+        images.Release(i);
+    }
+
+    if (packer) {
+        setPackedTextures(packed, packer->Upload(), textures);
     }
 
     return textures;
@@ -372,309 +720,541 @@ std::vector<Texture *> loadTextures(
 //}
 
 std::vector<Material *> loadMaterials(
-    const json& data, 
-    const std::vector<Texture *>& textures)
+    const document_t& doc, 
+    const std::vector<TextureMap>& textures)
 {
     std::vector<Material *> materials;
 
-    auto parseTexture = [&textures](const json& value) -> Texture * {
-        if (value.is_object()) {
-            int index = value.value("index", -1);
-            int texCoord = value.value("texCoord", 0);
-
-            if (index < 0 || index >(int)textures.size()) {
-                LogError("Invalid glTF texture index %d", index);
-                return nullptr;
-            }
+    auto getTexture = [&textures](const textureRef_t& ref) -> TextureMap {
+        if (ref.index < 0) {
+            return TextureMap();
+        }
 
-            if (texCoord > 0) {
-                LogWarn("Multiple TEXCOORDs not supported");
-            }
+        if (ref.index >= (int)textures.size()) {
+            LogError("Invalid glTF texture index %d", ref.index);
+            return TextureMap();
+        }
 
-            return textures[index];
+        if (ref.texCoord > 0) {
+            LogWarn("Multiple TEXCOORDs not supported");
         }
-        return nullptr;
+
+        return textures[ref.index];
     };
 
-    const auto it = data.find("materials");
-    if (it != data.cend()) {
-        const auto& array = it.value();
-        for (const auto& object : array) {
-            if (object.is_object()) {
-                materials.push_back(new Material);
-                auto& material = materials.back();
-
-                LogVerbose("glTF material %s", object.value("name", ""));
-
-                auto valIt = object.find("normalTexture");
-                if (valIt != object.end()) {
-                    const auto& value = valIt.value();
-                    material->NormalMap = parseTexture(value);
-                    if (value.is_object()) {
-                        material->NormalScale = value.value("scale", 1.0f);
-                    }
-                }
+    for (const auto& desc : doc.materials) {
+        materials.push_back(new Material);
+        auto& material = materials.back();
 
-                valIt = object.find("emissiveFactor");
-                if (valIt != object.end()) {
-                    material->EmissiveFactor = parseVec3(valIt.value(), material->EmissiveFactor);
-                }
+        LogVerbose("glTF material %s", desc.name);
 
-                valIt = object.find("emissiveTexture");
-                if (valIt != object.end()) {
-                    material->EmissiveMap = parseTexture(valIt.value());
-                }
+        material->BaseColorFactor = desc.baseColorFactor;
+        material->BaseColorMap = getTexture(desc.baseColorTexture);
 
-                valIt = object.find("occlusionTexture");
-                if (valIt != object.end()) {
-                    const auto& value = valIt.value();
-                    material->OcclusionMap = parseTexture(value);
-                    if (value.is_object()) {
-                        material->OcclusionStrength = value.value("strength", 1.0f);
-                    }
-                }
+        material->MetallicFactor = desc.metallicFactor;
+        material->RoughnessFactor = desc.roughnessFactor;
+        material->MetallicRoughnessMap = getTexture(desc.metallicRoughnessTexture);
 
-                const auto groupIt = object.find("pbrMetallicRoughness");
-                if (groupIt != object.cend()) {
-                    const auto& group = groupIt.value();
-                    if (group.is_object()) {
-                        valIt = group.find("baseColorFactor");
-                        if (valIt != group.end()) {
-                            material->BaseColorFactor = parseVec4(valIt.value(), material->BaseColorFactor);
-                        }
-
-                        valIt = group.find("baseColorTexture");
-                        if (valIt != group.end()) {
-                            material->BaseColorMap = parseTexture(valIt.value());
-                        }
-
-                        valIt = group.find("metallicFactor");
-                        if (valIt != group.end()) {
-                            material->MetallicFactor = valIt.value().get<float>();
-                        }
-
-                        valIt = group.find("roughnessFactor");
-                        if (valIt != group.end()) {
-                            material->RoughnessFactor = valIt.value().get<float>();
-                        }
-
-                        valIt = group.find("metallicRoughnessTexture");
-                        if (valIt != group.end()) {
-                            const auto& value = valIt.value();
-                            material->MetallicRoughnessMap = parseTexture(value);
-                        }
-                    }
-                }
+        material->NormalMap = getTexture(desc.normalTexture);
+        material->NormalScale = desc.normalTexture.scale;
+
+        material->OcclusionMap = getTexture(desc.occlusionTexture);
+        material->OcclusionStrength = desc.occlusionTexture.scale;
+
+        material->EmissiveMap = getTexture(desc.emissiveTexture);
+        material->EmissiveFactor = desc.emissiveFactor;
+    }
+
+    return materials;
+}
+
+// Uploads each bufferView once, no matter how many accessors or primitives
+// reference it. glBuffers holds one entry per bufferView for the document.
+GLuint getBufferViewBuffer(
+    int bufferViewIndex,
+    const std::vector<bufferView_t>& bufferViews, 
+    const std::vector<buffer_t>& buffers,
+    std::vector<GLuint>& glBuffers)
+{
+    if (bufferViewIndex < 0 || bufferViewIndex >= (int)bufferViews.size()) {
+        LogError("Invalid glTF bufferView %d", bufferViewIndex);
+        return 0;
+    }
+
+    GLuint& vbo = glBuffers[bufferViewIndex];
+    if (vbo == 0) {
+        const auto& bufferView = bufferViews[bufferViewIndex];
+        const uint8_t * data = getBufferViewData(bufferView, buffers);
+        if (!data) {
+            return 0;
+        }
+
+        glGenBuffers(1, &vbo);
+
+        // Allocate through a neutral target so the bound VAO is left untouched
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+        glBufferData(GL_COPY_WRITE_BUFFER, bufferView.byteLength, nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        StagingBuffer::Inst()->Upload(vbo, 0, data, bufferView.byteLength);
+
+        LogVerbose("glTF bufferView %d uploaded to %u", bufferViewIndex, vbo);
+    }
+
+    return vbo;
+}
+
+int getComponentCount(const std::string& type)
+{
+    if (type == "SCALAR") {
+        return 1;
+    } else if (type == "VEC2") {
+        return 2;
+    } else if (type == "VEC3") {
+        return 3;
+    } else if (type == "VEC4") {
+        return 4;
+    }
+    return -1;
+}
+
+size_t getComponentSize(GLenum componentType)
+{
+    switch (componentType) 
+    {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+        return 1;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+        return 2;
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+        return 4;
+    }
+    return 0;
+}
+
+// Returns the address of every element of an accessor through fn, or false
+// if the accessor does not fit inside its buffer
+template <class Fn>
+bool forEachElement(
+    const accessor_t& accessor,
+    const std::vector<bufferView_t>& bufferViews, 
+    const std::vector<buffer_t>& buffers,
+    Fn&& fn)
+{
+    if (accessor.bufferView < 0 || accessor.bufferView >= (int)bufferViews.size()) {
+        LogError("Invalid glTF accessor bufferView %d", accessor.bufferView);
+        return false;
+    }
+
+    const auto& bufferView = bufferViews[accessor.bufferView];
+    const uint8_t * data = getBufferViewData(bufferView, buffers);
+    if (!data) {
+        return false;
+    }
+
+    size_t elementSize = getComponentSize(accessor.componentType) * getComponentCount(accessor.type);
+    size_t stride = (bufferView.byteStride > 0 ? bufferView.byteStride : elementSize);
+
+    size_t start = accessor.byteOffset;
+    size_t end = start + (accessor.count > 0 ? (accessor.count - 1) * stride + elementSize : 0);
+    if (elementSize == 0 || end > bufferView.byteLength) {
+        LogError("glTF accessor out of bounds");
+        return false;
+    }
+
+    for (size_t i = 0; i < accessor.count; ++i) {
+        fn(i, data + start + i * stride);
+    }
+
+    return true;
+}
+
+// Reads up to components values of each element as floats into out, one
+// element every outStride floats. Normalized integers are mapped to [0,1]/[-1,1].
+bool readAccessor(
+    const accessor_t& accessor,
+    const std::vector<bufferView_t>& bufferViews, 
+    const std::vector<buffer_t>& buffers,
+    int components,
+    float * out,
+    size_t outStride)
+{
+    int count = std::min(components, getComponentCount(accessor.type));
+    GLenum type = accessor.componentType;
+    bool normalized = accessor.normalized;
+
+    return forEachElement(accessor, bufferViews, buffers, [=](size_t i, const uint8_t * src) {
+        float * dst = out + i * outStride;
+        for (int c = 0; c < count; ++c) {
+            switch (type)
+            {
+            case GL_FLOAT: {
+                memcpy(&dst[c], src + c * 4, 4);
+            } break;
+            case GL_UNSIGNED_BYTE: {
+                float v = src[c];
+                dst[c] = (normalized ? v / 255.f : v);
+            } break;
+            case GL_BYTE: {
+                float v = (int8_t)src[c];
+                dst[c] = (normalized ? std::max(v / 127.f, -1.f) : v);
+            } break;
+            case GL_UNSIGNED_SHORT: {
+                uint16_t v;
+                memcpy(&v, src + c * 2, 2);
+                dst[c] = (normalized ? v / 65535.f : v);
+            } break;
+            case GL_SHORT: {
+                int16_t v;
+                memcpy(&v, src + c * 2, 2);
+                dst[c] = (normalized ? std::max(v / 32767.f, -1.f) : v);
+            } break;
+            case GL_UNSIGNED_INT: {
+                uint32_t v;
+                memcpy(&v, src + c * 4, 4);
+                dst[c] = (float)v;
+            } break;
             }
         }
+    });
+}
+
+bool readIndices(
+    const accessor_t& accessor,
+    const std::vector<bufferView_t>& bufferViews, 
+    const std::vector<buffer_t>& buffers,
+    uint32_t * out)
+{
+    GLenum type = accessor.componentType;
+    if (type != GL_UNSIGNED_BYTE && type != GL_UNSIGNED_SHORT && type != GL_UNSIGNED_INT) {
+        LogError("Invalid glTF index type %04x", type);
+        return false;
     }
 
-    return materials;
+    return forEachElement(accessor, bufferViews, buffers, [=](size_t i, const uint8_t * src) {
+        if (type == GL_UNSIGNED_BYTE) {
+            out[i] = *src;
+        } else if (type == GL_UNSIGNED_SHORT) {
+            uint16_t v;
+            memcpy(&v, src, 2);
+            out[i] = v;
+        } else {
+            memcpy(&out[i], src, 4);
+        }
+    });
 }
 
-std::vector<Mesh::Primitive> loadPrimitives(
-    const json& data,
+// Converts the primitive to the GeometryArena vertex layout
+bool buildArenaPrimitive(
+    const primitive_t& primitive,
+    const accessor_t& indexAccessor,
     const std::vector<bufferView_t>& bufferViews, 
-    const std::vector<std::vector<uint8_t>>& buffers,
+    const std::vector<buffer_t>& buffers,
     const std::vector<accessor_t>& accessors,
-    const std::vector<Material *>& materials)
+    std::vector<GeometryArena::Vertex>& vertices,
+    std::vector<uint32_t>& indices)
 {
-    std::vector<Mesh::Primitive> primitives;
+    typedef GeometryArena::Vertex Vertex;
 
-    Material * defaultMaterial(new Material());
-    
-	std::vector<GLuint> vbos;
-
-    const auto& primIt = data.find("primitives");
-    if (primIt != data.end()) {
-        const auto& primArray = primIt.value();
-        if (primArray.is_array()) {
-            for (const auto& primitive : primArray) {
-                if (primitive.is_object()) {
-                    GLuint vao;
-                    glGenVertexArrays(1, &vao);
-                    glBindVertexArray(vao);
-
-                    int indices = primitive.value("indices", -1);
-                    if (indices < 0) {
-                        // TODO: glDrawArrays support
-                        LogError("glDrawArrays not supported");
-                        continue;
-                    }
+    int positionIndex = -1;
+    for (const auto& [attrib, index] : primitive.attributes) {
+        if (attrib == "POSITION") {
+            positionIndex = index;
+        }
+    }
 
-                    const auto& indexAccessor = accessors[indices];
+    if (positionIndex < 0 || positionIndex >= (int)accessors.size()) {
+        LogError("glTF primitive has no POSITION attribute");
+        return false;
+    }
 
-                    {
-                        const auto& bufferView = bufferViews[indexAccessor.bufferView];
-                        const auto& buffer = buffers[bufferView.buffer];
+    Vertex defaultVertex;
+    defaultVertex.Position = glm::vec3(0.f);
+    defaultVertex.Normal = glm::vec3(0.f, 0.f, 1.f);
+    defaultVertex.UV = glm::vec2(0.f);
+    defaultVertex.Tangent = glm::vec4(1.f, 0.f, 0.f, 1.f);
 
-                        GLenum target = (bufferView.target == GL_INVALID_ENUM ? GL_ELEMENT_ARRAY_BUFFER : bufferView.target);
+    vertices.assign(accessors[positionIndex].count, defaultVertex);
 
-                        GLuint vbo;
-                        glGenBuffers(1, &vbo);
-                        vbos.push_back(vbo);
+    const size_t stride = sizeof(Vertex) / sizeof(float);
+    float * base = reinterpret_cast<float *>(vertices.data());
 
-                        glBindBuffer(target, vbo);
-                        glBufferData(target, bufferView.byteLength,
-                            buffer.data() + bufferView.byteOffset, GL_STATIC_DRAW);
-                    }
+    for (const auto& [attrib, index] : primitive.attributes) {
+        if (index < 0 || index >= (int)accessors.size()) {
+            LogError("Invalid glTF accessor %d", index);
+            return false;
+        }
 
-                    const auto& attrIt = primitive.find("attributes");
-                    if (attrIt != primitive.end()) {
-                        const auto& attribs = attrIt.value();
-                        if (attribs.is_object()) {
-                            for (const auto& [attrib, accessorIndex] : attribs.items()) {
-                                auto& accessor = accessors[accessorIndex];
-                                auto& bufferView = bufferViews[accessor.bufferView];
-                                auto& buffer = buffers[bufferView.buffer];
-                                int byteStride = bufferView.byteStride;
-
-                                LogVerbose("glTF attribute %s", attrib);
-
-                                GLenum target = (bufferView.target == GL_INVALID_ENUM ? GL_ARRAY_BUFFER : bufferView.target);
-
-                                GLuint vbo;
-                                glGenBuffers(1, &vbo);
-                                vbos.push_back(vbo);
-
-                                glBindBuffer(target, vbo);
-                                glBufferData(target, bufferView.byteLength,
-                                    buffer.data() + bufferView.byteOffset, GL_STATIC_DRAW);
-
-                                GLint size = -1;
-                                if (accessor.type == "SCALAR") {
-                                    size = 1;
-                                } else if (accessor.type == "VEC2") {
-                                    size = 2;
-                                } else if (accessor.type == "VEC3") {
-                                    size = 3;
-                                } else if (accessor.type == "VEC4") {
-                                    size = 4;
-                                }
-
-                                GLint vaa = -1;
-                                if (attrib == "POSITION") {
-                                    vaa = Mesh::AttributeID::POSITION;
-                                } else if (attrib == "NORMAL") {
-                                    vaa = Mesh::AttributeID::NORMAL;
-                                } else if (attrib == "TEXCOORD_0") {
-                                    vaa = Mesh::AttributeID::UV;
-                                } else if (attrib == "TANGENT") {
-                                    vaa = Mesh::AttributeID::TANGENT;
-                                }
-
-                                if (vaa > -1) {
-                                    glEnableVertexAttribArray(vaa);
-                                    glVertexAttribPointer(
-                                        vaa, 
-                                        size,
-                                        accessor.componentType, 
-                                        accessor.normalized, 
-                                        byteStride,
-                                        (void*)accessor.byteOffset
-                                    );
-                                } else {
-                                    LogWarn("Ignoring glTF attribute %s", attrib);
-                                }
-                            }
-                        }
-                    }
+        const auto& accessor = accessors[index];
+        if (accessor.count != vertices.size()) {
+            LogError("glTF attribute %s has %zu elements, expected %zu", attrib, accessor.count, vertices.size());
+            return false;
+        }
 
-                    int materialIndex = primitive.value("material", -1);
+        bool ok = true;
+        if (attrib == "POSITION") {
+            ok = readAccessor(accessor, bufferViews, buffers, 3, base + offsetof(Vertex, Position) / sizeof(float), stride);
+        } else if (attrib == "NORMAL") {
+            ok = readAccessor(accessor, bufferViews, buffers, 3, base + offsetof(Vertex, Normal) / sizeof(float), stride);
+        } else if (attrib == "TEXCOORD_0") {
+            ok = readAccessor(accessor, bufferViews, buffers, 2, base + offsetof(Vertex, UV) / sizeof(float), stride);
+        } else if (attrib == "TANGENT") {
+            ok = readAccessor(accessor, bufferViews, buffers, 4, base + offsetof(Vertex, Tangent) / sizeof(float), stride);
+        } else {
+            LogWarn("Ignoring glTF attribute %s", attrib);
+        }
 
-                    Material * material;
-                    if (materialIndex >= 0) {
-                        material = materials[materialIndex];
-                    } else {
-                        material = defaultMaterial;
-                    }
+        if (!ok) {
+            return false;
+        }
+    }
 
-                    LogVerbose("Primitive %u", vao);
-
-                    primitives.push_back({
-                        vao,
-                        primitive.value<GLenum>("mode", GL_TRIANGLES),
-                        (GLsizei)indexAccessor.count,
-                        (GLenum)indexAccessor.componentType,
-                        (GLsizei)indexAccessor.byteOffset,
-                        Box(),
-                        material,
-                        nullptr,
-                    });
-                }
+    indices.resize(indexAccessor.count);
+    if (!readIndices(indexAccessor, bufferViews, buffers, indices.data())) {
+        return false;
+    }
+
+    return true;
+}
+
+// Uploads converted vertices and indices into a shared GeometryArena page
+bool uploadArenaPrimitive(
+    const std::vector<GeometryArena::Vertex>& vertices,
+    const std::vector<uint32_t>& indices,
+    Mesh::Primitive& out)
+{
+    auto arena = GeometryArena::Inst();
+    auto alloc = arena->Allocate((uint32_t)vertices.size(), (uint32_t)indices.size());
+    if (alloc.Page < 0) {
+        LogError("Empty glTF primitive");
+        return false;
+    }
+
+    arena->Upload(alloc, vertices.data(), indices.data());
+
+    out.VAO = arena->GetVAO(alloc.Page);
+    out.Count = (GLsizei)alloc.IndexCount;
+    out.Type = GL_UNSIGNED_INT;
+    out.Offset = (GLsizei)(alloc.IndexOffset * sizeof(uint32_t));
+    out.BaseVertex = (GLint)alloc.VertexOffset;
+    out.Allocation = alloc;
+
+    return true;
+}
+
+// Gives the primitive its own VAO over the shared bufferView buffers
+bool loadBufferPrimitive(
+    const primitive_t& primitive,
+    const accessor_t& indexAccessor,
+    const std::vector<bufferView_t>& bufferViews, 
+    const std::vector<buffer_t>& buffers,
+    const std::vector<accessor_t>& accessors,
+    const std::shared_ptr<Mesh::BufferSet>& glBuffers,
+    Mesh::Primitive& out)
+{
+    GLuint ibo = getBufferViewBuffer(indexAccessor.bufferView, bufferViews, buffers, glBuffers->Names);
+    if (ibo == 0) {
+        LogError("glTF primitive has no index data");
+        return false;
+    }
+
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+
+    for (const auto& [attrib, accessorIndex] : primitive.attributes) {
+        if (accessorIndex < 0 || accessorIndex >= (int)accessors.size()) {
+            LogError("Invalid glTF accessor %d", accessorIndex);
+            continue;
+        }
+
+        auto& accessor = accessors[accessorIndex];
+
+        // Interleaved attributes share one buffer and differ by offset
+        GLuint vbo = getBufferViewBuffer(accessor.bufferView, bufferViews, buffers, glBuffers->Names);
+        if (vbo == 0) {
+            LogError("glTF attribute %s has no data", attrib);
+            continue;
+        }
+
+        auto& bufferView = bufferViews[accessor.bufferView];
+        int byteStride = bufferView.byteStride;
+
+        LogVerbose("glTF attribute %s", attrib);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+        GLint size = getComponentCount(accessor.type);
+
+        GLint vaa = -1;
+        if (attrib == "POSITION") {
+            vaa = Mesh::AttributeID::POSITION;
+        } else if (attrib == "NORMAL") {
+            vaa = Mesh::AttributeID::NORMAL;
+        } else if (attrib == "TEXCOORD_0") {
+            vaa = Mesh::AttributeID::UV;
+        } else if (attrib == "TANGENT") {
+            vaa = Mesh::AttributeID::TANGENT;
+        }
+
+        if (vaa > -1) {
+            glEnableVertexAttribArray(vaa);
+            glVertexAttribPointer(
+                vaa, 
+                size,
+                accessor.componentType, 
+                accessor.normalized, 
+                byteStride,
+                (void*)accessor.byteOffset
+            );
+        } else {
+            LogWarn("Ignoring glTF attribute %s", attrib);
+        }
+    }
+
+    glBindVertexArray(0);
+
+    out.VAO = vao;
+    out.Count = (GLsizei)indexAccessor.count;
+    out.Type = (GLenum)indexAccessor.componentType;
+    out.Offset = (GLsizei)indexAccessor.byteOffset;
+    out.BaseVertex = 0;
+    out.Buffers = glBuffers;
+
+    return true;
+}
+
+std::vector<Mesh::Primitive> loadPrimitives(
+    const document_t& doc,
+    size_t meshIndex,
+    const std::vector<buffer_t>& buffers,
+    const std::vector<Material *>& materials,
+    const std::shared_ptr<Mesh::BufferSet>& glBuffers,
+    const Options& opts,
+    bakedAsset_t * baked)
+{
+    std::vector<Mesh::Primitive> primitives;
+
+    Material * defaultMaterial(new Material());
+
+    // Reused between primitives to avoid reallocating
+    std::vector<GeometryArena::Vertex> vertices;
+    std::vector<uint32_t> indices;
+
+    const auto& mesh = doc.meshes[meshIndex];
+    for (const auto& primitive : mesh.primitives) {
+        int indexAccessorIndex = primitive.indices;
+        if (indexAccessorIndex < 0) {
+            // TODO: glDrawArrays support
+            LogError("glDrawArrays not supported");
+            continue;
+        }
+
+        if (indexAccessorIndex >= (int)doc.accessors.size()) {
+            LogError("Invalid glTF accessor %d", indexAccessorIndex);
+            continue;
+        }
+
+        const auto& indexAccessor = doc.accessors[indexAccessorIndex];
+
+        Mesh::Primitive prim;
+        if (opts.UseGeometryArena) {
+            if (!buildArenaPrimitive(primitive, indexAccessor, doc.bufferViews, buffers, doc.accessors, vertices, indices) ||
+                !uploadArenaPrimitive(vertices, indices, prim)) {
+                continue;
+            }
+
+            if (baked) {
+                bakePrimitive(meshIndex, primitive, vertices, indices, *baked);
             }
+        } else {
+            if (!loadBufferPrimitive(primitive, indexAccessor, doc.bufferViews, buffers, doc.accessors, glBuffers, prim)) {
+                continue;
+            }
+        }
+
+        int materialIndex = primitive.material;
+
+        Material * material;
+        if (materialIndex >= 0 && materialIndex < (int)materials.size()) {
+            material = materials[materialIndex];
+        } else {
+            material = defaultMaterial;
         }
+
+        prim.Mode = primitive.mode;
+        prim.Mat = material;
+
+        LogVerbose("Primitive %u, %d", prim.VAO, prim.BaseVertex);
+
+        primitives.push_back(prim);
     }
 
     return primitives;
 }
 
 std::vector<Mesh::Primitive> loadAllPrimitives(
-	const json& data,
-	const std::vector<bufferView_t>& bufferViews,
-	const std::vector<std::vector<uint8_t>>& buffers,
-	const std::vector<accessor_t>& accessors,
-	const std::vector<Material *>& materials)
+    const document_t& doc,
+    const std::vector<buffer_t>& buffers,
+    const std::vector<Material *>& materials,
+    const Options& opts,
+    bakedAsset_t * baked)
 {
-	std::vector<Mesh::Primitive> primitives;
+    std::vector<Mesh::Primitive> primitives;
 
-	const auto it = data.find("meshes");
-	if (it != data.cend()) {
-		const auto& array = it.value();
-		for (const auto& object : array) {
-			if (object.is_object()) {
-				LogVerbose("glTF mesh %s", object.value("name", ""));
-
-				auto tmp = loadPrimitives(object, bufferViews, buffers, accessors, materials);
-				for (auto&& p : tmp) {
-					primitives.push_back(std::move(p));
-				}
-			}
-		}
-	}
+    auto glBuffers = std::make_shared<Mesh::BufferSet>();
+    glBuffers->Names.resize(doc.bufferViews.size(), 0);
 
-	return primitives;
+    for (size_t i = 0; i < doc.meshes.size(); ++i) {
+        LogVerbose("glTF mesh %s", doc.meshes[i].name);
+
+        auto tmp = loadPrimitives(doc, i, buffers, materials, glBuffers, opts, baked);
+        for (auto&& p : tmp) {
+            primitives.push_back(std::move(p));
+        }
+    }
+
+    return primitives;
 }
 
 std::vector<Mesh *> loadMeshes(
-    const json& data,
-    const std::vector<bufferView_t>& bufferViews, 
-    const std::vector<std::vector<uint8_t>>& buffers,
-    const std::vector<accessor_t>& accessors,
-    const std::vector<Material *>& materials)
+    const document_t& doc,
+    const std::vector<buffer_t>& buffers,
+    const std::vector<Material *>& materials,
+    const Options& opts)
 {
     std::vector<Mesh *> meshes;
 
-    const auto it = data.find("meshes");
-    if (it != data.cend()) {
-        const auto& array = it.value();
-        for (const auto& object : array) {
-            if (object.is_object()) {
-                LogVerbose("glTF mesh %s", object.value("name", ""));
+    auto glBuffers = std::make_shared<Mesh::BufferSet>();
+    glBuffers->Names.resize(doc.bufferViews.size(), 0);
 
-                meshes.push_back(std::make_shared<Mesh>(
-                    loadPrimitives(object, bufferViews, buffers, accessors, materials)
-                ));
-            }
-        }
+    for (size_t i = 0; i < doc.meshes.size(); ++i) {
+        LogVerbose("glTF mesh %s", doc.meshes[i].name);
+
+        meshes.push_back(std::make_shared<Mesh>(
+            loadPrimitives(doc, i, buffers, materials, glBuffers, opts, nullptr)
+        ));
     }
 
     return meshes;
 }
 
 std::vector<Actor *> loadNodes(
-    const json& data,
+    const document_t& doc,
     const std::vector<camera_t>& cameras,
     const std::vector<Mesh *>& meshes)
 {
     std::vector<Actor *> actors;
 
-    auto loadNode = [cameras,meshes](const json& data) -> Actor * {
+    auto loadNode = [cameras,meshes](const node_t& node) -> Actor * {
         Actor * actor = nullptr;
 
-        auto it = data.begin();
-
-        //int cameraIndex = data.value("camera", -1);
+        //int cameraIndex = node.camera;
         //if (cameraIndex >= 0) {
         //    Camera * camera = new Camera();
         //    const auto& c = cameras[cameraIndex];
@@ -706,56 +1286,32 @@ std::vector<Actor *> loadNodes(
             actor = new Actor();
         //}
 
-        int meshIndex = data.value("mesh", -1);
+        int meshIndex = node.mesh;
         if (meshIndex >= 0) {
             LogVerbose("Adding MeshComponent");
             actor->AddComponent(std::make_unique<MeshComponent>(meshes[meshIndex]));
         }
 
-        it = data.find("translation");
-        if (it != data.end()) {
-            actor->SetPosition(parseVec3(it.value(), actor->GetPosition()));
-        }
-
-        it = data.find("rotation");
-        if (it != data.end()) {
-            actor->SetRotation(parseQuat(it.value(), actor->GetRotation()));
-        }
-
-        it = data.find("scale");
-        if (it != data.end()) {
-            actor->SetScale(parseVec3(it.value(), actor->GetScale()));
-        }
+        actor->SetPosition(node.translation);
+        actor->SetRotation(node.rotation);
+        actor->SetScale(node.scale);
 
         return Actor *(actor);
     };
 
-    std::vector<int> sceneNodeIndexes;
-    
-    int defaultSceneIndex = data.value("defaultScene", 0);
-    const auto scenesIt = data.find("scenes");
-    if (scenesIt != data.cend()) {
-        const auto& array = scenesIt.value();
-        if (array.is_array()) {
-            const auto& scene = array[defaultSceneIndex];
-            sceneNodeIndexes = scene["nodes"].get<std::vector<int>>();
-        }
-    }
-    
-    const auto nodesIt = data.find("nodes");
-    if (nodesIt != data.cend()) {
-        const auto& array = nodesIt.value();
-        if (array.is_array()) {
-            for (int index : sceneNodeIndexes) {
-                const auto& object = array[index];
-
-                if (object.is_object()) {
-                    LogVerbose("glTF node %s", object.value("name", ""));
-                    auto actor = loadNode(object);
-                    if (actor) {
-                        actors.push_back(std::move(actor));
-                    }
-                }
+    if (doc.scene >= 0 && doc.scene < (int)doc.scenes.size()) {
+        for (int index : doc.scenes[doc.scene].nodes) {
+            if (index < 0 || index >= (int)doc.nodes.size()) {
+                LogError("Invalid glTF node %d", index);
+                continue;
+            }
+
+            const auto& node = doc.nodes[index];
+
+            LogVerbose("glTF node %s", node.name);
+            auto actor = loadNode(node);
+            if (actor) {
+                actors.push_back(std::move(actor));
             }
         }
     }
@@ -763,151 +1319,468 @@ std::vector<Actor *> loadNodes(
     return actors;
 }
 
-std::tuple<json, std::vector<std::vector<uint8_t>>, std::string> 
-loadFile(const std::string& filename) 
+bool parseDocument(const char * begin, const char * end, const Options& opts, document_t& doc)
+{
+    if (opts.StreamingParse) {
+        return parseDocumentSAX(begin, end, doc);
+    }
+    return parseDocumentDOM(begin, end, doc);
+}
+
+// Looks for filename in each asset path and reads the first match
+bool openFile(const std::string& filename, storage_t& storage, const Options& opts, buffer_t& file, std::string& fullPath)
 {
-    static auto error = std::make_tuple(json(), std::vector<std::vector<uint8_t>>(), "");
 	const auto& paths = GetAssetPaths();
 
-	std::ifstream file;
-	std::string fullPath;
+	file = { nullptr, 0 };
 	for (auto& p : paths) {
 		fullPath = p + filename;
 
 		LogVerbose("Checking %s", fullPath);
 
-		file.open(fullPath.c_str(), std::ios::in | std::ios::binary);
-		if (file.is_open()) {
-			break;
+		if (readFile(fullPath, storage, opts, file)) {
+			return true;
 		}
 	}
 
-	if (!file.is_open()) {
-		LogError("Failed to load glTF, '%s'", filename);
-        return error;
-	}
+	LogError("Failed to load glTF, '%s'", filename);
+	return false;
+}
 
-	const auto& dir = GetDirname(fullPath);
+bool parseFile(
+	const std::string& filename, 
+	const buffer_t& file, 
+	const Options& opts, 
+	document_t& doc, 
+	std::vector<buffer_t>& binChunks) 
+{
 	const auto& ext = GetExtension(filename);
 	bool binary = (ext == "glb");
 
-	std::vector<std::vector<uint8_t>> dataChunks;
-
-	json data;
+	bool parsed = false;
 	if (binary) {
-		uint32_t magic = 0;
-		uint32_t version = 0;
-		uint32_t length = 0;
+		const size_t HeaderLength = 12;
+		const size_t ChunkHeaderLength = 8;
 
 		// TODO: Endianness
+		auto readUint32 = [&file](size_t offset) {
+			uint32_t value;
+			memcpy(&value, file.data + offset, sizeof(value));
+			return value;
+		};
 
-		file.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+		if (file.size < HeaderLength + ChunkHeaderLength) {
+			LogError("Invalid binary glTF file");
+			return false;
+		}
+
+		uint32_t magic = readUint32(0);
 		if (magic != Magic) {
 			LogError("Invalid binary glTF file");
-            return error;
+            return false;
 		}
 
-		file.read(reinterpret_cast<char *>(&version), sizeof(version));
+		uint32_t version = readUint32(4);
 		if (version != 2) {
 			LogError("Invalid binary glTF container version %d", version);
-            return error;
+            return false;
 		}
 
-		file.read(reinterpret_cast<char *>(&length), sizeof(length));
-
-		uint32_t jsonChunkLength = 0;
-		uint32_t jsonChunkType = 0;
+		size_t length = readUint32(8);
+		if (length > file.size) {
+			LogError("Truncated binary glTF file, %zu < %zu", file.size, length);
+			return false;
+		}
 
-		file.read(reinterpret_cast<char *>(&jsonChunkLength), sizeof(jsonChunkLength));
-		file.read(reinterpret_cast<char *>(&jsonChunkType), sizeof(jsonChunkType));
+		uint32_t jsonChunkLength = readUint32(HeaderLength);
+		uint32_t jsonChunkType = readUint32(HeaderLength + 4);
 
 		if ((ChunkType)jsonChunkType != ChunkType::JSON) {
 			LogError("The first chunk of a binary glTF must be JSON, found %08x", jsonChunkType);
-            return error;
+            return false;
 		}
 
-		std::vector<char> jsonChunk(jsonChunkLength + 1);
-		file.read(jsonChunk.data(), jsonChunkLength);
-		jsonChunk.back() = '\0';
-		
-		data = json::parse(jsonChunk.data());
+		size_t offset = HeaderLength + ChunkHeaderLength;
+		if (offset + jsonChunkLength > length) {
+			LogError("Truncated binary glTF JSON chunk");
+			return false;
+		}
+
+		const char * jsonChunk = reinterpret_cast<const char *>(file.data + offset);
+		parsed = parseDocument(jsonChunk, jsonChunk + jsonChunkLength, opts, doc);
+		offset += jsonChunkLength;
 
-		uint32_t dataChunkLength = 0;
-		uint32_t dataChunkType = 0;
-		while (file.read(reinterpret_cast<char *>(&dataChunkLength), sizeof(dataChunkLength))) {
-			file.read(reinterpret_cast<char *>(&dataChunkType), sizeof(dataChunkType));
+		while (offset + ChunkHeaderLength <= length) {
+			uint32_t dataChunkLength = readUint32(offset);
+			uint32_t dataChunkType = readUint32(offset + 4);
+			offset += ChunkHeaderLength;
 
 			if ((ChunkType)dataChunkType != ChunkType::BIN) {
 				LogError("The second chunk of a binary glTF must be BIN, found %08x", dataChunkType);
-                return error;
+                return false;
 			}
 
-			dataChunks.push_back(std::vector<uint8_t>(dataChunkLength));
-			auto& dataChunk = dataChunks.back();
+			if (offset + dataChunkLength > length) {
+				LogError("Truncated binary glTF BIN chunk");
+				return false;
+			}
 
-			file.read(reinterpret_cast<char *>(dataChunk.data()), dataChunkLength);
+			binChunks.push_back(buffer_t{ file.data + offset, dataChunkLength });
+			offset += dataChunkLength;
 		}
 
 	} else {
-		file >> data;
+		const char * text = reinterpret_cast<const char *>(file.data);
+		parsed = parseDocument(text, text + file.size, opts, doc);
 	}
 
-	if (auto it = data.find("asset"); it != data.end()) {
-		const auto& object = it.value();
-		if (object.is_object()) {
+	if (!parsed) {
+		LogError("Failed to parse glTF JSON in '%s'", filename);
+		return false;
+	}
 
-			const auto& version = object.value("version", "");
+	if (doc.version.empty()) {
+		LogError("glTF missing required asset entry");
+		return false;
+	}
 
-			LogVerbose("glTF Generator %s", object.value("generator", ""));
-			LogVerbose("glTF Version %s", object.value("version", ""));
+	LogVerbose("glTF Generator %s", doc.generator);
+	LogVerbose("glTF Version %s", doc.version);
 
-			if (version != "2.0") {
-				LogError("only glTF 2.0 is supported");
-                return error;
-			}
-		}
-		else {
-			LogError("glTF missing required asset entry");
-            return error;
-		}
+	if (doc.version != "2.0") {
+		LogError("only glTF 2.0 is supported");
+		return false;
 	}
 
-	if (auto it = data.find("extensionsRequired"); it != data.end()) {
-		const auto& array = it.value();
-		if (array.is_array()) {
-			for (const auto& ext : array) {
-				LogError("Missing glTF required extension '%s'", ext);
-			}
+	for (const auto& ext : doc.extensionsRequired) {
+		LogError("Missing glTF required extension '%s'", ext);
+	}
+
+	for (const auto& ext : doc.extensionsUsed) {
+		LogWarn("Missing glTF extension '%s'", ext);
+	}
+
+	return true;
+}
+
+// Creates everything straight from a validated cache, no parsing or decoding
+std::vector<Mesh::Primitive> loadCachedPrimitives(const cacheView_t& cache)
+{
+	std::vector<std::shared_ptr<Texture>> textures;
+	for (size_t i = 0; i < cache.textureCount; ++i) {
+		textures.push_back(loadCachedTexture(cache, i));
+	}
+
+	const auto& materials = loadCachedMaterials(cache, textures);
+
+	Material * defaultMaterial(new Material());
+
+	std::vector<Mesh::Primitive> primitives;
+	for (size_t i = 0; i < cache.primitiveCount; ++i) {
+		primitives.push_back(loadCachedPrimitive(cache, i, materials, defaultMaterial));
+	}
+
+	return primitives;
+}
+
+// The cache holds the GeometryArena vertex layout and plain 2D textures, so
+// it can't stand in for loads that put textures in arrays or the streamer
+bool canUseCache(const Options& opts)
+{
+    return (!opts.CacheDir.empty() && opts.UseGeometryArena && !opts.PackTextures && !opts.StreamTextures);
+}
+
+// Options that change what gets baked are part of the hash, so compressed and
+// uncompressed loads or ones filtering mips differently each get their own
+// cache
+uint64_t getSourceHash(const buffer_t& file, const Options& opts)
+{
+    uint64_t seed = (opts.CompressTextures ? 1 : 0)
+        | (opts.CPUMipmaps ? 2 : 0)
+        | ((uint64_t)opts.MipmapFilter << 2);
+    return Hash64(file.data, file.size, seed);
+}
+
+std::vector<Mesh::Primitive> LoadPrimitivesFromFile(const std::string& filename, Options opts /*= Options()*/)
+{
+	storage_t storage;
+
+	buffer_t file;
+	std::string fullPath;
+	if (!openFile(filename, storage, opts, file, fullPath)) {
+		return {};
+	}
+
+	const auto& dir = GetDirname(fullPath);
+
+	bool useCache = canUseCache(opts);
+
+	uint64_t sourceHash = 0;
+	if (useCache) {
+		sourceHash = getSourceHash(file, opts);
+
+		cacheView_t cache;
+		if (openCache(getCachePath(opts.CacheDir, sourceHash), sourceHash, dir, cache)) {
+			LogLoad("glTF '%s' loaded from cache", filename);
+			return loadCachedPrimitives(cache);
 		}
 	}
 
-	if (auto it = data.find("extensionsUsed"); it != data.end()) {
-		const auto& array = it.value();
-		if (array.is_array()) {
-			for (const auto& ext : array) {
-				LogWarn("Missing glTF extension '%s'", ext);
-			}
+	document_t doc;
+	std::vector<buffer_t> binChunks;
+	if (!parseFile(filename, file, opts, doc, binChunks)) {
+		return {};
+	}
+
+	std::unique_ptr<bakedAsset_t> baked;
+	if (useCache) {
+		baked = std::make_unique<bakedAsset_t>();
+		if (!bakeDocument(doc, dir, *baked)) {
+			baked.reset();
 		}
 	}
+	
+	const auto& buffers = loadBuffers(doc, dir, binChunks, storage, opts);
+	validateBufferViews(doc, buffers);
+	const auto& formats = getTextureFormats(doc, opts);
+	const auto& textureOptions = getTextureOptions(doc, opts);
+	const auto& shared = findSharedTextures(doc, dir, buffers, formats, textureOptions, opts, (bool)baked);
+	const auto& images = loadImages(doc, dir, buffers, opts, shared.skipImages);
+	std::unique_ptr<TexturePacker> packer;
+	if (opts.PackTextures) {
+		packer = std::make_unique<TexturePacker>();
+	}
+
+	const auto& textures = loadTextures(doc, *images, formats, textureOptions, shared, baked.get(), packer.get(), opts.StreamTextures);
+	const auto& materials = loadMaterials(doc, textures);
+	auto primitives = loadAllPrimitives(doc, buffers, materials, opts, baked.get());
 
-    return std::make_tuple(data, dataChunks, dir);
+	if (baked) {
+		writeCache(getCachePath(opts.CacheDir, sourceHash), sourceHash, *baked);
+	}
+
+    return primitives;
 }
 
-std::vector<Mesh::Primitive> LoadPrimitivesFromFile(const std::string& filename)
+// State shared between the loader job and the main thread tasks
+struct asyncLoad_t {
+    Options opts;
+    storage_t storage;
+    document_t doc;
+    std::string dir;
+    std::vector<buffer_t> buffers;
+    std::unique_ptr<ImageDecoder> images;
+    sharedTextures_t sharedTextures;
+    std::vector<TextureMap> textures;
+    std::vector<Texture::Options> textureOptions;
+    std::vector<EncodedTexture> encodedTextures;
+    std::vector<MipChain> mipChains;
+    std::unique_ptr<TexturePacker> packer;
+    std::vector<size_t> packedTextures;
+    std::vector<Material *> materials;
+    std::shared_ptr<Mesh::BufferSet> glBuffers;
+    std::vector<Mesh::Primitive> primitives;
+    std::promise<std::vector<Mesh::Primitive>> promise;
+
+    uint64_t sourceHash = 0;
+    cacheView_t cache;
+    std::vector<std::shared_ptr<Texture>> cachedTextures;
+    Material * defaultMaterial = nullptr;
+    std::unique_ptr<bakedAsset_t> baked;
+};
+
+// Queues one main thread task per texture and one per batch of primitives
+void queueCachedLoad(std::shared_ptr<asyncLoad_t> load)
 {
-    const auto& [data, dataChunks, dir] = loadFile(filename);
-	
-	// TODO: Allow other buffers in GLB
-	const auto& buffers = (dataChunks.empty() ? loadBuffers(data, dir) : dataChunks);
-	const auto& bufferViews = loadBufferViews(data);
-	const auto& accessors = loadAccessors(data);
-	const auto& images = loadImages(data, dir, bufferViews, buffers);
-	const auto& samplers = loadSamplers(data);
-	const auto& textures = loadTextures(data, images, samplers);
-	const auto& materials = loadMaterials(data, textures);
-	auto primitives = loadAllPrimitives(data, bufferViews, buffers, accessors, materials);
-
-    return std::move(primitives);
+    const size_t PrimitivesPerTask = 64;
+
+    for (size_t i = 0; i < load->cache.textureCount; ++i) {
+        Program::RunOnMainThread([load, i]() {
+            load->cachedTextures.push_back(loadCachedTexture(load->cache, i));
+        });
+    }
+
+    Program::RunOnMainThread([load]() {
+        load->materials = loadCachedMaterials(load->cache, load->cachedTextures);
+        load->defaultMaterial = new Material();
+    });
+
+    for (size_t first = 0; first < load->cache.primitiveCount; first += PrimitivesPerTask) {
+        Program::RunOnMainThread([load, first]() {
+            size_t last = std::min(first + PrimitivesPerTask, load->cache.primitiveCount);
+            for (size_t i = first; i < last; ++i) {
+                load->primitives.push_back(loadCachedPrimitive(load->cache, i, load->materials, load->defaultMaterial));
+            }
+        });
+    }
+
+    Program::RunOnMainThread([load]() {
+        LogLoad("glTF '%s' finished loading asynchronously from cache", load->dir);
+        load->promise.set_value(std::move(load->primitives));
+    });
+}
+
+// The last reference to a load has to go on the main thread, its textures,
+// materials and buffers delete GL objects
+void releaseOnMainThread(std::shared_ptr<asyncLoad_t>&& load)
+{
+    Program::RunOnMainThread([load = std::move(load)]() {});
+}
+
+// File I/O, parsing, image decoding and encoding, run as a job. Every GL
+// call is queued as a small task for the main thread.
+void runAsyncLoad(const std::shared_ptr<asyncLoad_t>& load, const std::string& filename)
+{
+    buffer_t file;
+    std::string fullPath;
+    if (!openFile(filename, load->storage, load->opts, file, fullPath)) {
+        load->promise.set_value({});
+        return;
+    }
+
+    load->dir = GetDirname(fullPath);
+
+    bool useCache = canUseCache(load->opts);
+    if (useCache) {
+        load->sourceHash = getSourceHash(file, load->opts);
+
+        if (openCache(getCachePath(load->opts.CacheDir, load->sourceHash), load->sourceHash, load->dir, load->cache)) {
+            queueCachedLoad(load);
+            return;
+        }
+    }
+
+    std::vector<buffer_t> binChunks;
+    if (!parseFile(filename, file, load->opts, load->doc, binChunks)) {
+        load->promise.set_value({});
+        return;
+    }
+
+    if (useCache) {
+        load->baked = std::make_unique<bakedAsset_t>();
+        if (!bakeDocument(load->doc, load->dir, *load->baked)) {
+            load->baked.reset();
+        }
+    }
+
+    load->buffers = loadBuffers(load->doc, load->dir, binChunks, load->storage, load->opts);
+    validateBufferViews(load->doc, load->buffers);
+    load->glBuffers = std::make_shared<Mesh::BufferSet>();
+    load->glBuffers->Names.resize(load->doc.bufferViews.size(), 0);
+
+    // Holding the shared textures keeps them alive until the tasks use them
+    const auto& formats = getTextureFormats(load->doc, load->opts);
+    load->textureOptions = getTextureOptions(load->doc, load->opts);
+    load->sharedTextures = findSharedTextures(load->doc, load->dir, load->buffers, formats, load->textureOptions,
+        load->opts, (bool)load->baked);
+
+    load->images = loadImages(load->doc, load->dir, load->buffers, load->opts, load->sharedTextures.skipImages);
+    load->textures.resize(load->doc.textures.size());
+    load->encodedTextures.resize(load->doc.textures.size());
+    load->mipChains.resize(load->doc.textures.size());
+    load->packedTextures.resize(load->doc.textures.size(), SIZE_MAX);
+
+    if (load->opts.PackTextures) {
+        load->packer = std::make_unique<TexturePacker>();
+    }
+
+    // Wait and encode here rather than in the tasks so the main thread
+    // never blocks
+    const auto& users = getImageUsers(load->doc.textures, load->images->GetCount());
+    for (size_t i = 0; i < users.size(); ++i) {
+        const auto& image = load->images->Wait(i);
+        for (size_t index : users[i]) {
+            if (!load->sharedTextures.textures[index] || load->baked) {
+                load->encodedTextures[index] = encodeTexture(image, formats[index], load->textureOptions[index]);
+            }
+
+            // Copied now, the tasks only bake them
+            if (load->packer && isPackable(index, image, load->encodedTextures[index], load->sharedTextures)) {
+                load->packedTextures[index] = load->packer->Add(image.Data, image.Size, load->textureOptions[index]);
+                continue;
+            }
+
+            if ((!load->sharedTextures.textures[index] || load->baked) && load->encodedTextures[index].Data.empty()) {
+                load->mipChains[index] = generateMipChain(image, load->textureOptions[index]);
+            }
+        }
+
+        const auto& imageUsers = users[i];
+        Program::RunOnMainThread([load, i, imageUsers]() {
+            const auto& image = load->images->Wait(i);
+            for (size_t index : imageUsers) {
+                if (load->packedTextures[index] != SIZE_MAX) {
+                    if (load->baked) {
+                        bakeLoadedTexture(index, image, load->encodedTextures[index], MipChain(), load->textureOptions[index],
+                            *load->baked);
+                    }
+                    continue;
+                }
+
+                load->textures[index] = loadTexture(load->doc, index, image, load->encodedTextures[index],
+                    load->mipChains[index], load->textureOptions[index], load->sharedTextures, load->baked.get(),
+                    load->opts.StreamTextures);
+                load->encodedTextures[index] = EncodedTexture();
+                load->mipChains[index] = MipChain();
+            }
+            load->images->Release(i);
+        });
+    }
+
+    // Atlas pages are composed here, only the uploads are left for the
+    // main thread
+    if (load->packer) {
+        load->packer->Pack();
+    }
+
+    Program::RunOnMainThread([load]() {
+        if (load->packer) {
+            setPackedTextures(load->packedTextures, load->packer->Upload(), load->textures);
+            load->packer.reset();
+        }
+
+        load->images.reset();
+        load->materials = loadMaterials(load->doc, load->textures);
+    });
+
+    for (size_t i = 0; i < load->doc.meshes.size(); ++i) {
+        Program::RunOnMainThread([load, i]() {
+            LogVerbose("glTF mesh %s", load->doc.meshes[i].name);
+
+            auto tmp = loadPrimitives(load->doc, i, load->buffers, load->materials, load->glBuffers, load->opts, load->baked.get());
+            for (auto&& p : tmp) {
+                load->primitives.push_back(std::move(p));
+            }
+        });
+    }
+
+    Program::RunOnMainThread([load]() {
+        LogLoad("glTF '%s' finished loading asynchronously", load->dir);
+        load->promise.set_value(std::move(load->primitives));
+
+        // Nothing left needs the main thread, write the cache off it
+        if (load->baked) {
+            Program::GetJobSystem()->Submit([load = load]() mutable {
+                writeCache(getCachePath(load->opts.CacheDir, load->sourceHash), load->sourceHash, *load->baked);
+                releaseOnMainThread(std::move(load));
+            });
+        }
+    });
+}
+
+std::future<std::vector<Mesh::Primitive>> LoadPrimitivesFromFileAsync(const std::string& filename, Options opts /*= Options()*/)
+{
+    auto load = std::make_shared<asyncLoad_t>();
+    load->opts = opts;
+
+    auto future = load->promise.get_future();
+
+    Program::GetJobSystem()->Submit([load, filename]() mutable {
+        runAsyncLoad(load, filename);
+        releaseOnMainThread(std::move(load));
+    });
+
+    return future;
 }
 
 } // namespace glTF2
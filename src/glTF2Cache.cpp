@@ -0,0 +1,665 @@
+#include <glTF2Cache.hpp>
+
+#include <Hash.hpp>
+#include <Log.hpp>
+#include <TextureCache.hpp>
+#include <Util.hpp>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#if defined(WIN32)
+    #include <direct.h>
+#else
+    #include <sys/stat.h>
+#endif
+
+namespace glTF2 {
+
+std::string getCachePath(const std::string& cacheDir, uint64_t sourceHash)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016" PRIx64 ".glbc", sourceHash);
+    return cacheDir + "/" + name;
+}
+
+bool bakeDependency(const std::string& dir, const std::string& uri, bakedAsset_t& baked)
+{
+    if (uri.empty() || uri.compare(0, strlen("data:"), "data:") == 0) {
+        return true;
+    }
+
+    MappedFile file;
+    if (!file.Open(dir + "/" + uri)) {
+        return false;
+    }
+
+    baked.dependencies.push_back(bakedAsset_t::dependency_t{
+        uri,
+        file.GetSize(),
+        Hash64(file.GetData(), file.GetSize()),
+    });
+
+    return true;
+}
+
+bool bakeDocument(const document_t& doc, const std::string& dir, bakedAsset_t& baked)
+{
+    for (const auto& buffer : doc.buffers) {
+        if (!bakeDependency(dir, buffer.uri, baked)) {
+            return false;
+        }
+    }
+
+    for (const auto& image : doc.images) {
+        if (!bakeDependency(dir, image.uri, baked)) {
+            return false;
+        }
+    }
+
+    // Filled in by bakeTexture as each one loads
+    baked.textures.resize(doc.textures.size(), cacheTexture_t{});
+
+    for (const auto& material : doc.materials) {
+        cacheMaterial_t record;
+        memcpy(record.baseColorFactor, &material.baseColorFactor, sizeof(record.baseColorFactor));
+        record.metallicFactor = material.metallicFactor;
+        record.roughnessFactor = material.roughnessFactor;
+        record.normalScale = material.normalTexture.scale;
+        record.occlusionStrength = material.occlusionTexture.scale;
+        memcpy(record.emissiveFactor, &material.emissiveFactor, sizeof(record.emissiveFactor));
+        record.baseColorTexture = material.baseColorTexture.index;
+        record.metallicRoughnessTexture = material.metallicRoughnessTexture.index;
+        record.normalTexture = material.normalTexture.index;
+        record.occlusionTexture = material.occlusionTexture.index;
+        record.emissiveTexture = material.emissiveTexture.index;
+        baked.materials.push_back(record);
+    }
+
+    for (const auto& node : doc.nodes) {
+        cacheNode_t record;
+        record.mesh = node.mesh;
+        record.camera = node.camera;
+        record.childOffset = (uint32_t)baked.nodeChildren.size();
+        record.childCount = (uint32_t)node.children.size();
+        memcpy(record.translation, &node.translation, sizeof(record.translation));
+        record.rotation[0] = node.rotation.x;
+        record.rotation[1] = node.rotation.y;
+        record.rotation[2] = node.rotation.z;
+        record.rotation[3] = node.rotation.w;
+        memcpy(record.scale, &node.scale, sizeof(record.scale));
+        baked.nodes.push_back(record);
+
+        baked.nodeChildren.insert(baked.nodeChildren.end(), node.children.begin(), node.children.end());
+    }
+
+    if (doc.scene >= 0 && doc.scene < (int)doc.scenes.size()) {
+        const auto& nodes = doc.scenes[doc.scene].nodes;
+        baked.sceneNodes.assign(nodes.begin(), nodes.end());
+    }
+
+    return true;
+}
+
+void bakeTexture(size_t index, const Texture::Options& opts, const ImageDecoder::Image& image, bakedAsset_t& baked)
+{
+    if (index >= baked.textures.size() || !image.Data) {
+        return;
+    }
+
+    auto& record = baked.textures[index];
+    record.width = image.Size.x;
+    record.height = image.Size.y;
+    record.components = image.Components;
+    record.format = GL_RGBA8;
+    record.wrapS = opts.WrapS;
+    record.wrapT = opts.WrapT;
+    record.magFilter = opts.MagFilter;
+    record.minFilter = opts.MinFilter;
+    record.mipmap = opts.Mipmap;
+    record.srgb = opts.SRGB;
+    record.levels = 1;
+    record.dataOffset = baked.textureData.size();
+    record.dataSize = (uint64_t)image.Size.x * image.Size.y * image.Components;
+
+    baked.textureData.insert(baked.textureData.end(), image.Data, image.Data + record.dataSize);
+}
+
+void bakeEncodedTexture(size_t index, const Texture::Options& opts, const EncodedTexture& encoded, bakedAsset_t& baked)
+{
+    if (index >= baked.textures.size() || encoded.Data.empty()) {
+        return;
+    }
+
+    auto& record = baked.textures[index];
+    record.width = encoded.Size.x;
+    record.height = encoded.Size.y;
+    record.components = 4;
+    record.format = GetBlockFormatGL(encoded.Format);
+    record.wrapS = opts.WrapS;
+    record.wrapT = opts.WrapT;
+    record.magFilter = opts.MagFilter;
+    record.minFilter = opts.MinFilter;
+    record.mipmap = opts.Mipmap;
+    record.srgb = opts.SRGB;
+    record.levels = (uint32_t)encoded.Levels;
+    record.dataOffset = baked.textureData.size();
+    record.dataSize = encoded.Data.size();
+
+    baked.textureData.insert(baked.textureData.end(), encoded.Data.begin(), encoded.Data.end());
+}
+
+void bakeMipChain(size_t index, const Texture::Options& opts, const MipChain& chain, bakedAsset_t& baked)
+{
+    if (index >= baked.textures.size() || chain.Data.empty()) {
+        return;
+    }
+
+    auto& record = baked.textures[index];
+    record.width = chain.Size.x;
+    record.height = chain.Size.y;
+    record.components = 4;
+    record.format = GL_RGBA8;
+    record.wrapS = opts.WrapS;
+    record.wrapT = opts.WrapT;
+    record.magFilter = opts.MagFilter;
+    record.minFilter = opts.MinFilter;
+    record.mipmap = opts.Mipmap;
+    record.srgb = opts.SRGB;
+    record.levels = (uint32_t)chain.Levels;
+    record.dataOffset = baked.textureData.size();
+    record.dataSize = chain.Data.size();
+
+    baked.textureData.insert(baked.textureData.end(), chain.Data.begin(), chain.Data.end());
+}
+
+void bakeContainerTexture(size_t index, const Texture::Options& opts, const TextureContainer& container, bakedAsset_t& baked)
+{
+    if (index >= baked.textures.size() || container.File.empty()) {
+        return;
+    }
+
+    auto& record = baked.textures[index];
+    record.width = container.Size.x;
+    record.height = container.Size.y;
+    record.components = 4;
+    record.format = CacheTextureContainer;
+    record.wrapS = opts.WrapS;
+    record.wrapT = opts.WrapT;
+    record.magFilter = opts.MagFilter;
+    record.minFilter = opts.MinFilter;
+    record.mipmap = opts.Mipmap;
+    record.srgb = opts.SRGB;
+    record.levels = (uint32_t)container.Levels.size();
+    record.dataOffset = baked.textureData.size();
+    record.dataSize = container.File.size();
+
+    baked.textureData.insert(baked.textureData.end(), container.File.begin(), container.File.end());
+}
+
+void bakePrimitive(
+    size_t meshIndex,
+    const primitive_t& primitive,
+    const std::vector<GeometryArena::Vertex>& vertices,
+    const std::vector<uint32_t>& indices,
+    bakedAsset_t& baked)
+{
+    baked.primitives.push_back(cachePrimitive_t{
+        (uint32_t)meshIndex,
+        primitive.mode,
+        primitive.material,
+        (uint32_t)baked.vertices.size(),
+        (uint32_t)vertices.size(),
+        (uint32_t)baked.indices.size(),
+        (uint32_t)indices.size(),
+        0,
+    });
+
+    baked.vertices.insert(baked.vertices.end(), vertices.begin(), vertices.end());
+    baked.indices.insert(baked.indices.end(), indices.begin(), indices.end());
+}
+
+template <class T>
+bool getSection(
+    const uint8_t * data,
+    const cacheSection_t& section,
+    const T *& out,
+    size_t& count)
+{
+    if (section.size != (uint64_t)section.count * sizeof(T) || section.offset % CacheAlignment != 0) {
+        return false;
+    }
+
+    out = reinterpret_cast<const T *>(data + section.offset);
+    count = section.count;
+    return true;
+}
+
+bool openCache(const std::string& filename, uint64_t sourceHash, const std::string& dir, cacheView_t& view)
+{
+    view.file = std::make_unique<MappedFile>();
+    if (!view.file->Open(filename)) {
+        return false;
+    }
+
+    const uint8_t * data = view.file->GetData();
+    size_t size = view.file->GetSize();
+
+    cacheHeader_t header;
+    if (size < sizeof(header)) {
+        LogWarn("Invalid glTF cache '%s'", filename);
+        return false;
+    }
+
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != CacheMagic || header.version != CacheVersion ||
+        header.vertexSize != sizeof(GeometryArena::Vertex)) {
+        LogWarn("Outdated glTF cache '%s'", filename);
+        return false;
+    }
+
+    if (header.sourceHash != sourceHash) {
+        LogWarn("glTF cache '%s' does not match its source", filename);
+        return false;
+    }
+
+    size_t sectionsEnd = sizeof(header) + (size_t)header.sectionCount * sizeof(cacheSection_t);
+    if (sectionsEnd > size) {
+        LogWarn("Truncated glTF cache '%s'", filename);
+        return false;
+    }
+
+    const auto * sections = reinterpret_cast<const cacheSection_t *>(data + sizeof(header));
+    for (uint32_t i = 0; i < header.sectionCount; ++i) {
+        const auto& section = sections[i];
+        if (section.offset < sectionsEnd || section.offset > size || section.size > size - section.offset) {
+            LogWarn("Truncated glTF cache '%s'", filename);
+            return false;
+        }
+
+        bool ok = true;
+        switch ((CacheSection)section.type)
+        {
+        case CacheSection::Strings:
+            ok = getSection(data, section, view.strings, view.stringsSize);
+            break;
+        case CacheSection::Dependencies:
+            ok = getSection(data, section, view.dependencies, view.dependencyCount);
+            break;
+        case CacheSection::Textures:
+            ok = getSection(data, section, view.textures, view.textureCount);
+            break;
+        case CacheSection::TextureData:
+            ok = getSection(data, section, view.textureData, view.textureDataSize);
+            break;
+        case CacheSection::Materials:
+            ok = getSection(data, section, view.materials, view.materialCount);
+            break;
+        case CacheSection::Primitives:
+            ok = getSection(data, section, view.primitives, view.primitiveCount);
+            break;
+        case CacheSection::Vertices:
+            ok = getSection(data, section, view.vertices, view.vertexCount);
+            break;
+        case CacheSection::Indices:
+            ok = getSection(data, section, view.indices, view.indexCount);
+            break;
+        case CacheSection::Nodes:
+            ok = getSection(data, section, view.nodes, view.nodeCount);
+            break;
+        case CacheSection::NodeChildren:
+            ok = getSection(data, section, view.nodeChildren, view.nodeChildCount);
+            break;
+        case CacheSection::SceneNodes:
+            ok = getSection(data, section, view.sceneNodes, view.sceneNodeCount);
+            break;
+        }
+
+        if (!ok) {
+            LogWarn("Invalid glTF cache section %u in '%s'", section.type, filename);
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < view.primitiveCount; ++i) {
+        const auto& primitive = view.primitives[i];
+        if ((uint64_t)primitive.vertexOffset + primitive.vertexCount > view.vertexCount ||
+            (uint64_t)primitive.indexOffset + primitive.indexCount > view.indexCount) {
+            LogWarn("Invalid glTF cache primitive %zu in '%s'", i, filename);
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < view.textureCount; ++i) {
+        const auto& texture = view.textures[i];
+        if (texture.dataOffset > view.textureDataSize || texture.dataSize > view.textureDataSize - texture.dataOffset) {
+            LogWarn("Invalid glTF cache texture %zu in '%s'", i, filename);
+            return false;
+        }
+
+        // Baked formats follow what the GPU that wrote the cache supports,
+        // rebaking picks ones this GPU can upload
+        BlockFormat blockFormat = GetBlockFormat(texture.format);
+        if (blockFormat != BlockFormat::None && !IsBlockFormatSupported(blockFormat)) {
+            LogWarn("glTF cache '%s' has textures in a format this GPU doesn't support", filename);
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < view.nodeCount; ++i) {
+        const auto& node = view.nodes[i];
+        if ((uint64_t)node.childOffset + node.childCount > view.nodeChildCount) {
+            LogWarn("Invalid glTF cache node %zu in '%s'", i, filename);
+            return false;
+        }
+    }
+
+    // The external files are hashed last, they are the expensive part
+    for (size_t i = 0; i < view.dependencyCount; ++i) {
+        const auto& dependency = view.dependencies[i];
+        if ((uint64_t)dependency.pathOffset + dependency.pathLength > view.stringsSize) {
+            LogWarn("Invalid glTF cache dependency %zu in '%s'", i, filename);
+            return false;
+        }
+
+        std::string path(view.strings + dependency.pathOffset, dependency.pathLength);
+
+        MappedFile file;
+        if (!file.Open(dir + "/" + path) || file.GetSize() != dependency.size ||
+            Hash64(file.GetData(), file.GetSize()) != dependency.hash) {
+            LogWarn("glTF cache '%s' is stale, '%s' has changed", filename, path);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool createDirectory(const std::string& path)
+{
+#if defined(WIN32)
+    return (_mkdir(path.c_str()) == 0 || errno == EEXIST);
+#else
+    return (mkdir(path.c_str(), 0755) == 0 || errno == EEXIST);
+#endif
+}
+
+bool writeCache(const std::string& filename, uint64_t sourceHash, const bakedAsset_t& baked)
+{
+    createDirectory(GetDirname(filename));
+
+    std::string strings;
+    std::vector<cacheDependency_t> dependencies;
+    for (const auto& dependency : baked.dependencies) {
+        dependencies.push_back(cacheDependency_t{
+            (uint32_t)strings.size(),
+            (uint32_t)dependency.path.size(),
+            dependency.size,
+            dependency.hash,
+        });
+        strings += dependency.path;
+    }
+
+    struct block_t {
+        CacheSection type;
+        const void * data;
+        size_t count;
+        size_t elementSize;
+    };
+
+    const block_t blocks[] = {
+        { CacheSection::Strings, strings.data(), strings.size(), sizeof(char) },
+        { CacheSection::Dependencies, dependencies.data(), dependencies.size(), sizeof(cacheDependency_t) },
+        { CacheSection::Textures, baked.textures.data(), baked.textures.size(), sizeof(cacheTexture_t) },
+        { CacheSection::TextureData, baked.textureData.data(), baked.textureData.size(), sizeof(uint8_t) },
+        { CacheSection::Materials, baked.materials.data(), baked.materials.size(), sizeof(cacheMaterial_t) },
+        { CacheSection::Primitives, baked.primitives.data(), baked.primitives.size(), sizeof(cachePrimitive_t) },
+        { CacheSection::Vertices, baked.vertices.data(), baked.vertices.size(), sizeof(GeometryArena::Vertex) },
+        { CacheSection::Indices, baked.indices.data(), baked.indices.size(), sizeof(uint32_t) },
+        { CacheSection::Nodes, baked.nodes.data(), baked.nodes.size(), sizeof(cacheNode_t) },
+        { CacheSection::NodeChildren, baked.nodeChildren.data(), baked.nodeChildren.size(), sizeof(int32_t) },
+        { CacheSection::SceneNodes, baked.sceneNodes.data(), baked.sceneNodes.size(), sizeof(int32_t) },
+    };
+
+    const size_t blockCount = sizeof(blocks) / sizeof(blocks[0]);
+
+    auto align = [](uint64_t offset) {
+        return (offset + CacheAlignment - 1) & ~(uint64_t)(CacheAlignment - 1);
+    };
+
+    cacheHeader_t header = {
+        CacheMagic,
+        CacheVersion,
+        sourceHash,
+        (uint32_t)blockCount,
+        (uint32_t)sizeof(GeometryArena::Vertex),
+    };
+
+    std::vector<cacheSection_t> sections;
+    uint64_t offset = align(sizeof(header) + blockCount * sizeof(cacheSection_t));
+    for (const auto& block : blocks) {
+        if (block.count > UINT32_MAX) {
+            LogError("glTF cache section %u is too large", (uint32_t)block.type);
+            return false;
+        }
+
+        uint64_t size = (uint64_t)block.count * block.elementSize;
+        sections.push_back(cacheSection_t{ (uint32_t)block.type, (uint32_t)block.count, offset, size });
+        offset = align(offset + size);
+    }
+
+    // Written under a temporary name so a crash never leaves a partial cache
+    const std::string tmpFilename = filename + ".tmp";
+
+    std::ofstream file(tmpFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        LogWarn("Failed to write glTF cache '%s'", filename);
+        return false;
+    }
+
+    static const char zeros[CacheAlignment] = { 0 };
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(sections.data()), sections.size() * sizeof(cacheSection_t));
+
+    uint64_t written = sizeof(header) + sections.size() * sizeof(cacheSection_t);
+    for (size_t i = 0; i < blockCount; ++i) {
+        file.write(zeros, (std::streamsize)(sections[i].offset - written));
+        file.write(reinterpret_cast<const char *>(blocks[i].data), (std::streamsize)sections[i].size);
+        written = sections[i].offset + sections[i].size;
+    }
+
+    file.close();
+    if (file.fail()) {
+        LogWarn("Failed to write glTF cache '%s'", filename);
+        remove(tmpFilename.c_str());
+        return false;
+    }
+
+    remove(filename.c_str());
+    if (rename(tmpFilename.c_str(), filename.c_str()) != 0) {
+        LogWarn("Failed to write glTF cache '%s'", filename);
+        remove(tmpFilename.c_str());
+        return false;
+    }
+
+    LogLoad("glTF cache '%s', %zu bytes", filename, (size_t)written);
+    return true;
+}
+
+std::shared_ptr<Texture> createCachedTexture(const cacheView_t& view, const cacheTexture_t& record, const Texture::Options& opts)
+{
+    glm::ivec2 size(record.width, record.height);
+
+    if (record.format == CacheTextureContainer) {
+        TextureContainer container;
+        if (!ParseTextureContainer(view.textureData + record.dataOffset, record.dataSize, container)) {
+            return nullptr;
+        }
+
+        return std::make_shared<Texture>(container, opts);
+    }
+
+    BlockFormat blockFormat = GetBlockFormat(record.format);
+    if (blockFormat != BlockFormat::None) {
+        if (record.levels < 1 ||
+            record.dataSize != GetEncodedSize(blockFormat, size, (int)record.levels)) {
+            LogError("Invalid glTF cache texture size");
+            return nullptr;
+        }
+
+        if (!IsBlockFormatSupported(blockFormat)) {
+            LogError("Unsupported glTF cache texture format %04x", record.format);
+            return nullptr;
+        }
+
+        return std::make_shared<Texture>(
+            blockFormat,
+            size,
+            (int)record.levels,
+            view.textureData + record.dataOffset,
+            opts
+        );
+    }
+
+    // A baked mip chain, uploaded in place like a container
+    if (record.format == GL_RGBA8 && record.levels > 1) {
+        if (record.components != 4 || record.levels > (uint32_t)GetMipLevelCount(size) ||
+            record.dataSize != GetMipChainSize(size, (int)record.levels)) {
+            LogError("Invalid glTF cache texture size");
+            return nullptr;
+        }
+
+        TextureContainer container;
+        container.InternalFormat = GL_RGBA8;
+        container.Format = GL_RGBA;
+        container.Type = GL_UNSIGNED_BYTE;
+        container.Size = size;
+
+        const uint8_t * data = view.textureData + record.dataOffset;
+        for (uint32_t level = 0; level < record.levels; ++level) {
+            size_t levelSize = (size_t)size.x * size.y * 4;
+            container.Levels.push_back(TextureContainer::Level{ data, levelSize });
+
+            data += levelSize;
+            size = glm::ivec2(std::max(1, size.x / 2), std::max(1, size.y / 2));
+        }
+
+        return std::make_shared<Texture>(container, opts);
+    }
+
+    if (record.format != GL_RGBA8 ||
+        record.dataSize != (uint64_t)record.width * record.height * record.components) {
+        LogError("Unsupported glTF cache texture format %04x", record.format);
+        return nullptr;
+    }
+
+    return std::make_shared<Texture>(
+        view.textureData + record.dataOffset,
+        size,
+        record.components,
+        opts
+    );
+}
+
+std::shared_ptr<Texture> loadCachedTexture(const cacheView_t& view, size_t index)
+{
+    const auto& record = view.textures[index];
+    if (record.dataSize == 0) {
+        return nullptr;
+    }
+
+    Texture::Options opts;
+    opts.WrapS = record.wrapS;
+    opts.WrapT = record.wrapT;
+    opts.MagFilter = record.magFilter;
+    opts.MinFilter = record.minFilter;
+    opts.Mipmap = (record.mipmap != 0);
+    opts.SRGB = (record.srgb != 0);
+    opts.Compression = GetBlockFormat(record.format);
+
+    // Keyed by the payload, which is only ever shared with other caches
+    TextureCache::Key key;
+    key.Hash = Hash64(view.textureData + record.dataOffset, record.dataSize, record.format);
+    key.Options = opts;
+
+    auto texture = TextureCache::Inst()->Find(key);
+    if (texture) {
+        return texture;
+    }
+
+    texture = createCachedTexture(view, record, opts);
+    if (texture) {
+        texture = TextureCache::Inst()->Insert(key, texture);
+    }
+
+    return texture;
+}
+
+std::vector<Material *> loadCachedMaterials(const cacheView_t& view, const std::vector<std::shared_ptr<Texture>>& textures)
+{
+    std::vector<Material *> materials;
+
+    auto getTexture = [&textures](int32_t index) -> std::shared_ptr<Texture> {
+        return (index >= 0 && index < (int32_t)textures.size() ? textures[index] : nullptr);
+    };
+
+    for (size_t i = 0; i < view.materialCount; ++i) {
+        const auto& record = view.materials[i];
+
+        materials.push_back(new Material);
+        auto& material = materials.back();
+
+        material->BaseColorFactor = glm::make_vec4(record.baseColorFactor);
+        material->BaseColorMap = getTexture(record.baseColorTexture);
+
+        material->MetallicFactor = record.metallicFactor;
+        material->RoughnessFactor = record.roughnessFactor;
+        material->MetallicRoughnessMap = getTexture(record.metallicRoughnessTexture);
+
+        material->NormalMap = getTexture(record.normalTexture);
+        material->NormalScale = record.normalScale;
+
+        material->OcclusionMap = getTexture(record.occlusionTexture);
+        material->OcclusionStrength = record.occlusionStrength;
+
+        material->EmissiveMap = getTexture(record.emissiveTexture);
+        material->EmissiveFactor = glm::make_vec3(record.emissiveFactor);
+    }
+
+    return materials;
+}
+
+Mesh::Primitive loadCachedPrimitive(
+    const cacheView_t& view,
+    size_t index,
+    const std::vector<Material *>& materials,
+    Material * defaultMaterial)
+{
+    const auto& record = view.primitives[index];
+
+    Mesh::Primitive prim;
+    prim.Mode = record.mode;
+    prim.Mat = (record.material >= 0 && record.material < (int32_t)materials.size()
+        ? materials[record.material]
+        : defaultMaterial);
+
+    // Straight from the mapping into the arena, no intermediate copy
+    auto arena = GeometryArena::Inst();
+    auto alloc = arena->Allocate(record.vertexCount, record.indexCount);
+    arena->Upload(alloc, view.vertices + record.vertexOffset, view.indices + record.indexOffset);
+
+    prim.VAO = (alloc.Page >= 0 ? arena->GetVAO(alloc.Page) : 0);
+    prim.Count = (GLsizei)alloc.IndexCount;
+    prim.Type = GL_UNSIGNED_INT;
+    prim.Offset = (GLsizei)(alloc.IndexOffset * sizeof(uint32_t));
+    prim.BaseVertex = (GLint)alloc.VertexOffset;
+    prim.Allocation = alloc;
+
+    return prim;
+}
+
+} // namespace glTF2
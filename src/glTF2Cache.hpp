@@ -0,0 +1,240 @@
+#pragma once
+
+#include <glTF2Document.hpp>
+
+#include <GeometryArena.hpp>
+#include <ImageDecoder.hpp>
+#include <MappedFile.hpp>
+#include <Material.hpp>
+#include <Mesh.hpp>
+#include <Texture.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace glTF2 {
+
+// Runtime cache of a loaded glTF: textures, materials, primitives in the
+// GeometryArena vertex layout and the node table, stored ready for upload.
+// A cache file is named after the hash of the source file and also records
+// the hash of every external file it was built from.
+//
+// Layout, little-endian, every section aligned to CacheAlignment:
+//   cacheHeader_t
+//   cacheSection_t[header.sectionCount]
+//   section data
+
+const uint32_t CacheMagic = 0x43424C47; // GLBC
+const uint32_t CacheVersion = 4;
+const size_t CacheAlignment = 16;
+
+// cacheTexture_t::format of a KTX2 or DDS file stored as is
+const uint32_t CacheTextureContainer = 0x3258544B; // KTX2
+
+enum class CacheSection : uint32_t
+{
+    Strings,      // char
+    Dependencies, // cacheDependency_t
+    Textures,     // cacheTexture_t
+    TextureData,  // uint8_t
+    Materials,    // cacheMaterial_t
+    Primitives,   // cachePrimitive_t
+    Vertices,     // GeometryArena::Vertex
+    Indices,      // uint32_t
+    Nodes,        // cacheNode_t
+    NodeChildren, // int32_t
+    SceneNodes,   // int32_t
+};
+
+struct cacheHeader_t {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceHash;
+    uint32_t sectionCount;
+    uint32_t vertexSize;
+};
+
+struct cacheSection_t {
+    uint32_t type;
+    uint32_t count;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct cacheDependency_t {
+    // Path relative to the source file, in the Strings section
+    uint32_t pathOffset;
+    uint32_t pathLength;
+    uint64_t size;
+    uint64_t hash;
+};
+
+struct cacheTexture_t {
+    int32_t width;
+    int32_t height;
+    int32_t components;
+
+    // Layout of the payload, GL_RGBA8 for raw pixels, a compressed format
+    // with every level stored or CacheTextureContainer
+    uint32_t format;
+
+    uint32_t wrapS;
+    uint32_t wrapT;
+    uint32_t magFilter;
+    uint32_t minFilter;
+    uint32_t mipmap;
+    uint32_t levels;
+    uint32_t srgb;
+    uint32_t padding;
+
+    // Into the TextureData section, a size of 0 marks a texture that failed
+    uint64_t dataOffset;
+    uint64_t dataSize;
+};
+
+struct cacheMaterial_t {
+    float baseColorFactor[4];
+    float metallicFactor;
+    float roughnessFactor;
+    float normalScale;
+    float occlusionStrength;
+    float emissiveFactor[3];
+
+    // Texture indices, -1 for none
+    int32_t baseColorTexture;
+    int32_t metallicRoughnessTexture;
+    int32_t normalTexture;
+    int32_t occlusionTexture;
+    int32_t emissiveTexture;
+};
+
+struct cachePrimitive_t {
+    uint32_t mesh;
+    uint32_t mode;
+    int32_t material;
+    uint32_t vertexOffset;
+    uint32_t vertexCount;
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    uint32_t padding;
+};
+
+struct cacheNode_t {
+    int32_t mesh;
+    int32_t camera;
+
+    // Into the NodeChildren section
+    uint32_t childOffset;
+    uint32_t childCount;
+
+    float translation[3];
+    float rotation[4]; // x, y, z, w
+    float scale[3];
+};
+
+// Collects the post-processed asset while it loads normally, so it can be
+// written out as a cache afterwards
+struct bakedAsset_t {
+    struct dependency_t {
+        std::string path;
+        uint64_t size;
+        uint64_t hash;
+    };
+
+    std::vector<dependency_t> dependencies;
+
+    std::vector<cacheTexture_t> textures;
+    std::vector<uint8_t> textureData;
+
+    std::vector<cacheMaterial_t> materials;
+    std::vector<cachePrimitive_t> primitives;
+
+    std::vector<GeometryArena::Vertex> vertices;
+    std::vector<uint32_t> indices;
+
+    std::vector<cacheNode_t> nodes;
+    std::vector<int32_t> nodeChildren;
+    std::vector<int32_t> sceneNodes;
+};
+
+// A validated, memory-mapped cache file. Every pointer points into the
+// mapping and stays valid as long as the view is alive.
+struct cacheView_t {
+    std::unique_ptr<MappedFile> file;
+
+    const char * strings = nullptr;
+    size_t stringsSize = 0;
+
+    const cacheDependency_t * dependencies = nullptr;
+    size_t dependencyCount = 0;
+
+    const cacheTexture_t * textures = nullptr;
+    size_t textureCount = 0;
+
+    const uint8_t * textureData = nullptr;
+    size_t textureDataSize = 0;
+
+    const cacheMaterial_t * materials = nullptr;
+    size_t materialCount = 0;
+
+    const cachePrimitive_t * primitives = nullptr;
+    size_t primitiveCount = 0;
+
+    const GeometryArena::Vertex * vertices = nullptr;
+    size_t vertexCount = 0;
+
+    const uint32_t * indices = nullptr;
+    size_t indexCount = 0;
+
+    const cacheNode_t * nodes = nullptr;
+    size_t nodeCount = 0;
+
+    const int32_t * nodeChildren = nullptr;
+    size_t nodeChildCount = 0;
+
+    const int32_t * sceneNodes = nullptr;
+    size_t sceneNodeCount = 0;
+};
+
+std::string getCachePath(const std::string& cacheDir, uint64_t sourceHash);
+
+// Adds the document's materials, nodes and external files to baked, fails if
+// an external file can't be read
+bool bakeDocument(const document_t& doc, const std::string& dir, bakedAsset_t& baked);
+
+void bakeTexture(size_t index, const Texture::Options& opts, const ImageDecoder::Image& image, bakedAsset_t& baked);
+
+void bakeEncodedTexture(size_t index, const Texture::Options& opts, const EncodedTexture& encoded, bakedAsset_t& baked);
+
+// Stores every level so loading from the cache never generates any
+void bakeMipChain(size_t index, const Texture::Options& opts, const MipChain& chain, bakedAsset_t& baked);
+
+void bakeContainerTexture(size_t index, const Texture::Options& opts, const TextureContainer& container, bakedAsset_t& baked);
+
+void bakePrimitive(
+    size_t meshIndex,
+    const primitive_t& primitive,
+    const std::vector<GeometryArena::Vertex>& vertices,
+    const std::vector<uint32_t>& indices,
+    bakedAsset_t& baked);
+
+// Fails quietly if there is no cache, and with a warning if it is stale or
+// corrupt, the caller then loads from source as usual
+bool openCache(const std::string& filename, uint64_t sourceHash, const std::string& dir, cacheView_t& view);
+
+bool writeCache(const std::string& filename, uint64_t sourceHash, const bakedAsset_t& baked);
+
+// Shared through the TextureCache with other caches holding the same payload
+std::shared_ptr<Texture> loadCachedTexture(const cacheView_t& view, size_t index);
+
+std::vector<Material *> loadCachedMaterials(const cacheView_t& view, const std::vector<std::shared_ptr<Texture>>& textures);
+
+Mesh::Primitive loadCachedPrimitive(
+    const cacheView_t& view, 
+    size_t index, 
+    const std::vector<Material *>& materials,
+    Material * defaultMaterial);
+
+} // namespace glTF2
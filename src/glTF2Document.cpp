@@ -0,0 +1,952 @@
+#include <glTF2Document.hpp>
+
+#include <Log.hpp>
+
+#include <depend/JSON.hpp>
+
+#include <cstring>
+
+namespace glTF2 {
+
+glm::vec3 parseVec3(const json& value, glm::vec3 def)
+{
+    if (value.is_array() && value.size() == 3) {
+        const auto& v = value.get<std::vector<float>>();
+        return glm::make_vec3(v.data());
+    }
+    return def;
+}
+
+glm::vec4 parseVec4(const json& value, glm::vec4 def)
+{
+    if (value.is_array() && value.size() == 4) {
+        const auto& v = value.get<std::vector<float>>();
+        return glm::make_vec4(v.data());
+    }
+    return def;
+}
+
+glm::quat parseQuat(const json& value, glm::quat def)
+{
+    if (value.is_array() && value.size() == 4) {
+        const auto& v = value.get<std::vector<float>>();
+        return glm::quat(v[3], v[0], v[1], v[2]);
+    }
+    return def;
+}
+
+//
+// DOM
+//
+
+std::vector<buffer_desc_t> parseBuffers(const json& data)
+{
+    std::vector<buffer_desc_t> buffers;
+
+    const auto it = data.find("buffers");
+    if (it != data.cend()) {
+        if (it.value().is_array()) {
+            const auto& array = it.value();
+            for (const auto& object : array) {
+                if (object.is_object()) {
+                    buffers.push_back(buffer_desc_t{
+                        object.value("uri", ""),
+                        object.value<size_t>("byteLength", 0),
+                    });
+                }
+            }
+        }
+    }
+
+    return buffers;
+}
+
+std::vector<bufferView_t> parseBufferViews(const json& data)
+{
+    std::vector<bufferView_t> bufferViews;
+
+    const auto it = data.find("bufferViews");
+    if (it != data.cend()) {
+        if (it.value().is_array()) {
+            const auto& array = it.value();
+            for (const auto& object : array) {
+                if (object.is_object()) {
+                    bufferViews.push_back(bufferView_t{
+                        object.value("buffer", -1),
+                        object.value<size_t>("byteLength", 0),
+                        object.value<size_t>("byteOffset", 0),
+                        object.value<size_t>("byteStride", 0),
+                        object.value<GLenum>("target", GL_INVALID_ENUM),
+                    });
+                }
+            }
+        }
+    }
+
+    return bufferViews;
+}
+
+std::vector<accessor_t> parseAccessors(const json& data)
+{
+    std::vector<accessor_t> accessors;
+
+    const auto& it = data.find("accessors");
+    if (it != data.cend()) {
+        if (it.value().is_array()) {
+            const auto& array = it.value();
+            for (const auto& object : array) {
+                if (object.is_object()) {
+                    accessors.push_back(accessor_t{
+                        object.value("bufferView", -1),
+                        object.value("type", ""),
+                        object.value<size_t>("byteOffset", 0),
+                        object.value<GLenum>("componentType", GL_INVALID_ENUM),
+                        object.value<bool>("normalized", false),
+                        object.value<size_t>("count", 0),
+                        // TODO: min, max
+                    });
+                }
+            }
+        }
+    }
+
+    return accessors;
+}
+
+std::vector<image_desc_t> parseImages(const json& data)
+{
+    std::vector<image_desc_t> images;
+
+    const auto it = data.find("images");
+    if (it != data.cend()) {
+        if (it.value().is_array()) {
+            const auto& array = it.value();
+            for (const auto& object : array) {
+                if (object.is_object()) {
+                    images.push_back(image_desc_t{
+                        object.value("uri", ""),
+                        object.value("bufferView", -1),
+                        object.value("mimeType", ""),
+                    });
+                }
+            }
+        }
+    }
+
+    return images;
+}
+
+std::vector<Texture::Options> parseSamplers(const json& data)
+{
+    std::vector<Texture::Options> samplers;
+
+    const auto it = data.find("samplers");
+    if (it != data.cend()) {
+        if (it.value().is_array()) {
+            const auto& array = it.value();
+            for (const auto& object : array) {
+                if (object.is_object()) {
+                    samplers.push_back(Texture::Options{});
+                    auto& sampler = samplers.back();
+
+                    sampler.MagFilter = object.value<GLenum>("magFilter", sampler.MagFilter);
+                    sampler.MinFilter = object.value<GLenum>("minFilter", sampler.MinFilter);
+                    sampler.WrapS = object.value<GLenum>("wrapS", sampler.WrapS);
+                    sampler.WrapT = object.value<GLenum>("wrapT", sampler.WrapT);
+                }
+            }
+        }
+    }
+
+    return samplers;
+}
+
+std::vector<texture_desc_t> parseTextures(const json& data)
+{
+    std::vector<texture_desc_t> textures;
+
+    const auto it = data.find("textures");
+    if (it != data.cend()) {
+        if (it.value().is_array()) {
+            const auto& array = it.value();
+            for (const auto& object : array) {
+                if (object.is_object()) {
+                    textures.push_back(texture_desc_t{
+                        object.value("sampler", -1),
+                        object.value("source", -1),
+                    });
+                }
+            }
+        }
+    }
+
+    return textures;
+}
+
+textureRef_t parseTextureRef(const json& value, const char * scaleKey)
+{
+    textureRef_t ref;
+    if (value.is_object()) {
+        ref.index = value.value("index", -1);
+        ref.texCoord = value.value("texCoord", 0);
+        if (scaleKey) {
+            ref.scale = value.value(scaleKey, 1.f);
+        }
+    }
+    return ref;
+}
+
+std::vector<material_t> parseMaterials(const json& data)
+{
+    std::vector<material_t> materials;
+
+    const auto it = data.find("materials");
+    if (it != data.cend()) {
+        const auto& array = it.value();
+        for (const auto& object : array) {
+            if (object.is_object()) {
+                materials.push_back(material_t{});
+                auto& material = materials.back();
+
+                material.name = object.value("name", "");
+                material.alphaMode = object.value("alphaMode", material.alphaMode);
+                material.alphaCutoff = object.value("alphaCutoff", material.alphaCutoff);
+
+                auto valIt = object.find("normalTexture");
+                if (valIt != object.end()) {
+                    material.normalTexture = parseTextureRef(valIt.value(), "scale");
+                }
+
+                valIt = object.find("emissiveFactor");
+                if (valIt != object.end()) {
+                    material.emissiveFactor = parseVec3(valIt.value(), material.emissiveFactor);
+                }
+
+                valIt = object.find("emissiveTexture");
+                if (valIt != object.end()) {
+                    material.emissiveTexture = parseTextureRef(valIt.value(), nullptr);
+                }
+
+                valIt = object.find("occlusionTexture");
+                if (valIt != object.end()) {
+                    material.occlusionTexture = parseTextureRef(valIt.value(), "strength");
+                }
+
+                const auto groupIt = object.find("pbrMetallicRoughness");
+                if (groupIt != object.cend()) {
+                    const auto& group = groupIt.value();
+                    if (group.is_object()) {
+                        valIt = group.find("baseColorFactor");
+                        if (valIt != group.end()) {
+                            material.baseColorFactor = parseVec4(valIt.value(), material.baseColorFactor);
+                        }
+
+                        valIt = group.find("baseColorTexture");
+                        if (valIt != group.end()) {
+                            material.baseColorTexture = parseTextureRef(valIt.value(), nullptr);
+                        }
+
+                        material.metallicFactor = group.value("metallicFactor", material.metallicFactor);
+                        material.roughnessFactor = group.value("roughnessFactor", material.roughnessFactor);
+
+                        valIt = group.find("metallicRoughnessTexture");
+                        if (valIt != group.end()) {
+                            material.metallicRoughnessTexture = parseTextureRef(valIt.value(), nullptr);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return materials;
+}
+
+std::vector<mesh_t> parseMeshes(const json& data)
+{
+    std::vector<mesh_t> meshes;
+
+    const auto it = data.find("meshes");
+    if (it != data.cend()) {
+        const auto& array = it.value();
+        for (const auto& object : array) {
+            if (object.is_object()) {
+                meshes.push_back(mesh_t{});
+                auto& mesh = meshes.back();
+
+                mesh.name = object.value("name", "");
+
+                const auto& primIt = object.find("primitives");
+                if (primIt != object.end() && primIt.value().is_array()) {
+                    for (const auto& value : primIt.value()) {
+                        if (value.is_object()) {
+                            mesh.primitives.push_back(primitive_t{});
+                            auto& primitive = mesh.primitives.back();
+
+                            primitive.indices = value.value("indices", -1);
+                            primitive.material = value.value("material", -1);
+                            primitive.mode = value.value<GLenum>("mode", GL_TRIANGLES);
+
+                            const auto& attrIt = value.find("attributes");
+                            if (attrIt != value.end() && attrIt.value().is_object()) {
+                                for (const auto& [attrib, accessorIndex] : attrIt.value().items()) {
+                                    primitive.attributes.emplace_back(attrib, accessorIndex.get<int>());
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return meshes;
+}
+
+std::vector<node_t> parseNodes(const json& data)
+{
+    std::vector<node_t> nodes;
+
+    const auto it = data.find("nodes");
+    if (it != data.cend()) {
+        const auto& array = it.value();
+        for (const auto& object : array) {
+            if (object.is_object()) {
+                nodes.push_back(node_t{});
+                auto& node = nodes.back();
+
+                node.name = object.value("name", "");
+                node.mesh = object.value("mesh", -1);
+                node.camera = object.value("camera", -1);
+
+                auto valIt = object.find("children");
+                if (valIt != object.end() && valIt.value().is_array()) {
+                    node.children = valIt.value().get<std::vector<int>>();
+                }
+
+                valIt = object.find("translation");
+                if (valIt != object.end()) {
+                    node.translation = parseVec3(valIt.value(), node.translation);
+                }
+
+                valIt = object.find("rotation");
+                if (valIt != object.end()) {
+                    node.rotation = parseQuat(valIt.value(), node.rotation);
+                }
+
+                valIt = object.find("scale");
+                if (valIt != object.end()) {
+                    node.scale = parseVec3(valIt.value(), node.scale);
+                }
+            }
+        }
+    }
+
+    return nodes;
+}
+
+std::vector<scene_t> parseScenes(const json& data)
+{
+    std::vector<scene_t> scenes;
+
+    const auto it = data.find("scenes");
+    if (it != data.cend()) {
+        const auto& array = it.value();
+        for (const auto& object : array) {
+            if (object.is_object()) {
+                scenes.push_back(scene_t{});
+
+                const auto& nodesIt = object.find("nodes");
+                if (nodesIt != object.end() && nodesIt.value().is_array()) {
+                    scenes.back().nodes = nodesIt.value().get<std::vector<int>>();
+                }
+            }
+        }
+    }
+
+    return scenes;
+}
+
+std::vector<std::string> parseStrings(const json& data, const char * key)
+{
+    std::vector<std::string> strings;
+
+    const auto it = data.find(key);
+    if (it != data.cend() && it.value().is_array()) {
+        for (const auto& value : it.value()) {
+            if (value.is_string()) {
+                strings.push_back(value.get<std::string>());
+            }
+        }
+    }
+
+    return strings;
+}
+
+bool parseDocumentDOM(const char * begin, const char * end, document_t& doc)
+{
+    json data = json::parse(begin, end, nullptr, false);
+    if (data.is_discarded() || !data.is_object()) {
+        return false;
+    }
+
+    const auto it = data.find("asset");
+    if (it != data.end() && it.value().is_object()) {
+        doc.version = it.value().value("version", "");
+        doc.generator = it.value().value("generator", "");
+    }
+
+    doc.extensionsRequired = parseStrings(data, "extensionsRequired");
+    doc.extensionsUsed = parseStrings(data, "extensionsUsed");
+    doc.scene = data.value("scene", 0);
+
+    doc.buffers = parseBuffers(data);
+    doc.bufferViews = parseBufferViews(data);
+    doc.accessors = parseAccessors(data);
+    doc.images = parseImages(data);
+    doc.samplers = parseSamplers(data);
+    doc.textures = parseTextures(data);
+    doc.materials = parseMaterials(data);
+    doc.meshes = parseMeshes(data);
+    doc.nodes = parseNodes(data);
+    doc.scenes = parseScenes(data);
+
+    return true;
+}
+
+//
+// SAX
+//
+
+// Tracks where in the document each event lands with a stack of frames, one
+// per open object or array. Values are written straight into the document,
+// everything the loader doesn't use is skipped without being stored.
+class saxHandler_t
+{
+public:
+
+    enum class context_t {
+        Root,
+        Asset,
+        Skip,
+        Table,      // Top level array of objects, e.g. "accessors"
+        Item,       // One object of a Table
+        PBR,        // material.pbrMetallicRoughness
+        TextureRef, // material.*Texture
+        Primitives,
+        Primitive,
+        Attributes,
+        Numbers,    // Array of numbers, applied when it ends
+        Strings,    // Array of strings, e.g. "extensionsUsed"
+    };
+
+    enum class table_t {
+        None,
+        Buffers,
+        BufferViews,
+        Accessors,
+        Images,
+        Samplers,
+        Textures,
+        Materials,
+        Meshes,
+        Nodes,
+        Scenes,
+    };
+
+    struct frame_t {
+        context_t context;
+        table_t table = table_t::None;
+
+        // Key this object or array was found under
+        std::string key;
+
+        textureRef_t * ref = nullptr;
+        std::vector<std::string> * strings = nullptr;
+        std::vector<double> numbers;
+    };
+
+    inline saxHandler_t(document_t& doc)
+        : doc_(doc)
+    { }
+
+    bool null() {
+        return true;
+    }
+
+    bool boolean(bool value)
+    {
+        if (stack_.empty()) {
+            return false;
+        }
+
+        const auto& top = stack_.back();
+        if (top.context == context_t::Item && top.table == table_t::Accessors && key_ == "normalized") {
+            doc_.accessors.back().normalized = value;
+        }
+        return true;
+    }
+
+    bool number_integer(json::number_integer_t value) {
+        return number((double)value);
+    }
+
+    bool number_unsigned(json::number_unsigned_t value) {
+        return number((double)value);
+    }
+
+    bool number_float(json::number_float_t value, const json::string_t&) {
+        return number((double)value);
+    }
+
+    bool string(json::string_t& value);
+
+    bool binary(json::binary_t&) {
+        return true;
+    }
+
+    bool start_object(std::size_t);
+
+    bool end_object()
+    {
+        stack_.pop_back();
+        return true;
+    }
+
+    bool start_array(std::size_t);
+
+    bool end_array();
+
+    bool key(json::string_t& key)
+    {
+        key_.swap(key);
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string& lastToken, const nlohmann::detail::exception&)
+    {
+        LogError("glTF JSON syntax error at byte %zu near '%s'", position, lastToken);
+        return false;
+    }
+
+private:
+
+    bool number(double value);
+
+    void pushTableItem(table_t table);
+
+    document_t& doc_;
+
+    std::vector<frame_t> stack_;
+
+    std::string key_;
+
+};
+
+void saxHandler_t::pushTableItem(table_t table)
+{
+    switch (table)
+    {
+    case table_t::Buffers:
+        doc_.buffers.emplace_back();
+        break;
+    case table_t::BufferViews:
+        doc_.bufferViews.emplace_back();
+        break;
+    case table_t::Accessors:
+        doc_.accessors.emplace_back();
+        break;
+    case table_t::Images:
+        doc_.images.emplace_back();
+        break;
+    case table_t::Samplers:
+        doc_.samplers.emplace_back();
+        break;
+    case table_t::Textures:
+        doc_.textures.emplace_back();
+        break;
+    case table_t::Materials:
+        doc_.materials.emplace_back();
+        break;
+    case table_t::Meshes:
+        doc_.meshes.emplace_back();
+        break;
+    case table_t::Nodes:
+        doc_.nodes.emplace_back();
+        break;
+    case table_t::Scenes:
+        doc_.scenes.emplace_back();
+        break;
+    case table_t::None:
+        break;
+    }
+}
+
+bool saxHandler_t::start_object(std::size_t)
+{
+    if (stack_.empty()) {
+        stack_.push_back(frame_t{ context_t::Root });
+        return true;
+    }
+
+    const auto& parent = stack_.back();
+
+    frame_t frame{ context_t::Skip, parent.table, key_ };
+
+    switch (parent.context)
+    {
+    case context_t::Root:
+        if (key_ == "asset") {
+            frame.context = context_t::Asset;
+        }
+        break;
+    case context_t::Table:
+        pushTableItem(parent.table);
+        frame.context = context_t::Item;
+        break;
+    case context_t::Item:
+        if (parent.table == table_t::Materials) {
+            auto& material = doc_.materials.back();
+            if (key_ == "pbrMetallicRoughness") {
+                frame.context = context_t::PBR;
+            } else if (key_ == "normalTexture") {
+                frame.context = context_t::TextureRef;
+                frame.ref = &material.normalTexture;
+            } else if (key_ == "occlusionTexture") {
+                frame.context = context_t::TextureRef;
+                frame.ref = &material.occlusionTexture;
+            } else if (key_ == "emissiveTexture") {
+                frame.context = context_t::TextureRef;
+                frame.ref = &material.emissiveTexture;
+            }
+        }
+        break;
+    case context_t::PBR: {
+        auto& material = doc_.materials.back();
+        if (key_ == "baseColorTexture") {
+            frame.context = context_t::TextureRef;
+            frame.ref = &material.baseColorTexture;
+        } else if (key_ == "metallicRoughnessTexture") {
+            frame.context = context_t::TextureRef;
+            frame.ref = &material.metallicRoughnessTexture;
+        }
+    } break;
+    case context_t::Primitives:
+        doc_.meshes.back().primitives.emplace_back();
+        frame.context = context_t::Primitive;
+        break;
+    case context_t::Primitive:
+        if (key_ == "attributes") {
+            frame.context = context_t::Attributes;
+        }
+        break;
+    default:
+        break;
+    }
+
+    stack_.push_back(std::move(frame));
+    return true;
+}
+
+bool saxHandler_t::start_array(std::size_t)
+{
+    if (stack_.empty()) {
+        LogError("glTF JSON must be an object");
+        return false;
+    }
+
+    const auto& parent = stack_.back();
+
+    frame_t frame{ context_t::Skip, parent.table, key_ };
+
+    switch (parent.context)
+    {
+    case context_t::Root: {
+        static const std::pair<const char *, table_t> tables[] = {
+            { "buffers", table_t::Buffers },
+            { "bufferViews", table_t::BufferViews },
+            { "accessors", table_t::Accessors },
+            { "images", table_t::Images },
+            { "samplers", table_t::Samplers },
+            { "textures", table_t::Textures },
+            { "materials", table_t::Materials },
+            { "meshes", table_t::Meshes },
+            { "nodes", table_t::Nodes },
+            { "scenes", table_t::Scenes },
+        };
+
+        for (const auto& table : tables) {
+            if (key_ == table.first) {
+                frame.context = context_t::Table;
+                frame.table = table.second;
+                break;
+            }
+        }
+
+        if (key_ == "extensionsRequired") {
+            frame.context = context_t::Strings;
+            frame.strings = &doc_.extensionsRequired;
+        } else if (key_ == "extensionsUsed") {
+            frame.context = context_t::Strings;
+            frame.strings = &doc_.extensionsUsed;
+        }
+    } break;
+    case context_t::Item:
+        if (parent.table == table_t::Meshes && key_ == "primitives") {
+            frame.context = context_t::Primitives;
+        } else if ((parent.table == table_t::Nodes &&
+                (key_ == "children" || key_ == "translation" || key_ == "rotation" || key_ == "scale")) ||
+            (parent.table == table_t::Scenes && key_ == "nodes") ||
+            (parent.table == table_t::Materials && key_ == "emissiveFactor")) {
+            frame.context = context_t::Numbers;
+        }
+        break;
+    case context_t::PBR:
+        if (key_ == "baseColorFactor") {
+            frame.context = context_t::Numbers;
+        }
+        break;
+    default:
+        break;
+    }
+
+    stack_.push_back(std::move(frame));
+    return true;
+}
+
+bool saxHandler_t::end_array()
+{
+    frame_t frame = std::move(stack_.back());
+    stack_.pop_back();
+
+    if (frame.context != context_t::Numbers) {
+        return true;
+    }
+
+    const auto& v = frame.numbers;
+    const auto& key = frame.key;
+
+    auto toInts = [&v]() {
+        return std::vector<int>(v.begin(), v.end());
+    };
+
+    switch (frame.table)
+    {
+    case table_t::Nodes: {
+        auto& node = doc_.nodes.back();
+        if (key == "children") {
+            node.children = toInts();
+        } else if (key == "translation" && v.size() == 3) {
+            node.translation = glm::vec3(v[0], v[1], v[2]);
+        } else if (key == "rotation" && v.size() == 4) {
+            node.rotation = glm::quat((float)v[3], (float)v[0], (float)v[1], (float)v[2]);
+        } else if (key == "scale" && v.size() == 3) {
+            node.scale = glm::vec3(v[0], v[1], v[2]);
+        }
+    } break;
+    case table_t::Scenes:
+        doc_.scenes.back().nodes = toInts();
+        break;
+    case table_t::Materials: {
+        auto& material = doc_.materials.back();
+        if (key == "emissiveFactor" && v.size() == 3) {
+            material.emissiveFactor = glm::vec3(v[0], v[1], v[2]);
+        } else if (key == "baseColorFactor" && v.size() == 4) {
+            material.baseColorFactor = glm::vec4(v[0], v[1], v[2], v[3]);
+        }
+    } break;
+    default:
+        break;
+    }
+
+    return true;
+}
+
+bool saxHandler_t::number(double value)
+{
+    if (stack_.empty()) {
+        return false;
+    }
+
+    auto& top = stack_.back();
+
+    switch (top.context)
+    {
+    case context_t::Numbers:
+        top.numbers.push_back(value);
+        break;
+    case context_t::Root:
+        if (key_ == "scene") {
+            doc_.scene = (int)value;
+        }
+        break;
+    case context_t::Item:
+        switch (top.table)
+        {
+        case table_t::Buffers:
+            if (key_ == "byteLength") {
+                doc_.buffers.back().byteLength = (size_t)value;
+            }
+            break;
+        case table_t::BufferViews: {
+            auto& bufferView = doc_.bufferViews.back();
+            if (key_ == "buffer") {
+                bufferView.buffer = (int)value;
+            } else if (key_ == "byteLength") {
+                bufferView.byteLength = (size_t)value;
+            } else if (key_ == "byteOffset") {
+                bufferView.byteOffset = (size_t)value;
+            } else if (key_ == "byteStride") {
+                bufferView.byteStride = (size_t)value;
+            } else if (key_ == "target") {
+                bufferView.target = (GLenum)value;
+            }
+        } break;
+        case table_t::Accessors: {
+            auto& accessor = doc_.accessors.back();
+            if (key_ == "bufferView") {
+                accessor.bufferView = (int)value;
+            } else if (key_ == "byteOffset") {
+                accessor.byteOffset = (size_t)value;
+            } else if (key_ == "componentType") {
+                accessor.componentType = (GLenum)value;
+            } else if (key_ == "count") {
+                accessor.count = (size_t)value;
+            }
+        } break;
+        case table_t::Images:
+            if (key_ == "bufferView") {
+                doc_.images.back().bufferView = (int)value;
+            }
+            break;
+        case table_t::Samplers: {
+            auto& sampler = doc_.samplers.back();
+            if (key_ == "magFilter") {
+                sampler.MagFilter = (GLenum)value;
+            } else if (key_ == "minFilter") {
+                sampler.MinFilter = (GLenum)value;
+            } else if (key_ == "wrapS") {
+                sampler.WrapS = (GLenum)value;
+            } else if (key_ == "wrapT") {
+                sampler.WrapT = (GLenum)value;
+            }
+        } break;
+        case table_t::Textures: {
+            auto& texture = doc_.textures.back();
+            if (key_ == "sampler") {
+                texture.sampler = (int)value;
+            } else if (key_ == "source") {
+                texture.source = (int)value;
+            }
+        } break;
+        case table_t::Materials:
+            if (key_ == "alphaCutoff") {
+                doc_.materials.back().alphaCutoff = (float)value;
+            }
+            break;
+        case table_t::Nodes: {
+            auto& node = doc_.nodes.back();
+            if (key_ == "mesh") {
+                node.mesh = (int)value;
+            } else if (key_ == "camera") {
+                node.camera = (int)value;
+            }
+        } break;
+        default:
+            break;
+        }
+        break;
+    case context_t::PBR: {
+        auto& material = doc_.materials.back();
+        if (key_ == "metallicFactor") {
+            material.metallicFactor = (float)value;
+        } else if (key_ == "roughnessFactor") {
+            material.roughnessFactor = (float)value;
+        }
+    } break;
+    case context_t::TextureRef:
+        if (key_ == "index") {
+            top.ref->index = (int)value;
+        } else if (key_ == "texCoord") {
+            top.ref->texCoord = (int)value;
+        } else if ((key_ == "scale" && top.key == "normalTexture") ||
+            (key_ == "strength" && top.key == "occlusionTexture")) {
+            top.ref->scale = (float)value;
+        }
+        break;
+    case context_t::Primitive: {
+        auto& primitive = doc_.meshes.back().primitives.back();
+        if (key_ == "indices") {
+            primitive.indices = (int)value;
+        } else if (key_ == "material") {
+            primitive.material = (int)value;
+        } else if (key_ == "mode") {
+            primitive.mode = (GLenum)value;
+        }
+    } break;
+    case context_t::Attributes:
+        doc_.meshes.back().primitives.back().attributes.emplace_back(key_, (int)value);
+        break;
+    default:
+        break;
+    }
+
+    return true;
+}
+
+bool saxHandler_t::string(json::string_t& value)
+{
+    if (stack_.empty()) {
+        return false;
+    }
+
+    auto& top = stack_.back();
+
+    switch (top.context)
+    {
+    case context_t::Asset:
+        if (key_ == "version") {
+            doc_.version = std::move(value);
+        } else if (key_ == "generator") {
+            doc_.generator = std::move(value);
+        }
+        break;
+    case context_t::Strings:
+        top.strings->push_back(std::move(value));
+        break;
+    case context_t::Item:
+        // Strings are moved out of the parser, data: URIs can be huge
+        if (key_ == "name") {
+            if (top.table == table_t::Materials) {
+                doc_.materials.back().name = std::move(value);
+            } else if (top.table == table_t::Meshes) {
+                doc_.meshes.back().name = std::move(value);
+            } else if (top.table == table_t::Nodes) {
+                doc_.nodes.back().name = std::move(value);
+            }
+        } else if (top.table == table_t::Buffers && key_ == "uri") {
+            doc_.buffers.back().uri = std::move(value);
+        } else if (top.table == table_t::Materials && key_ == "alphaMode") {
+            doc_.materials.back().alphaMode = std::move(value);
+        } else if (top.table == table_t::Images && key_ == "uri") {
+            doc_.images.back().uri = std::move(value);
+        } else if (top.table == table_t::Images && key_ == "mimeType") {
+            doc_.images.back().mimeType = std::move(value);
+        } else if (top.table == table_t::Accessors && key_ == "type") {
+            doc_.accessors.back().type = std::move(value);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return true;
+}
+
+bool parseDocumentSAX(const char * begin, const char * end, document_t& doc)
+{
+    saxHandler_t handler(doc);
+    return json::sax_parse(begin, end, &handler);
+}
+
+} // namespace glTF2
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <Texture.hpp>
+
+#include <depend/OpenGL.hpp>
+#include <depend/Math.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace glTF2 {
+
+// Typed tables of everything the loader uses from a glTF's JSON. They are
+// filled either from a DOM or directly from SAX events.
+
+struct buffer_desc_t {
+    std::string uri;
+    size_t byteLength = 0;
+};
+
+struct bufferView_t {
+    int buffer = -1;
+    size_t byteLength = 0;
+    size_t byteOffset = 0;
+    size_t byteStride = 0;
+    GLenum target = GL_INVALID_ENUM;
+};
+
+struct accessor_t {
+    int bufferView = -1;
+    std::string type;
+    size_t byteOffset = 0;
+    GLenum componentType = GL_INVALID_ENUM;
+    bool normalized = false;
+    size_t count = 0;
+    // TODO: min, max
+};
+
+struct image_desc_t {
+    std::string uri;
+    int bufferView = -1;
+    std::string mimeType;
+};
+
+struct texture_desc_t {
+    int sampler = -1;
+    int source = -1;
+};
+
+struct textureRef_t {
+    int index = -1;
+    int texCoord = 0;
+
+    // normalTexture.scale or occlusionTexture.strength
+    float scale = 1.f;
+};
+
+struct material_t {
+    std::string name;
+
+    glm::vec4 baseColorFactor = glm::vec4(1.f);
+    textureRef_t baseColorTexture;
+
+    float metallicFactor = 1.f;
+    float roughnessFactor = 1.f;
+    textureRef_t metallicRoughnessTexture;
+
+    textureRef_t normalTexture;
+    textureRef_t occlusionTexture;
+
+    glm::vec3 emissiveFactor = glm::vec3(0.f);
+    textureRef_t emissiveTexture;
+
+    // OPAQUE, MASK or BLEND, alphaCutoff only applies to MASK
+    std::string alphaMode = "OPAQUE";
+    float alphaCutoff = 0.5f;
+};
+
+struct primitive_t {
+    // Attribute name, accessor index
+    std::vector<std::pair<std::string, int>> attributes;
+    int indices = -1;
+    int material = -1;
+    GLenum mode = GL_TRIANGLES;
+};
+
+struct mesh_t {
+    std::string name;
+    std::vector<primitive_t> primitives;
+};
+
+struct node_t {
+    std::string name;
+    int mesh = -1;
+    int camera = -1;
+    std::vector<int> children;
+
+    glm::vec3 translation = glm::vec3(0.f);
+    glm::quat rotation = glm::quat(1.f, 0.f, 0.f, 0.f);
+    glm::vec3 scale = glm::vec3(1.f);
+};
+
+struct scene_t {
+    std::vector<int> nodes;
+};
+
+struct document_t {
+    std::string version;
+    std::string generator;
+
+    std::vector<std::string> extensionsRequired;
+    std::vector<std::string> extensionsUsed;
+
+    int scene = 0;
+
+    std::vector<buffer_desc_t> buffers;
+    std::vector<bufferView_t> bufferViews;
+    std::vector<accessor_t> accessors;
+    std::vector<image_desc_t> images;
+    std::vector<Texture::Options> samplers;
+    std::vector<texture_desc_t> textures;
+    std::vector<material_t> materials;
+    std::vector<mesh_t> meshes;
+    std::vector<node_t> nodes;
+    std::vector<scene_t> scenes;
+};
+
+// Builds a full nlohmann DOM first and walks it
+bool parseDocumentDOM(const char * begin, const char * end, document_t& doc);
+
+// Fills the tables straight from SAX events, no DOM is ever built
+bool parseDocumentSAX(const char * begin, const char * end, document_t& doc);
+
+} // namespace glTF2
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <glTF2.hpp>
+#include <glTF2Document.hpp>
+
+#include <GeometryArena.hpp>
+#include <ImageDecoder.hpp>
+#include <MappedFile.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace glTF2 {
+
+// The CPU side loading phases, shared by LoadPrimitivesFromFile and the
+// benchmarks. None of them touch GL.
+
+// Read-only view into a mapped file or a block owned by storage_t
+struct buffer_t {
+    const uint8_t * data;
+    size_t size;
+};
+
+// Owns everything the buffer_t views of a single glTF point into
+struct storage_t {
+    std::vector<std::unique_ptr<MappedFile>> files;
+    std::vector<std::vector<uint8_t>> blocks;
+};
+
+bool readFile(const std::string& filename, storage_t& storage, const Options& opts, buffer_t& out);
+
+// Validates the GLB container or plain JSON in file and fills doc, the BIN
+// chunk of a GLB is returned in binChunks
+bool parseFile(
+    const std::string& filename, 
+    const buffer_t& file, 
+    const Options& opts, 
+    document_t& doc, 
+    std::vector<buffer_t>& binChunks);
+
+// Decodes data: URIs and reads external files, indices match doc.buffers
+std::vector<buffer_t> loadBuffers(
+    const document_t& doc, 
+    const std::string& dir, 
+    const std::vector<buffer_t>& binChunks,
+    storage_t& storage,
+    const Options& opts);
+
+// Starts decoding every image on the job system, except those flagged in
+// skip which are left empty
+std::unique_ptr<ImageDecoder> loadImages(
+    const document_t& doc, 
+    const std::string& dir, 
+    const std::vector<buffer_t>& buffers,
+    const Options& opts,
+    const std::vector<bool>& skip = {});
+
+// Converts the primitive to the GeometryArena vertex layout
+bool buildArenaPrimitive(
+    const primitive_t& primitive,
+    const accessor_t& indexAccessor,
+    const std::vector<bufferView_t>& bufferViews, 
+    const std::vector<buffer_t>& buffers,
+    const std::vector<accessor_t>& accessors,
+    std::vector<GeometryArena::Vertex>& vertices,
+    std::vector<uint32_t>& indices);
+
+} // namespace glTF2